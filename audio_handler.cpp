@@ -1,5 +1,6 @@
 #include "audio_handler.h"
 #include "wifi_manager.h"
+#include "trace.h"
 
 #define AUDIO_FILES_COUNT (sizeof(audioFiles)/sizeof(audioFiles[0]))
 
@@ -14,6 +15,11 @@ String audioFiles[] = {
 
 Audio *audio = nullptr;
 bool audioInitialized = false;
+bool sdCardMounted = false;
+
+// chỉ số file cần phát, AUDIO_REQUEST_STOP để dừng
+#define AUDIO_REQUEST_STOP -1
+static QueueHandle_t audioRequestQueue = NULL;
 
 void initializeSDCard() {
     SPI.begin(SPI_SCK, SPI_MISO, SPI_MOSI, SD_CS);
@@ -28,9 +34,15 @@ void initializeSDCard() {
         Serial.println("[SD] No SD card attached");
         return;
     }
+    
+    sdCardMounted = true;
 }
 
 void initializeAudio() {
+    if (audioRequestQueue == NULL) {
+        audioRequestQueue = xQueueCreate(AUDIO_REQUEST_QUEUE, sizeof(int));
+    }
+    
     if (audio == nullptr) {
         audio = new Audio();
         if (audio) {
@@ -82,8 +94,27 @@ void stopAudio() {
     }
 }
 
+void requestAudio(int audioIndex) {
+    if (audioRequestQueue == NULL) return;
+    xQueueSend(audioRequestQueue, &audioIndex, 0);
+}
+
+void requestAudioStop() {
+    requestAudio(AUDIO_REQUEST_STOP);
+}
+
 void handleAudioLoop() {
+    int request;
+    while (audioRequestQueue != NULL && xQueueReceive(audioRequestQueue, &request, 0) == pdTRUE) {
+        if (request == AUDIO_REQUEST_STOP) {
+            stopAudio();
+        } else {
+            playAudio(request);
+        }
+    }
+    
     if (audioInitialized && audio) {
+        TraceSpan span(TRACE_AUDIO);
         audio->loop();
     }
 }
@@ -6,6 +6,7 @@
 extern String audioFiles[];
 
 extern Audio *audio;
+extern bool sdCardMounted;
 
 void initializeAudio();
 void initializeSDCard();
@@ -14,4 +15,8 @@ void handleAudioLoop();
 bool isAudioPlaying();
 void stopAudio();
 
+// Task khác loop (SensorTask) chỉ xếp yêu cầu, handleAudioLoop thực hiện
+void requestAudio(int audioIndex);
+void requestAudioStop();
+
 #endif
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "blynk_handler.h"
 #include "wifi_manager.h"
 #include "security_system.h"
+#include "trace.h"
 #include <BlynkSimpleEsp32.h>
 
 Servo servo1, servo2;
@@ -27,6 +28,7 @@ const int SERVO_SPEED_MS = 60;
 BlynkTimer servoTimer;
 
 static bool blynkInitialized = false;
+static volatile bool blynkInitRequested = false;
 static unsigned long lastBlynkReconnectAttempt = 0;
 static const unsigned long BLYNK_RECONNECT_INTERVAL = 30000;
 
@@ -43,6 +45,12 @@ void initializeBlynk() {
     }
 }
 
+// Gọi từ loop task khi Wi-Fi STA kết nối: Blynk chỉ được chạm tới từ NetTask,
+// nên việc khởi tạo được dời sang lần handleBlynkLoop kế tiếp
+void requestBlynkInit() {
+    blynkInitRequested = true;
+}
+
 void initializeServos() {
     servo1.setPeriodHertz(50); 
     servo2.setPeriodHertz(50);
@@ -141,6 +149,14 @@ void handleBlynkLoop()
 {
     if(wifiState == WIFI_STA_OK && WiFi.status() == WL_CONNECTED) 
     {
+        if (blynkInitRequested) 
+        {
+            blynkInitRequested = false;
+            if (!blynkInitialized) initializeBlynk();
+        }
+        if (!blynkInitialized) return;
+        
+        TraceSpan span(TRACE_BLYNK);
         if (!Blynk.connected()) 
         {
             reconnectBlynk();
@@ -190,28 +206,9 @@ BLYNK_WRITE(V_EMERGENCY_UNLOCK) {
     }
 }
 
+// Chạy trong NetTask (Blynk.run): chuỗi mở khóa do máy trạng thái thực hiện
 void handleEmergencyUnlock() {
-    Serial.println("[EMERGENCY] Executing unlock sequence");
-    
-    extern bool isAudioPlaying();
-    extern void stopAudio();
-    
-    if (isAudioPlaying()) {
-        stopAudio();
-        vTaskDelay(pdMS_TO_TICKS(100));
-    }
-    
-    sendNodeCommand("buzzer", "off");
-    vTaskDelay(pdMS_TO_TICKS(100));
-    
-    sendNodeCommand("lock", "unlock");
-    vTaskDelay(pdMS_TO_TICKS(100));
-    
-    if (currentSecurityState != SECURITY_IDLE) {
-        resetSecurityState();
-    }
-    
-    Serial.println("[EMERGENCY] Unlock completed");
+    postSecurityEvent(SECURITY_EVT_EMERGENCY_UNLOCK);
     
     if (Blynk.connected()) {
         Blynk.logEvent("emergency_unlock", "Door unlocked. Auto-lock in 30s");
@@ -4,6 +4,7 @@
 #include "config.h"
 
 void initializeBlynk();
+void requestBlynkInit();
 void handleBlynkLoop();
 void initializeServos();
 void handleServoLoop();
@@ -1,26 +1,48 @@
 #include "camera_handler.h"
 #include "web_server.h"
+#include "event_buffer.h"
+#include "substream.h"
+#include "metrics.h"
+#include "trace.h"
 
-uint8_t* mjpeg_buf_a = nullptr;
-uint8_t* mjpeg_buf_b = nullptr;
-volatile size_t frame_len_a = 0;
-volatile size_t frame_len_b = 0;
-volatile bool frame_ready_a = false;
-volatile bool frame_ready_b = false;
-volatile bool use_buf_a = true;
 portMUX_TYPE frameMux = portMUX_INITIALIZER_UNLOCKED;
 
 uint8_t* payload_buf_a = nullptr;
 uint8_t* payload_buf_b = nullptr;
 uint8_t* frame_buf = nullptr;
-uint32_t frame_cnt_recv = 0;
-uint32_t frame_cnt_sent = 0;
 
 USB_STREAM* uvc = nullptr;
 bool uvcStarted = false;
 
+const camera_profile_t cameraProfiles[] = {
+    { "qvga",   320, 240, 333333 },     // 30 fps
+    { "vga",    640, 480, 666666 },     // 15 fps
+    { "svga",   800, 600, 1000000 },    // 10 fps
+    { "svga30", 800, 600, 333333 },     // 30 fps
+};
+const int cameraProfileCount = sizeof(cameraProfiles) / sizeof(cameraProfiles[0]);
+
+// profile chọn qua HTTP/MQTT, dùng khi không stream client nào yêu cầu profile riêng
+static int configuredProfile = CAMERA_DEFAULT_PROFILE;
+static volatile int activeProfile = CAMERA_DEFAULT_PROFILE;
+static int profileRequests[sizeof(cameraProfiles) / sizeof(cameraProfiles[0])] = {};
+
+// frame nén lớn nhất đã thấy ở mỗi profile, để chỉnh USB_FRAME_BUF_SIZE theo thực tế
+static uint32_t profilePeakBytes[sizeof(cameraProfiles) / sizeof(cameraProfiles[0])] = {};
+
 static bool streaming_started = false;
-static TaskHandle_t clientProcessorHandle = NULL;
+
+// consumer của camera: stream client, snapshot, phân tích chuyển động
+static int cameraConsumers = 0;
+static bool cameraKeepAlive = false;       // chạy nền kể cả khi không có consumer
+static unsigned long cameraIdleSince = 0;
+static portMUX_TYPE consumerMux = portMUX_INITIALIZER_UNLOCKED;
+
+// đo thời gian từ uvc->start() tới frame đầu tiên
+static unsigned long uvcStartTime = 0;
+static volatile bool awaitingFirstFrame = false;
+static volatile unsigned long coldStartMs = 0;
+static bool coldStartPending = false;
 
 void initializeBuffers() 
 {
@@ -29,16 +51,19 @@ void initializeBuffers()
         while(true) vTaskDelay(pdMS_TO_TICKS(1000));
     }
     
-    mjpeg_buf_a = (uint8_t*)heap_caps_malloc(MJPEG_BUF_SIZE, MALLOC_CAP_SPIRAM);
-    mjpeg_buf_b = (uint8_t*)heap_caps_malloc(MJPEG_BUF_SIZE, MALLOC_CAP_SPIRAM);
+    // trace không bắt buộc: thiếu PSRAM thì chỉ tắt /trace
+    initializeTrace();
+    
+    bool poolReady = framePool.begin(FRAME_POOL_SLOTS, MJPEG_BUF_SIZE);
+    bool eventReady = initializeEventBuffer();
+    bool subReady = initializeSubstream();
     payload_buf_a = (uint8_t*)heap_caps_malloc(USB_PAYLOAD_BUF_SIZE, MALLOC_CAP_SPIRAM);
     payload_buf_b = (uint8_t*)heap_caps_malloc(USB_PAYLOAD_BUF_SIZE, MALLOC_CAP_SPIRAM);
     frame_buf = (uint8_t*)heap_caps_malloc(USB_FRAME_BUF_SIZE, MALLOC_CAP_SPIRAM);
     
-    if(!mjpeg_buf_a || !mjpeg_buf_b || !payload_buf_a || !payload_buf_b || !frame_buf) 
+    if(!poolReady || !eventReady || !subReady || !payload_buf_a || !payload_buf_b || !frame_buf) 
     {
-        free(mjpeg_buf_a);
-        free(mjpeg_buf_b);
+        framePool.end();
         free(payload_buf_a);
         free(payload_buf_b);
         free(frame_buf);
@@ -46,10 +71,15 @@ void initializeBuffers()
     }
 }
 
+// USB_STREAM ghép frame vào một frame_buf cố định và ghi đè ngay sau khi
+// frame_cb trả về, driver không nhận buffer ngoài nên vẫn phải copy một lần
+// sang slot của pool. Slot chỉ cần bằng frame_buf (MJPEG_BUF_SIZE).
 void initializeCamera() 
 {
+    const camera_profile_t& profile = cameraProfiles[activeProfile];
+    
     uvc = new USB_STREAM();
-    uvc->uvcConfiguration(FRAME_WIDTH, FRAME_HEIGHT, FRAME_INTERVAL,
+    uvc->uvcConfiguration(profile.width, profile.height, profile.interval,
                          USB_PAYLOAD_BUF_SIZE, payload_buf_a, payload_buf_b,
                          USB_FRAME_BUF_SIZE, frame_buf);
     uvc->uvcCamRegisterCb(frame_cb, nullptr);
@@ -58,107 +88,272 @@ void initializeCamera()
 //hàm nãy sẽ được gọi khi có frame mưới được nhận
 void frame_cb(uvc_frame_t* frame, void*) 
 {
+    TraceSpan span(TRACE_FRAME_CB);
     if (!frame || !frame->data || frame->data_bytes == 0) return;
-    if (frame->data_bytes > MJPEG_BUF_SIZE || frame->data_bytes < 2000) return;
     
-    frame_cnt_recv++;
+    metricInc(MET_FRAMES_RECEIVED);
+    if (frame->data_bytes > MJPEG_BUF_SIZE || frame->data_bytes < 2000) 
+    {
+        metricInc(MET_FRAMES_DROPPED_SIZE);
+        return;
+    }
     
-    //double buffering
-    portENTER_CRITICAL_ISR(&frameMux);
-    if (use_buf_a && !frame_ready_a) 
+    // frame UVC bị cắt (thiếu EOI) hiển thị thành vệt xám: loại trước khi chiếm slot
+    jpeg_info_t info;
+    if (!jpegScan(frame->data, frame->data_bytes, &info)) 
     {
-        memcpy(mjpeg_buf_a, frame->data, frame->data_bytes);
-        frame_len_a = frame->data_bytes;
-        frame_ready_a = true;
-        use_buf_a = false;
-    } 
-    else if (!use_buf_a && !frame_ready_b) 
+        metricInc(MET_FRAMES_DROPPED_CORRUPT);
+        return;
+    }
+    
+    int profile = activeProfile;
+    if (frame->data_bytes > profilePeakBytes[profile]) profilePeakBytes[profile] = frame->data_bytes;
+    
+    if (awaitingFirstFrame) 
+    {
+        coldStartMs = millis() - uvcStartTime;
+        awaitingFirstFrame = false;
+    }
+    
+    // mỗi frame chỉ copy một lần vào pool, mọi client dùng chung slot
+    frame_slot_t* slot = framePool.acquireWrite();
+    if (!slot) 
     {
-        memcpy(mjpeg_buf_b, frame->data, frame->data_bytes);
-        frame_len_b = frame->data_bytes;
-        frame_ready_b = true;
-        use_buf_a = true;
+        metricInc(MET_FRAMES_DROPPED_BUSY);
+        return;
     }
-    portEXIT_CRITICAL_ISR(&frameMux);
+    
+    // slot thuộc riêng producer nên copy ngoài critical section,
+    // publish() chỉ đổi con trỏ latest + seq
+    uint32_t copyStart = ESP.getCycleCount();
+    memcpy(slot->data, frame->data, frame->data_bytes);
+    metricObserveCycles(MET_HIST_FRAME_COPY, copyStart);
+    slot->info = info;
+    framePool.publish(slot, frame->data_bytes);
 }
 
-void clientProcessorTask(void *pvParameters) {
-    stream_client_t* streamClient;
+static void startCamera() {
+    if (uvcStarted || uvc == nullptr) return;
     
-    while (true) {
-        if (xQueueReceive(clientQueue, &streamClient, portMAX_DELAY) == pdTRUE) {
-            extern TaskHandle_t streamTaskHandle[MAX_CLIENTS];
-            int taskSlot = -1;
-            for (int i = 0; i < MAX_CLIENTS; i++) {
-                if (streamTaskHandle[i] == NULL) {
-                    taskSlot = i;
-                    break;
-                }
-            }
-            
-            if (taskSlot != -1) {
-                String taskName = "StreamTask" + String(taskSlot);
-                xTaskCreatePinnedToCore(
-                    stream_task,
-                    taskName.c_str(),
-                    8192,
-                    streamClient,
-                    2,
-                    &streamTaskHandle[taskSlot],
-                    1
-                );
-            } else {
-                streamClient->client.stop();
-                delete streamClient;
-            }
-        }
+    Serial.println("[CAMERA] Starting UVC");
+    uvcStartTime = millis();
+    awaitingFirstFrame = true;
+    coldStartPending = true;
+    uvc->start();
+    uvcStarted = true;
+}
+
+static void stopCamera() {
+    if (!uvcStarted || uvc == nullptr) return;
+    
+    uvc->stop();
+    uvcStarted = false;
+    awaitingFirstFrame = false;
+    vTaskDelay(pdMS_TO_TICKS(100));
+    
+    // frame cũ không còn hợp lệ sau khi camera tắt: chỉ bỏ tham chiếu của pool,
+    // reader đang giữ FrameRef vẫn tự release slot của mình
+    framePool.invalidate();
+}
+
+// Chỉ gọi từ loop task (handler web server), start/stop UVC đều chạy ở đây
+void cameraAcquire() {
+    portENTER_CRITICAL(&consumerMux);
+    cameraConsumers++;
+    portEXIT_CRITICAL(&consumerMux);
+    
+    startCamera();
+}
+
+// Consumer chạy trong task khác loop (RTSP): chỉ tăng bộ đếm, UVC được
+// bật ở lần handleCameraLoop kế tiếp
+void cameraAcquireFromTask() {
+    portENTER_CRITICAL(&consumerMux);
+    cameraConsumers++;
+    portEXIT_CRITICAL(&consumerMux);
+}
+
+// Giữ UVC chạy liên tục (pre-roll của event buffer): handleCameraLoop bật
+// camera ở lần kế tiếp và không tắt vì idle cho tới khi bỏ keep-alive.
+// Không phải một consumer nên không ảnh hưởng bộ đếm của consumer khác.
+void cameraSetKeepAlive(bool on) {
+    portENTER_CRITICAL(&consumerMux);
+    bool changed = (cameraKeepAlive != on);
+    cameraKeepAlive = on;
+    if (!on) cameraIdleSince = millis();
+    portEXIT_CRITICAL(&consumerMux);
+
+    if (changed) Serial.printf("[CAMERA] Keep-alive %s\n", on ? "on" : "off");
+}
+
+// Có thể gọi từ task khác, camera chỉ tắt sau CAMERA_IDLE_GRACE_MS trong handleCameraLoop
+void cameraRelease() {
+    portENTER_CRITICAL(&consumerMux);
+    if (cameraConsumers > 0) cameraConsumers--;
+    if (cameraConsumers == 0) cameraIdleSince = millis();
+    portEXIT_CRITICAL(&consumerMux);
+}
+
+int findCameraProfile(const char* name) {
+    for (int i = 0; i < cameraProfileCount; i++) 
+    {
+        if (strcmp(cameraProfiles[i].name, name) == 0) return i;
     }
+    return -1;
 }
 
-void start_stream_if_needed() {
-    if(!uvcStarted) {
-        uvc->start();
-        uvcStarted = true;
+bool setCameraProfile(int index) {
+    if (index < 0 || index >= cameraProfileCount) return false;
+    
+    configuredProfile = index;
+    Serial.printf("[CAMERA] Profile set to %s\n", cameraProfiles[index].name);
+    return true;
+}
+
+int configuredCameraProfile() {
+    return configuredProfile;
+}
+
+int activeCameraProfile() {
+    return activeProfile;
+}
+
+// Client yêu cầu profile riêng (/stream?profile=). Camera chạy ở profile lớn
+// nhất đang được yêu cầu, client không yêu cầu nhận profile đang chạy.
+void cameraRequestProfile(int index) {
+    if (index < 0 || index >= cameraProfileCount) return;
+    
+    portENTER_CRITICAL(&consumerMux);
+    profileRequests[index]++;
+    portEXIT_CRITICAL(&consumerMux);
+}
+
+void cameraReleaseProfile(int index) {
+    if (index < 0 || index >= cameraProfileCount) return;
+    
+    portENTER_CRITICAL(&consumerMux);
+    if (profileRequests[index] > 0) profileRequests[index]--;
+    portEXIT_CRITICAL(&consumerMux);
+}
+
+uint32_t cameraProfilePeakBytes(int index) {
+    if (index < 0 || index >= cameraProfileCount) return 0;
+    return profilePeakBytes[index];
+}
+
+static int wantedProfile() {
+    int wanted = -1;
+    uint32_t wantedPixels = 0;
+    
+    portENTER_CRITICAL(&consumerMux);
+    for (int i = 0; i < cameraProfileCount; i++) 
+    {
+        uint32_t pixels = (uint32_t)cameraProfiles[i].width * cameraProfiles[i].height;
+        if (profileRequests[i] > 0 && (wanted < 0 || pixels > wantedPixels)) 
+        {
+            wanted = i;
+            wantedPixels = pixels;
+        }
     }
+    portEXIT_CRITICAL(&consumerMux);
     
-    if (!streaming_started) {
-        clientQueue = xQueueCreate(MAX_CLIENTS, sizeof(stream_client_t*));
-        for (int i = 0; i < MAX_CLIENTS; i++) streamTaskHandle[i] = NULL;
-        
-        xTaskCreatePinnedToCore(clientProcessorTask, "ClientProcessor", 4096, NULL, 3, &clientProcessorHandle, 1);
-        streaming_started = true;
+    return wanted < 0 ? configuredProfile : wanted;
+}
+
+// Đổi độ phân giải/FPS của UVC. Đang chạy thì suspend -> reset -> resume,
+// chưa chạy thì cấu hình lại cho lần start() tới. Buffer không đổi vì frame
+// nén luôn nằm trong USB_FRAME_BUF_SIZE.
+static void applyCameraProfile(int index) {
+    const camera_profile_t& profile = cameraProfiles[index];
+    
+    if (uvcStarted) 
+    {
+        uvc->uvcCamSuspend(NULL);
+        uvc->uvcCamFrameReset(profile.width, profile.height, profile.interval);
+        uvc->uvcCamResume(NULL);
+    } 
+    else 
+    {
+        uvc->uvcConfiguration(profile.width, profile.height, profile.interval,
+                             USB_PAYLOAD_BUF_SIZE, payload_buf_a, payload_buf_b,
+                             USB_FRAME_BUF_SIZE, frame_buf);
     }
+    
+    activeProfile = index;
+    Serial.printf("[CAMERA] Switched to %s (%ux%u @ %u fps)\n", profile.name,
+                  profile.width, profile.height, 10000000 / profile.interval);
 }
 
-void stop_stream_if_needed() {
-    if (!streaming_started) return;
+void handleCameraLoop() {
+    static unsigned long lastStatsPrint = 0;
     
-    Serial.println("[CAMERA] Stopping stream");
+    if (uvc == nullptr) return;
+    
+    int wanted = wantedProfile();
+    if (wanted != activeProfile) applyCameraProfile(wanted);
     
-    if(uvcStarted && uvc != nullptr) {
-        uvc->stop();
-        uvcStarted = false; 
-        vTaskDelay(pdMS_TO_TICKS(100));
+    if (!uvcStarted) 
+    {
+        portENTER_CRITICAL(&consumerMux);
+        bool pending = cameraConsumers > 0 || cameraKeepAlive;
+        portEXIT_CRITICAL(&consumerMux);
+        
+        if (pending) startCamera();
+        return;
     }
     
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (streamTaskHandle[i] != NULL) {
-            vTaskDelete(streamTaskHandle[i]);
-            streamTaskHandle[i] = NULL;
-        }
+    if (coldStartPending && !awaitingFirstFrame) 
+    {
+        coldStartPending = false;
+        Serial.printf("[CAMERA] Cold start: first frame after %lu ms\n", coldStartMs);
     }
     
-    if (clientProcessorHandle != NULL) {
-        vTaskDelete(clientProcessorHandle);
-        clientProcessorHandle = NULL;
+    portENTER_CRITICAL(&consumerMux);
+    bool idle = (cameraConsumers == 0) && !cameraKeepAlive &&
+                (millis() - cameraIdleSince > CAMERA_IDLE_GRACE_MS);
+    portEXIT_CRITICAL(&consumerMux);
+    
+    if (idle) 
+    {
+        Serial.println("[CAMERA] No consumers, stopping UVC");
+        stopCamera();
+        return;
+    }
+    
+    if (millis() - lastStatsPrint < CAMERA_STATS_INTERVAL) return;
+    lastStatsPrint = millis();
+    
+    uint32_t critCycles = framePool.takeMaxCritCycles();
+    Serial.printf("[CAMERA] recv=%u sent=%u dropped=%u corrupt=%u crit_max=%uus\n",
+                  metricCount(MET_FRAMES_RECEIVED), metricCount(MET_FRAMES_SENT),
+                  metricCount(MET_FRAMES_DROPPED_BUSY), metricCount(MET_FRAMES_DROPPED_CORRUPT),
+                  critCycles / ESP.getCpuFreqMHz());
+}
+
+// Chỉ khởi tạo hạ tầng stream, UVC bật khi có consumer (cameraAcquire)
+void start_stream_if_needed() {
+    if (!streaming_started || streamTaskHandle == NULL) {
+        if (clientQueue == NULL) {
+            clientQueue = xQueueCreate(MAX_CLIENTS, sizeof(stream_client_t*));
+        }
+        
+        streaming_started = startStreamTask();
     }
+}
+
+void stop_stream_if_needed() {
+    if (!streaming_started) return;
+    
+    Serial.println("[CAMERA] Stopping stream");
+    
+    stopStreamTask();
     
     if (clientQueue != NULL) {
         stream_client_t* streamClient;
         while(xQueueReceive(clientQueue, &streamClient, 0) == pdTRUE) {
             if (streamClient != nullptr) {
                 streamClient->client.stop();
-                delete streamClient;
+                releaseStreamClient(streamClient);
             }
         }
         
@@ -166,12 +361,9 @@ void stop_stream_if_needed() {
         clientQueue = NULL;
     }
     
-    portENTER_CRITICAL(&frameMux);
-    frame_ready_a = false;
-    frame_ready_b = false;
-    use_buf_a = true;
-    portEXIT_CRITICAL(&frameMux);
-    
+    // client stream đã nhả camera qua releaseStreamClient; consumer khác (event
+    // buffer, RTSP, motion) vẫn giữ phần của mình, UVC tắt ở handleCameraLoop
+    // khi bộ đếm về 0
     streaming_started = false;
     Serial.println("[CAMERA] Stream stopped");
 }
\ No newline at end of file
@@ -2,31 +2,45 @@
 #define CAMERA_HANDLER_H
 
 #include "config.h"
+#include "frame_pool.h"
+
+typedef struct {
+    const char* name;
+    uint16_t width;
+    uint16_t height;
+    uint32_t interval;      // đơn vị 100ns như FRAME_INTERVAL của UVC
+} camera_profile_t;
+
+extern const camera_profile_t cameraProfiles[];
+extern const int cameraProfileCount;
 
 extern USB_STREAM* uvc;
 extern bool uvcStarted;
 
-extern uint8_t* mjpeg_buf_a;
-extern uint8_t* mjpeg_buf_b;
-extern volatile size_t frame_len_a;
-extern volatile size_t frame_len_b;
-extern volatile bool frame_ready_a;
-extern volatile bool frame_ready_b;
-extern volatile bool use_buf_a;
 extern portMUX_TYPE frameMux;
 
 extern uint8_t* payload_buf_a;
 extern uint8_t* payload_buf_b;
 extern uint8_t* frame_buf;
-extern uint32_t frame_cnt_recv;
-extern uint32_t frame_cnt_sent;
 
 void initializeBuffers();
 void initializeCamera();
 void frame_cb(uvc_frame_t* frame, void*);
+void cameraAcquire();
+void cameraAcquireFromTask();
+void cameraRelease();
+void cameraSetKeepAlive(bool on);
 void start_stream_if_needed();
 void stop_stream_if_needed();
-void clientProcessorTask(void *pvParameters);
+void handleCameraLoop();
+
+int findCameraProfile(const char* name);
+bool setCameraProfile(int index);
+int configuredCameraProfile();
+int activeCameraProfile();
+void cameraRequestProfile(int index);
+void cameraReleaseProfile(int index);
+uint32_t cameraProfilePeakBytes(int index);
 
 
 #endif
\ No newline at end of file
@@ -10,6 +10,7 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <freertos/queue.h>
+#include <freertos/event_groups.h>
 #include <SPI.h>
 #include <SD.h>
 #include "Audio.h"
@@ -18,12 +19,38 @@
 
 #define MDNS_HOSTNAME "cameraiuh"
 
-#define FRAME_WIDTH 800
-#define FRAME_HEIGHT 600
-#define FRAME_INTERVAL 333333
-#define MJPEG_BUF_SIZE (FRAME_WIDTH * FRAME_HEIGHT * 2)
+// Profile mặc định, chỉ số trong cameraProfiles[] (camera_handler.cpp).
+// Đổi lúc chạy qua /camera/profile hoặc MQTT, không cần nạp lại firmware.
+#define CAMERA_DEFAULT_PROFILE 3
 #define USB_PAYLOAD_BUF_SIZE (32 * 1024)
 #define USB_FRAME_BUF_SIZE (128 * 1024)
+// USB_STREAM không bao giờ trả frame lớn hơn frame_buf, slot pool không cần lớn hơn
+#define MJPEG_BUF_SIZE USB_FRAME_BUF_SIZE
+#define CAMERA_STATS_INTERVAL 10000
+#define CAMERA_IDLE_GRACE_MS 30000   // tắt UVC khi không còn consumer trong khoảng này
+
+// Xác nhận PIR bằng camera (lưới luma 1/8)
+#define MOTION_GRID_MAX_W 160
+#define MOTION_GRID_MAX_H 120
+#define MOTION_BLOCK 8                // block 8x8 trên lưới = 64x64 pixel ảnh gốc
+#define MOTION_BLOCK_THRESHOLD 12     // chênh lệch luma trung bình/pixel để tính là block thay đổi
+#define MOTION_MIN_BLOCKS 2
+#define MOTION_SAMPLE_MS 200
+#define MOTION_CONFIRM_WINDOW_MS 600
+#define MOTION_CONFIRM_FAIL_OPEN 1    // hết cửa sổ mà camera không cho frame nào: 1 = tin PIR (báo động), 0 = bỏ qua
+
+// Ring JPEG trước/sau sự kiện chuyển động (PSRAM)
+#define EVENT_RING_BYTES (3 * 1024 * 1024)
+#define EVENT_RING_MAX_FRAMES 256
+#define EVENT_PREROLL_MS 5000        // > 0 giữ UVC chạy liên tục (không tắt vì idle); 0 = chỉ có post-roll, camera bật khi có chuyển động
+#define EVENT_POSTROLL_MS 10000
+#define EVENT_CLIP_HOLD_MS 60000     // clip READY không ai lấy sẽ được nhả sau khoảng này
+
+// Ghi clip sự kiện ra SD (/events/*.avi)
+#define REC_BLOCK_SIZE (16 * 1024)   // bội số 512, ghi SD theo khối lớn
+#define REC_MAX_FRAMES 4096
+#define EVENT_DOWNLOAD_MAX 2           // số lượt tải clip đồng thời
+#define EVENT_DOWNLOAD_CHUNK 4096
 
 #define SD_CS     10
 #define SPI_MOSI  12
@@ -39,6 +66,7 @@
 #define SIM_POWER_PIN       15
 
 #define PIR_PIN   7
+#define PIR_DEBOUNCE_MS 50     // xung PIR ngắn hơn mức này coi là nhiễu
 
 #define SERVO1_PIN          47
 #define SERVO2_PIN          48
@@ -58,7 +86,57 @@
 #define AUDIO_ALARM_LEVEL1         4
 #define AUDIO_ALARM_LEVEL2         5
 
-#define MAX_CLIENTS 3
+#define MAX_CLIENTS 6   // một StreamTask phục vụ tất cả, giới hạn bởi socket lwIP
+#define STREAM_MAX_FPS 30
+#define SNAPSHOT_MAX_AGE_MS 1000     // frame cũ hơn thì chờ frame mới
+#define SNAPSHOT_WAIT_MS 150         // chờ frame mới trong loop() tối đa chừng này, quá thì 503
+#define SNAPSHOT_RETRY_AFTER_S 1     // Retry-After khi UVC còn đang khởi động
+#define STREAM_SEND_TIMEOUT_MS 2000   // client không nhận thêm byte nào trong khoảng này sẽ bị ngắt
+#define STREAM_ABR_HEADROOM_PCT 80    // chỉ dùng phần này của throughput đo được để chọn FPS
+#define STREAM_ABR_MAX_INTERVAL 1000  // client chậm nhất vẫn được thử 1 frame/giây
+#define STREAM_STALL_MS 1000          // hai frame gửi xong cách nhau hơn mức này tính là một lần đứng hình
+// Mỗi consumer giữ tối đa một ref: client /stream + /ws, session RTSP, và các
+// task nội bộ (recorder, event buffer, motion, substream, snapshot)
+#define FRAME_POOL_INTERNAL_READERS 5
+#define FRAME_POOL_READERS (MAX_CLIENTS + RTSP_MAX_SESSIONS + FRAME_POOL_INTERNAL_READERS)
+#define FRAME_POOL_SLOTS (FRAME_POOL_READERS + 2)   // + latest + slot đang ghi
+
+// Substream /stream/sub: decode 1/4 + encode lại trên PRO_CPU
+#define SUB_STREAM_MAX_FPS 10
+#define SUB_STREAM_QUALITY 60
+#define SUB_BUF_SIZE (32 * 1024)
+#define SUB_POOL_SLOTS (MAX_CLIENTS + 2)
+#define SUB_STATS_WINDOW_MS 10000   // max_us là giá trị lớn nhất trong cửa sổ trượt này
+
+// WebSocket /ws/stream: frame + sự kiện cảm biến trên một kết nối
+#define WS_MAX_INFLIGHT 2         // số frame chưa được browser ack
+#define WS_ACK_TIMEOUT_MS 2000    // không có ack trong khoảng này thì gửi tiếp
+#define WS_EVENT_MAX 96           // độ dài một sự kiện JSON
+#define WS_EVENT_BUF 256          // sự kiện chờ gửi của mỗi client
+#define WS_EVENT_QUEUE 8
+
+// RTSP + RTP/JPEG (RFC 2435) cho NVR, dùng chung framePool với /stream
+#define RTSP_PORT 554
+#define RTSP_RTP_PORT 5004              // cổng nguồn RTP qua UDP (server_port), RTCP ở cổng kế tiếp
+#define RTSP_MAX_SESSIONS 2
+#define RTSP_RTP_MTU 1400               // kích thước gói RTP tối đa, dưới MTU Wi-Fi
+#define RTSP_SESSION_TIMEOUT_MS 60000   // session không gửi request/RTCP nào trong khoảng này sẽ bị đóng
+#define RTSP_PACE_BURST 4               // số gói RTP mỗi session gửi liền nhau trước khi nhường
+#define RTSP_PACE_INTERVAL_MS 1         // nghỉ giữa các đợt gói của một frame
+
+// Ring trace span (PSRAM), tải về ở /trace dạng Chrome trace-event JSON
+#define TRACE_RING_EVENTS 8192          // lũy thừa của 2, 12 byte/sự kiện
+
+// Service task: cảm biến + máy trạng thái an ninh ưu tiên cao (trên stream_task),
+// Blynk + MQTT ưu tiên trung bình, web/portal ở loop() (ưu tiên 1)
+#define SENSOR_TASK_PRIORITY 3
+#define SENSOR_TASK_PERIOD_MS 10
+#define NET_TASK_PRIORITY 2
+#define NET_TASK_PERIOD_MS 10
+#define SECURITY_EVENT_QUEUE 8
+#define MQTT_OUT_QUEUE 8
+#define AUDIO_REQUEST_QUEUE 4
+
 #define APP_CPU 1
 #define PRO_CPU 0
 
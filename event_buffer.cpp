@@ -0,0 +1,203 @@
+#include "event_buffer.h"
+#include "camera_handler.h"
+
+// Ring các JPEG gần nhất trong PSRAM, giới hạn bởi EVENT_RING_BYTES và
+// EVENT_RING_MAX_FRAMES. Mỗi frame nằm liền một khối (không vắt qua cuối
+// buffer) nên clip có thể gửi thẳng từ ring. Khi có chuyển động, các frame
+// trong EVENT_PREROLL_MS được đóng băng cùng EVENT_POSTROLL_MS frame sau đó.
+
+static uint8_t* ringData = nullptr;
+static event_frame_t ringIndex[EVENT_RING_MAX_FRAMES];
+static uint32_t ringHead = 0;      // số thứ tự entry tiếp theo
+static uint32_t ringTail = 0;      // entry cũ nhất còn giữ
+static uint32_t ringWriteOffset = 0;
+static portMUX_TYPE ringMux = portMUX_INITIALIZER_UNLOCKED;
+
+static EventClipState clipState = EVENT_CLIP_NONE;
+static uint32_t clipFirst = 0;
+static uint32_t clipEnd = 0;       // entry sau entry cuối của clip (khi READY)
+static unsigned long postRollUntil = 0;
+static unsigned long clipReadyTime = 0;
+static uint32_t clipDropped = 0;
+
+static TaskHandle_t eventBufferHandle = NULL;
+
+bool initializeEventBuffer() {
+    ringData = (uint8_t*)heap_caps_malloc(EVENT_RING_BYTES, MALLOC_CAP_SPIRAM);
+    return ringData != nullptr;
+}
+
+// Chỉ eventBufferTask ghi ring nên head/tail/index đọc ở đây không cần khóa.
+// Entry nằm liền nhau theo thứ tự ghi, nên các entry phải bỏ luôn là một đoạn
+// đầu tính từ tail: entry chồng lên [offset, offset+len), và khi quay về đầu
+// buffer thì cả entry ở phần cuối bị bỏ trống. Lock chỉ giữ để công bố tail/head.
+static void appendFrame(const uint8_t* data, size_t len, unsigned long timestamp) {
+    if (len > EVENT_RING_BYTES) return;
+
+    uint32_t writeOffset = ringWriteOffset;
+    bool wrap = writeOffset + len > EVENT_RING_BYTES;
+    uint32_t offset = wrap ? 0 : writeOffset;
+
+    uint32_t head = ringHead;
+    uint32_t tail = ringTail;
+    if (head - tail >= EVENT_RING_MAX_FRAMES) tail = head - EVENT_RING_MAX_FRAMES + 1;
+    while (tail != head) {
+        const event_frame_t& e = ringIndex[tail % EVENT_RING_MAX_FRAMES];
+        bool overlaps = e.offset < offset + len && offset < e.offset + e.length;
+        bool skipped = wrap && e.offset >= writeOffset;
+        if (!overlaps && !skipped) break;
+        tail++;
+    }
+
+    portENTER_CRITICAL(&ringMux);
+    // không chạm vào clip
+    if (clipState != EVENT_CLIP_NONE && tail > clipFirst) {
+        if (clipFirst > ringTail) ringTail = clipFirst;
+        clipDropped++;
+        // ring đầy vì clip: kết thúc post-roll sớm
+        if (clipState == EVENT_CLIP_RECORDING) {
+            clipEnd = ringHead;
+            clipState = EVENT_CLIP_READY;
+        }
+        portEXIT_CRITICAL(&ringMux);
+        return;
+    }
+    ringTail = tail;
+    portEXIT_CRITICAL(&ringMux);
+
+    // vùng [offset, offset+len) không thuộc entry nào, copy ngoài lock
+    memcpy(ringData + offset, data, len);
+
+    portENTER_CRITICAL(&ringMux);
+    event_frame_t& e = ringIndex[ringHead % EVENT_RING_MAX_FRAMES];
+    e.timestamp = timestamp;
+    e.offset = offset;
+    e.length = len;
+    ringHead++;
+    ringWriteOffset = offset + len;
+    portEXIT_CRITICAL(&ringMux);
+}
+
+static void checkPostRoll() {
+    bool finished = false;
+    bool expired = false;
+
+    portENTER_CRITICAL(&ringMux);
+    if (clipState == EVENT_CLIP_RECORDING && (long)(millis() - postRollUntil) >= 0) {
+        clipEnd = ringHead;
+        clipState = EVENT_CLIP_READY;
+        finished = true;
+    }
+    if (clipState == EVENT_CLIP_READY && clipReadyTime == 0) {
+        clipReadyTime = millis();
+    }
+    if (clipState == EVENT_CLIP_READY && millis() - clipReadyTime > EVENT_CLIP_HOLD_MS) {
+        expired = true;
+    }
+    portEXIT_CRITICAL(&ringMux);
+
+    if (finished) {
+        Serial.printf("[EVENT] Clip ready: %u frames (dropped %u)\n", clipEnd - clipFirst, clipDropped);
+    }
+    if (expired) {
+        Serial.println("[EVENT] Clip not collected, releasing");
+        eventClipRelease();
+    }
+}
+
+static void eventBufferTask(void* pvParameters) {
+    uint32_t lastSeq = 0;
+
+    while (true) {
+        if (framePool.waitForFrame(lastSeq, pdMS_TO_TICKS(500))) {
+            FrameRef frame;
+            if (framePool.acquireLatest(frame, lastSeq)) {
+                lastSeq = frame.seq;
+                appendFrame(frame.data, frame.len, frame.timestamp);
+                framePool.release(frame);
+            }
+        }
+        checkPostRoll();
+    }
+}
+
+void startEventBuffer() {
+    if (!ringData || eventBufferHandle != NULL) return;
+
+    xTaskCreatePinnedToCore(eventBufferTask, "EventBuffer", 3072, NULL, 1, &eventBufferHandle, PRO_CPU);
+
+    // pre-roll cần frame từ trước lúc có chuyển động: cố ý giữ UVC chạy
+    // liên tục, camera không tắt vì idle khi EVENT_PREROLL_MS > 0
+    if (EVENT_PREROLL_MS > 0) cameraSetKeepAlive(true);
+}
+
+void triggerEventClip() {
+    if (!ringData) return;
+
+    unsigned long now = millis();
+    bool started = false;
+
+    portENTER_CRITICAL(&ringMux);
+    if (clipState == EVENT_CLIP_NONE) {
+        clipFirst = ringHead;
+        while (clipFirst != ringTail &&
+               now - ringIndex[(clipFirst - 1) % EVENT_RING_MAX_FRAMES].timestamp <= EVENT_PREROLL_MS) {
+            clipFirst--;
+        }
+        clipDropped = 0;
+        clipReadyTime = 0;
+        clipState = EVENT_CLIP_RECORDING;
+        postRollUntil = now + EVENT_POSTROLL_MS;
+        started = true;
+    } else if (clipState == EVENT_CLIP_RECORDING) {
+        // chuyển động tiếp diễn: kéo dài post-roll
+        postRollUntil = now + EVENT_POSTROLL_MS;
+    }
+    portEXIT_CRITICAL(&ringMux);
+
+    if (started) {
+        // gọi từ SensorTask: UVC bật ở handleCameraLoop kế tiếp
+        if (EVENT_PREROLL_MS == 0) cameraAcquireFromTask();
+        Serial.printf("[EVENT] Clip started with %u pre-roll frames\n", ringHead - clipFirst);
+    }
+}
+
+EventClipState eventClipState() {
+    portENTER_CRITICAL(&ringMux);
+    EventClipState state = clipState;
+    portEXIT_CRITICAL(&ringMux);
+    return state;
+}
+
+size_t eventClipFrames() {
+    portENTER_CRITICAL(&ringMux);
+    uint32_t end = (clipState == EVENT_CLIP_READY) ? clipEnd : ringHead;
+    size_t count = (clipState == EVENT_CLIP_NONE) ? 0 : end - clipFirst;
+    portEXIT_CRITICAL(&ringMux);
+    return count;
+}
+
+// Frame thứ index của clip; dữ liệu hợp lệ tới khi eventClipRelease()
+bool eventClipFrame(size_t index, event_frame_t* entry, const uint8_t** data) {
+    bool ok = false;
+
+    portENTER_CRITICAL(&ringMux);
+    uint32_t end = (clipState == EVENT_CLIP_READY) ? clipEnd : ringHead;
+    if (clipState != EVENT_CLIP_NONE && clipFirst + index < end) {
+        *entry = ringIndex[(clipFirst + index) % EVENT_RING_MAX_FRAMES];
+        *data = ringData + entry->offset;
+        ok = true;
+    }
+    portEXIT_CRITICAL(&ringMux);
+
+    return ok;
+}
+
+void eventClipRelease() {
+    portENTER_CRITICAL(&ringMux);
+    bool wasActive = clipState != EVENT_CLIP_NONE;
+    clipState = EVENT_CLIP_NONE;
+    portEXIT_CRITICAL(&ringMux);
+
+    if (wasActive && EVENT_PREROLL_MS == 0) cameraRelease();
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef EVENT_BUFFER_H
+#define EVENT_BUFFER_H
+
+#include "config.h"
+
+// Một frame trong ring: vị trí JPEG trong vùng PSRAM, không cần decode để xuất
+typedef struct {
+    uint32_t timestamp;
+    uint32_t offset;
+    uint32_t length;
+} event_frame_t;
+
+enum EventClipState {
+    EVENT_CLIP_NONE = 0,
+    EVENT_CLIP_RECORDING,   // đã đóng băng pre-roll, đang ghi post-roll
+    EVENT_CLIP_READY        // clip hoàn tất, giữ nguyên tới khi eventClipRelease()
+};
+
+bool initializeEventBuffer();
+void startEventBuffer();
+void triggerEventClip();
+
+EventClipState eventClipState();
+size_t eventClipFrames();
+bool eventClipFrame(size_t index, event_frame_t* entry, const uint8_t** data);
+void eventClipRelease();
+
+#endif
\ No newline at end of file
@@ -0,0 +1,307 @@
+#include "event_recorder.h"
+#include "camera_handler.h"
+#include "event_buffer.h"
+#include "audio_handler.h"
+#include "security_system.h"
+#include <time.h>
+
+// Ghi clip chuyển động ra thẻ SD dạng AVI (MJPEG) trong lúc
+// currentSecurityState != SECURITY_IDLE. Task ưu tiên thấp gom frame vào
+// buffer REC_BLOCK_SIZE và chỉ ghi SD theo khối lớn, idx1 ghi một lần khi
+// đóng file, nên frame_cb và stream không bao giờ chờ SPI. Frame từ pool được
+// copy sang frameStage (PSRAM) và trả ref trước khi ghi, để lần flush SD chậm
+// không giữ slot của pool.
+
+#define AVI_HEADER_SIZE 224
+#define AVI_MOVI_OFFSET 220     // vị trí fourcc 'movi', gốc của offset trong idx1
+#define AVI_HDRL_SIZE   (AVI_MOVI_OFFSET - 8 - 20)
+
+typedef struct {
+    uint32_t offset;
+    uint32_t size;
+} avi_index_t;
+
+static TaskHandle_t recorderHandle = NULL;
+static volatile bool recording = false;
+
+static uint8_t* blockBuf = nullptr;
+static size_t blockFill = 0;
+static uint8_t* frameStage = nullptr;
+static avi_index_t* aviIndex = nullptr;
+
+static File recFile;
+static char recPath[40];
+static uint32_t recFrames = 0;
+static uint32_t recDropped = 0;
+static uint32_t moviBytes = 0;
+static uint64_t bytesWritten = 0;
+static unsigned long writeTimeMs = 0;
+static unsigned long recStartTime = 0;
+static unsigned long lastFrameTimestamp = 0;
+static uint16_t recWidth = 0;
+static uint16_t recHeight = 0;
+
+static void put16(uint8_t* p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put32(uint8_t* p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+}
+
+static void putFourcc(uint8_t* p, const char* cc) {
+    memcpy(p, cc, 4);
+}
+
+static void buildAviHeader(uint8_t* h, uint32_t frames, uint32_t usPerFrame, uint32_t riffSize, uint32_t moviSize) {
+    memset(h, 0, AVI_HEADER_SIZE);
+
+    putFourcc(h + 0, "RIFF");   put32(h + 4, riffSize);   putFourcc(h + 8, "AVI ");
+    putFourcc(h + 12, "LIST");  put32(h + 16, AVI_HDRL_SIZE);       putFourcc(h + 20, "hdrl");
+
+    putFourcc(h + 24, "avih");  put32(h + 28, 56);
+    put32(h + 32, usPerFrame);
+    put32(h + 44, 0x10);                    // AVIF_HASINDEX
+    put32(h + 48, frames);
+    put32(h + 56, 1);                       // dwStreams
+    put32(h + 60, MJPEG_BUF_SIZE);
+    put32(h + 64, recWidth);
+    put32(h + 68, recHeight);
+
+    putFourcc(h + 88, "LIST");  put32(h + 92, 116);       putFourcc(h + 96, "strl");
+
+    putFourcc(h + 100, "strh"); put32(h + 104, 56);
+    putFourcc(h + 108, "vids"); putFourcc(h + 112, "MJPG");
+    put32(h + 128, 1);                      // dwScale
+    put32(h + 132, usPerFrame ? 1000000 / usPerFrame : 1);   // dwRate
+    put32(h + 140, frames);                 // dwLength
+    put32(h + 144, MJPEG_BUF_SIZE);
+    put32(h + 148, 0xFFFFFFFF);             // dwQuality
+    put16(h + 160, recWidth);
+    put16(h + 162, recHeight);
+
+    putFourcc(h + 164, "strf"); put32(h + 168, 40);
+    put32(h + 172, 40);
+    put32(h + 176, recWidth);
+    put32(h + 180, recHeight);
+    put16(h + 184, 1);
+    put16(h + 186, 24);
+    putFourcc(h + 188, "MJPG");
+    put32(h + 192, (uint32_t)recWidth * recHeight * 3);
+
+    putFourcc(h + 212, "LIST"); put32(h + 216, moviSize); putFourcc(h + 220, "movi");
+}
+
+static bool flushBlock() {
+    if (blockFill == 0) return true;
+
+    unsigned long start = millis();
+    size_t written = recFile.write(blockBuf, blockFill);
+    writeTimeMs += millis() - start;
+    bytesWritten += written;
+
+    bool ok = (written == blockFill);
+    blockFill = 0;
+    return ok;
+}
+
+// Gom dữ liệu vào block, chỉ ghi SD khi đủ REC_BLOCK_SIZE
+static bool appendBytes(const uint8_t* data, size_t len) {
+    while (len > 0) {
+        size_t n = min(len, (size_t)(REC_BLOCK_SIZE - blockFill));
+        memcpy(blockBuf + blockFill, data, n);
+        blockFill += n;
+        data += n;
+        len -= n;
+
+        if (blockFill == REC_BLOCK_SIZE && !flushBlock()) return false;
+    }
+    return true;
+}
+
+static bool writeFrame(const uint8_t* data, size_t len) {
+    if (recFrames >= REC_MAX_FRAMES) return false;
+
+    uint32_t padded = (len + 1) & ~1u;
+    uint8_t chunk[8];
+    putFourcc(chunk, "00dc");
+    put32(chunk + 4, padded);
+
+    // offset trong idx1 tính từ fourcc 'movi' (AVI_MOVI_OFFSET)
+    aviIndex[recFrames].offset = moviBytes;
+    aviIndex[recFrames].size = padded;
+
+    static const uint8_t pad = 0;
+    if (!appendBytes(chunk, 8) || !appendBytes(data, len)) return false;
+    if (padded != len && !appendBytes(&pad, 1)) return false;
+
+    moviBytes += 8 + padded;
+    recFrames++;
+    return true;
+}
+
+static bool openRecording() {
+    SD.mkdir("/events");
+
+    time_t now = time(nullptr);
+    unsigned long stamp = (now > 1600000000) ? (unsigned long)now : millis();
+    snprintf(recPath, sizeof(recPath), "/events/%lu.avi", stamp);
+
+    recFile = SD.open(recPath, FILE_WRITE);
+    if (!recFile) {
+        Serial.printf("[REC] Cannot open %s\n", recPath);
+        return false;
+    }
+
+    recFrames = 0;
+    recDropped = 0;
+    moviBytes = 4;      // fourcc 'movi' nằm trong LIST movi
+    bytesWritten = 0;
+    writeTimeMs = 0;
+    blockFill = 0;
+    recStartTime = millis();
+    lastFrameTimestamp = 0;
+    recWidth = cameraProfiles[activeCameraProfile()].width;
+    recHeight = cameraProfiles[activeCameraProfile()].height;
+
+    // header tạm, được ghi lại khi đóng file
+    uint8_t header[AVI_HEADER_SIZE];
+    buildAviHeader(header, 0, 0, 0, 0);
+    appendBytes(header, AVI_HEADER_SIZE);
+
+    // pre-roll từ ring PSRAM
+    size_t preroll = eventClipFrames();
+    for (size_t i = 0; i < preroll; i++) {
+        event_frame_t entry;
+        const uint8_t* data;
+        if (!eventClipFrame(i, &entry, &data)) break;
+        if (!writeFrame(data, entry.length)) break;
+        lastFrameTimestamp = entry.timestamp;
+    }
+
+    Serial.printf("[REC] Recording %s (%u pre-roll frames)\n", recPath, recFrames);
+    return true;
+}
+
+static void closeRecording() {
+    if (!flushBlock()) recDropped++;
+
+    // idx1 ghi một lần ở cuối
+    uint8_t entry[16];
+    putFourcc(entry, "idx1");
+    put32(entry + 4, recFrames * 16);
+    appendBytes(entry, 8);
+    for (uint32_t i = 0; i < recFrames; i++) {
+        putFourcc(entry, "00dc");
+        put32(entry + 4, 0x10);             // AVIIF_KEYFRAME
+        put32(entry + 8, aviIndex[i].offset);
+        put32(entry + 12, aviIndex[i].size);
+        appendBytes(entry, 16);
+    }
+    flushBlock();
+
+    unsigned long duration = millis() - recStartTime;
+    uint32_t usPerFrame = recFrames ? (uint32_t)((uint64_t)duration * 1000 / recFrames) : 0;
+    uint32_t riffSize = AVI_HEADER_SIZE - 8 + moviBytes - 4 + 8 + recFrames * 16;
+
+    uint8_t header[AVI_HEADER_SIZE];
+    buildAviHeader(header, recFrames, usPerFrame, riffSize, moviBytes);
+    recFile.seek(0);
+    recFile.write(header, AVI_HEADER_SIZE);
+    recFile.close();
+
+    eventClipRelease();
+
+    float fps = duration ? recFrames * 1000.0f / duration : 0;
+    float kbps = writeTimeMs ? (bytesWritten / 1024.0f) * 1000.0f / writeTimeMs : 0;
+    Serial.printf("[REC] Closed %s: %u frames, %u dropped, %.1f fps, SD write %.0f KB/s\n",
+                  recPath, recFrames, recDropped, fps, kbps);
+}
+
+static void recorderTask(void* pvParameters) {
+    uint32_t lastSeq = 0;
+
+    while (true) {
+        bool active = (currentSecurityState != SECURITY_IDLE);
+
+        if (!recording) {
+            if (active && openRecording()) {
+                recording = true;
+                lastSeq = framePool.latestSeq();
+            } else {
+                vTaskDelay(pdMS_TO_TICKS(200));
+                continue;
+            }
+        }
+
+        if (!active || recFrames >= REC_MAX_FRAMES) {
+            closeRecording();
+            recording = false;
+            continue;
+        }
+
+        if (!framePool.waitForFrame(lastSeq, pdMS_TO_TICKS(500))) continue;
+
+        FrameRef frame;
+        if (!framePool.acquireLatest(frame, lastSeq)) continue;
+
+        // recorder chậm hơn camera thì bỏ frame cũ, chỉ ghi frame mới nhất
+        if (lastSeq != 0 && frame.seq - lastSeq > 1) recDropped += frame.seq - lastSeq - 1;
+        lastSeq = frame.seq;
+
+        // frame đã có trong pre-roll
+        if (frame.timestamp <= lastFrameTimestamp) {
+            framePool.release(frame);
+            continue;
+        }
+        lastFrameTimestamp = frame.timestamp;
+
+        // kích thước thật lấy từ SOF, header được ghi lại khi đóng file
+        if (frame.info->width != 0) {
+            recWidth = frame.info->width;
+            recHeight = frame.info->height;
+        }
+
+        // copy rồi trả ref ngay, writeFrame có thể flushBlock() ra SD
+        size_t len = min(frame.len, (size_t)MJPEG_BUF_SIZE);
+        memcpy(frameStage, frame.data, len);
+        framePool.release(frame);
+
+        bool ok = writeFrame(frameStage, len);
+
+        if (!ok) {
+            Serial.println("[REC] SD write failed");
+            closeRecording();
+            recording = false;
+            vTaskDelay(pdMS_TO_TICKS(1000));
+        }
+    }
+}
+
+void startEventRecorder() {
+    if (recorderHandle != NULL || !sdCardMounted) return;
+
+    blockBuf = (uint8_t*)heap_caps_aligned_alloc(4, REC_BLOCK_SIZE, MALLOC_CAP_DMA);
+    aviIndex = (avi_index_t*)heap_caps_malloc(REC_MAX_FRAMES * sizeof(avi_index_t), MALLOC_CAP_SPIRAM);
+    frameStage = (uint8_t*)heap_caps_malloc(MJPEG_BUF_SIZE, MALLOC_CAP_SPIRAM);
+    if (!blockBuf || !aviIndex || !frameStage) {
+        Serial.println("[REC] Buffer allocation failed");
+        heap_caps_free(blockBuf);
+        heap_caps_free(aviIndex);
+        heap_caps_free(frameStage);
+        blockBuf = nullptr;
+        aviIndex = nullptr;
+        frameStage = nullptr;
+        return;
+    }
+
+    xTaskCreatePinnedToCore(recorderTask, "EventRecorder", 4096, NULL, 1, &recorderHandle, PRO_CPU);
+}
+
+bool isEventRecording() {
+    return recording;
+}
\ No newline at end of file
@@ -0,0 +1,9 @@
+#ifndef EVENT_RECORDER_H
+#define EVENT_RECORDER_H
+
+#include "config.h"
+
+void startEventRecorder();
+bool isEventRecording();
+
+#endif
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include "frame_diff.h"
+#include <string.h>
+
+// SWAR: 4 pixel mỗi lần đọc 32 bit, tách byte chẵn/lẻ thành làn 16 bit để
+// tính |a - b| không mượn bit giữa các làn.
+//
+// Chưa có bản PIE (EE.*) cho ESP32-S3: block chỉ rộng MOTION_BLOCK = 8 byte
+// với stride = gridW (80 ở VGA) nên hàng không căn 16 byte, mỗi hàng phải
+// qua EE.LD.128.USAR + EE.SRC.Q mà vẫn chỉ dùng nửa thanh ghi 128 bit; PIE
+// cũng không có lệnh trị tuyệt đối hiệu u8. Cả lưới 80x60 chỉ tốn vài µs mỗi
+// lần lấy mẫu (xem tests/test_frame_diff.cpp), nhỏ so với bước giải mã JPEG,
+// nên không đáng giữ một đoạn asm không kiểm thử được trên host.
+uint32_t blockDiffSum(const uint8_t* a, const uint8_t* b, int stride, int size) {
+    uint32_t acc = 0;
+
+    for (int row = 0; row < size; row++) {
+        const uint8_t* pa = a + row * stride;
+        const uint8_t* pb = b + row * stride;
+
+        for (int col = 0; col < size; col += 4) {
+            uint32_t wa, wb;
+            memcpy(&wa, pa + col, 4);
+            memcpy(&wb, pb + col, 4);
+
+            for (int shift = 0; shift <= 8; shift += 8) {
+                uint32_t la = (wa >> shift) & 0x00FF00FF;
+                uint32_t lb = (wb >> shift) & 0x00FF00FF;
+                uint32_t d = (la + 0x01000100) - lb;           // 256 + a - b mỗi làn
+                uint32_t ge = ((d >> 8) & 0x00010001) * 0xFF;  // 0xFF nếu a >= b
+                uint32_t pos = d & ge;
+                uint32_t neg = (0x02000200 - d) & ~ge;
+                acc += ((pos | neg) & 0x00FF00FF);
+            }
+        }
+    }
+
+    return (acc & 0xFFFF) + (acc >> 16);
+}
\ No newline at end of file
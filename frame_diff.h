@@ -0,0 +1,12 @@
+#ifndef FRAME_DIFF_H
+#define FRAME_DIFF_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Tổng |a - b| của một block size x size trên lưới luma 8 bit.
+// size là bội số của 4 và không quá 16 (làn tích lũy 16 bit không tràn).
+// Không phụ thuộc Arduino.
+uint32_t blockDiffSum(const uint8_t* a, const uint8_t* b, int stride, int size);
+
+#endif
\ No newline at end of file
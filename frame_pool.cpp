@@ -0,0 +1,171 @@
+#include "frame_pool.h"
+
+#define FRAME_READY_BIT (1 << 0)
+
+FramePool framePool;
+
+bool FramePool::begin(size_t slotCount, size_t slotSize) {
+    if (slotCount > FRAME_POOL_SLOTS) slotCount = FRAME_POOL_SLOTS;
+
+    if (_events == NULL) {
+        _events = xEventGroupCreate();
+        if (_events == NULL) return false;
+    }
+
+    for (size_t i = 0; i < slotCount; i++) {
+        _slots[i].data = (uint8_t*)heap_caps_malloc(slotSize, MALLOC_CAP_SPIRAM);
+        if (!_slots[i].data) {
+            _count = i;
+            end();
+            return false;
+        }
+        _slots[i].capacity = slotSize;
+        _slots[i].len = 0;
+        _slots[i].refs = 0;
+    }
+
+    _count = slotCount;
+    _slotSize = slotSize;
+    _latest = nullptr;
+    return true;
+}
+
+void FramePool::end() {
+    for (size_t i = 0; i < _count; i++) {
+        free(_slots[i].data);
+        _slots[i].data = nullptr;
+        _slots[i].capacity = 0;
+    }
+    _count = 0;
+    _slotSize = 0;
+    _latest = nullptr;
+
+    if (_events != NULL) {
+        vEventGroupDelete(_events);
+        _events = NULL;
+    }
+}
+
+frame_slot_t* FramePool::acquireWrite() {
+    frame_slot_t* slot = nullptr;
+
+    portENTER_CRITICAL(&_mux);
+    for (size_t i = 0; i < _count; i++) {
+        if (_slots[i].refs == 0) {
+            slot = &_slots[i];
+            slot->refs = 1;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&_mux);
+
+    return slot;
+}
+
+void FramePool::publish(frame_slot_t* slot, size_t len) {
+    publish(slot, len, millis());
+}
+
+void FramePool::publish(frame_slot_t* slot, size_t len, unsigned long timestamp) {
+    if (!slot) return;
+
+    portENTER_CRITICAL(&_mux);
+    uint32_t start = ESP.getCycleCount();
+    slot->len = len;
+    slot->seq = _nextSeq++;
+    slot->timestamp = timestamp;
+
+    // the producer's reference becomes the pool's reference on latest
+    frame_slot_t* old = _latest;
+    _latest = slot;
+    if (old) old->refs--;
+
+    uint32_t cycles = ESP.getCycleCount() - start;
+    if (cycles > _maxCritCycles) _maxCritCycles = cycles;
+    portEXIT_CRITICAL(&_mux);
+
+    xEventGroupSetBits(_events, FRAME_READY_BIT);
+}
+
+void FramePool::abort(frame_slot_t* slot) {
+    if (!slot) return;
+
+    portENTER_CRITICAL(&_mux);
+    slot->refs--;
+    portEXIT_CRITICAL(&_mux);
+}
+
+bool FramePool::acquireLatest(FrameRef& ref, uint32_t afterSeq) {
+    bool ok = false;
+
+    portENTER_CRITICAL(&_mux);
+    frame_slot_t* slot = _latest;
+    if (slot && slot->seq > afterSeq) {
+        slot->refs++;
+        ref.data = slot->data;
+        ref.len = slot->len;
+        ref.seq = slot->seq;
+        ref.timestamp = slot->timestamp;
+        ref.info = &slot->info;
+        ref.slot = slot;
+        ok = true;
+    }
+    portEXIT_CRITICAL(&_mux);
+
+    return ok;
+}
+
+void FramePool::release(FrameRef& ref) {
+    if (!ref.slot) return;
+
+    portENTER_CRITICAL(&_mux);
+    ref.slot->refs--;
+    portEXIT_CRITICAL(&_mux);
+
+    ref.slot = nullptr;
+    ref.info = nullptr;
+    ref.data = nullptr;
+    ref.len = 0;
+}
+
+uint32_t FramePool::latestSeq() {
+    portENTER_CRITICAL(&_mux);
+    uint32_t seq = _latest ? _latest->seq : 0;
+    portEXIT_CRITICAL(&_mux);
+    return seq;
+}
+
+// Block until a frame newer than afterSeq is published or timeout expires.
+// Readers that were busy when the bit was set find it still set on their
+// next call, so a publish is never missed. A wake on a stale bit (set for a
+// frame this reader already has) goes back to waiting for the time left.
+bool FramePool::waitForFrame(uint32_t afterSeq, TickType_t timeout) {
+    if (_events == NULL) return latestSeq() > afterSeq;
+
+    TickType_t start = xTaskGetTickCount();
+    while (latestSeq() <= afterSeq) {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout) return false;
+        xEventGroupWaitBits(_events, FRAME_READY_BIT, pdTRUE, pdFALSE, timeout - elapsed);
+    }
+    return true;
+}
+
+// Longest time spent inside publish()'s critical section since the last call
+uint32_t FramePool::takeMaxCritCycles() {
+    portENTER_CRITICAL(&_mux);
+    uint32_t cycles = _maxCritCycles;
+    _maxCritCycles = 0;
+    portEXIT_CRITICAL(&_mux);
+    return cycles;
+}
+
+// Drop the pool's reference on latest so no new reader picks up a stale
+// frame. Readers still holding a FrameRef keep their slot until release();
+// seq stays monotonic so afterSeq checks remain valid across a restart.
+void FramePool::invalidate() {
+    portENTER_CRITICAL(&_mux);
+    if (_latest) _latest->refs--;
+    _latest = nullptr;
+    portEXIT_CRITICAL(&_mux);
+}
\ No newline at end of file
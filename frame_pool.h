@@ -0,0 +1,67 @@
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include "config.h"
+#include "jpeg_scan.h"
+
+typedef struct {
+    uint8_t* data;
+    size_t capacity;
+    size_t len;
+    uint32_t seq;
+    unsigned long timestamp;
+    jpeg_info_t info;       // điền bởi producer trước publish()
+    int refs;
+} frame_slot_t;
+
+// Read-only view of a published frame. Every successful acquireLatest()
+// must be paired with exactly one release().
+struct FrameRef {
+    const uint8_t* data = nullptr;
+    size_t len = 0;
+    uint32_t seq = 0;
+    unsigned long timestamp = 0;
+    const jpeg_info_t* info = nullptr;
+    frame_slot_t* slot = nullptr;
+};
+
+// N slots shared by one producer (frame_cb) and any number of readers.
+// The pool keeps a reference on the latest frame; a slot is reused only
+// once the pool and every reader have let go of it. publish() wakes every
+// reader blocked in waitForFrame().
+class FramePool {
+public:
+    bool begin(size_t slotCount, size_t slotSize);
+    void end();
+
+    // Producer side
+    frame_slot_t* acquireWrite();
+    void publish(frame_slot_t* slot, size_t len);
+    // Derived frames (substream) keep the capture time of their source
+    void publish(frame_slot_t* slot, size_t len, unsigned long timestamp);
+    void abort(frame_slot_t* slot);
+
+    // Consumer side
+    bool acquireLatest(FrameRef& ref, uint32_t afterSeq = 0);
+    void release(FrameRef& ref);
+
+    uint32_t latestSeq();
+    bool waitForFrame(uint32_t afterSeq, TickType_t timeout);
+    uint32_t takeMaxCritCycles();
+    size_t slotSize() const { return _slotSize; }
+    void invalidate();
+
+private:
+    frame_slot_t _slots[FRAME_POOL_SLOTS] = {};
+    size_t _count = 0;
+    size_t _slotSize = 0;
+    frame_slot_t* _latest = nullptr;
+    uint32_t _nextSeq = 1;
+    uint32_t _maxCritCycles = 0;
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+    EventGroupHandle_t _events = NULL;
+};
+
+extern FramePool framePool;
+
+#endif
\ No newline at end of file
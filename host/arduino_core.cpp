@@ -0,0 +1,180 @@
+#include <Arduino.h>
+
+#include <stdarg.h>
+#include <mutex>
+
+HardwareSerial Serial(0);
+
+static std::string formatInteger(unsigned long long value, bool negative, unsigned char base) {
+    if (base < 2 || base > 36) base = 10;
+    std::string digits;
+    do {
+        int d = (int)(value % base);
+        digits.insert(digits.begin(), (char)(d < 10 ? '0' + d : 'a' + d - 10));
+        value /= base;
+    } while (value);
+    if (negative) digits.insert(digits.begin(), '-');
+    return digits;
+}
+
+static std::string formatSigned(long long value, unsigned char base) {
+    if (base == 10 && value < 0) return formatInteger(0ULL - (unsigned long long)value, true, base);
+    return formatInteger((unsigned long long)value, false, base);
+}
+
+String::String(int value, unsigned char base) : _s(formatSigned(value, base)) {}
+String::String(unsigned int value, unsigned char base) : _s(formatInteger(value, false, base)) {}
+String::String(long value, unsigned char base) : _s(formatSigned(value, base)) {}
+String::String(unsigned long value, unsigned char base) : _s(formatInteger(value, false, base)) {}
+String::String(long long value, unsigned char base) : _s(formatSigned(value, base)) {}
+String::String(unsigned long long value, unsigned char base) : _s(formatInteger(value, false, base)) {}
+
+String::String(double value, unsigned int decimals) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimals, value);
+    _s = buf;
+}
+
+bool String::equalsIgnoreCase(const String& rhs) const {
+    return _s.size() == rhs._s.size() && strcasecmp(_s.c_str(), rhs._s.c_str()) == 0;
+}
+
+bool String::startsWith(const String& prefix) const {
+    return _s.compare(0, prefix._s.size(), prefix._s) == 0;
+}
+
+bool String::endsWith(const String& suffix) const {
+    return _s.size() >= suffix._s.size() &&
+           _s.compare(_s.size() - suffix._s.size(), suffix._s.size(), suffix._s) == 0;
+}
+
+int String::indexOf(char c, unsigned int from) const {
+    size_t pos = _s.find(c, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const String& s, unsigned int from) const {
+    size_t pos = _s.find(s._s, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(char c) const {
+    size_t pos = _s.rfind(c);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(const String& s) const {
+    size_t pos = _s.rfind(s._s);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int from) const {
+    return from >= _s.size() ? String() : String(_s.substr(from));
+}
+
+// như Arduino: from > to thì đổi chỗ, vượt cuối thì cắt ở cuối
+String String::substring(unsigned int from, unsigned int to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= _s.size()) return String();
+    return String(_s.substr(from, std::min<size_t>(to, _s.size()) - from));
+}
+
+void String::replace(const String& find, const String& with) {
+    if (find._s.empty()) return;
+    size_t pos = 0;
+    while ((pos = _s.find(find._s, pos)) != std::string::npos) {
+        _s.replace(pos, find._s.size(), with._s);
+        pos += with._s.size();
+    }
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+    if (index < _s.size()) _s.erase(index, count);
+}
+
+void String::trim() {
+    size_t begin = 0, end = _s.size();
+    while (begin < end && isspace((unsigned char)_s[begin])) begin++;
+    while (end > begin && isspace((unsigned char)_s[end - 1])) end--;
+    _s = _s.substr(begin, end - begin);
+}
+
+void String::toLowerCase() {
+    for (char& c : _s) c = (char)tolower((unsigned char)c);
+}
+
+void String::toUpperCase() {
+    for (char& c : _s) c = (char)toupper((unsigned char)c);
+}
+
+size_t Print::write(const uint8_t* buf, size_t len) {
+    size_t n = 0;
+    while (n < len && write(buf[n])) n++;
+    return n;
+}
+
+size_t Print::printf(const char* fmt, ...) {
+    char stackBuf[256];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(stackBuf, sizeof(stackBuf), fmt, args);
+    va_end(args);
+    if (len < 0) return 0;
+    if ((size_t)len < sizeof(stackBuf)) return write((const uint8_t*)stackBuf, len);
+
+    std::string big(len + 1, '\0');
+    va_start(args, fmt);
+    vsnprintf(&big[0], big.size(), fmt, args);
+    va_end(args);
+    return write((const uint8_t*)big.data(), len);
+}
+
+size_t Stream::readBytes(uint8_t* buf, size_t len) {
+    size_t n = 0;
+    unsigned long start = millis();
+    while (n < len && millis() - start < _timeout) {
+        int c = read();
+        if (c < 0) {
+            vTaskDelay(1);
+            continue;
+        }
+        buf[n++] = (uint8_t)c;
+    }
+    return n;
+}
+
+String Stream::readStringUntil(char terminator) {
+    String out;
+    unsigned long start = millis();
+    while (millis() - start < _timeout) {
+        int c = read();
+        if (c < 0) {
+            vTaskDelay(1);
+            continue;
+        }
+        if (c == terminator) break;
+        out += (char)c;
+    }
+    return out;
+}
+
+// println kết thúc bằng \r\n như trên UART; terminal của host chỉ cần \n
+static std::mutex serialLock;
+
+size_t HardwareSerial::write(uint8_t c) { return write(&c, 1); }
+
+size_t HardwareSerial::write(const uint8_t* buf, size_t len) {
+    if (_uart != 0) return len;
+    std::lock_guard<std::mutex> guard(serialLock);
+    for (size_t i = 0; i < len; i++) {
+        if (buf[i] != '\r') fputc(buf[i], stdout);
+    }
+    fflush(stdout);
+    return len;
+}
+
+String IPAddress::toString() const {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+    return String(buf);
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+// Firmware chạy trên Linux: main.ino cùng mọi unit của sketch, trên các
+// stand-in trong host/ (socket POSIX, camera phát lại JPEG, SD là thư mục).
+//
+//   camera_iuh_host [--camera-dir DIR] [--sd-dir DIR] [--port-offset N] [--ap]
+//
+// HTTP ở 80 + offset, RTSP ở 554 + offset (offset mặc định 8000), RTP giữ 5004.
+// --ap bỏ credential Wi-Fi giả lập để vào portal cấu hình thay vì STA.
+// stdin nhận lệnh: "pir 1" / "pir 0" đổi mức chân PIR, "mqtt <topic> <payload>".
+
+#include <Arduino.h>
+#include "host_hal.h"
+
+#include <signal.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "main.ino"
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s [--camera-dir DIR] [--sd-dir DIR] [--port-offset N] [--ap]\n", argv0);
+}
+
+static void consoleTask() {
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        std::istringstream in(line);
+        std::string cmd;
+        in >> cmd;
+        if (cmd == "pir") {
+            int level = 0;
+            in >> level;
+            hostSetPinLevel(PIR_PIN, level);
+        } else if (cmd == "mqtt") {
+            std::string topic, payload;
+            in >> topic;
+            std::getline(in >> std::ws, payload);
+            hostMqttInject(topic.c_str(), payload.c_str());
+        } else if (!cmd.empty()) {
+            fprintf(stderr, "[HOST] unknown command: %s\n", cmd.c_str());
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    bool apMode = false;
+    for (int i = 1; i < argc; i++) {
+        std::string opt = argv[i];
+        if (opt == "--ap") {
+            apMode = true;
+        } else if (i + 1 < argc && opt == "--camera-dir") {
+            setenv("HOST_CAMERA_DIR", argv[++i], 1);
+        } else if (i + 1 < argc && opt == "--sd-dir") {
+            setenv("HOST_SD_DIR", argv[++i], 1);
+        } else if (i + 1 < argc && opt == "--port-offset") {
+            setenv("HOST_PORT_OFFSET", argv[++i], 1);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    // peer đóng socket giữa chừng: để write trả EPIPE như lwIP
+    signal(SIGPIPE, SIG_IGN);
+
+    // EEPROM host mới tinh mỗi lần chạy: ghi sẵn SSID để sketch vào thẳng STA
+    if (!apMode) {
+        EEPROM.begin(512);
+        writeEEPROM(0, 32, "host-lan");
+        writeEEPROM(32, 64, "host-lan");
+        EEPROM.commit();
+    }
+
+    std::thread(consoleTask).detach();
+
+    // loopTask của Arduino-ESP32 chạy trên APP_CPU
+    hostSetCoreId(APP_CPU);
+    setup();
+    for (;;) loop();
+}
\ No newline at end of file
@@ -0,0 +1,295 @@
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/event_groups.h>
+#include "host_hal.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+
+EspClass ESP;
+
+static const auto hostStart = std::chrono::steady_clock::now();
+static thread_local int hostCoreId = 0;
+
+static uint64_t elapsedNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - hostStart).count();
+}
+
+unsigned long millis() { return (unsigned long)(elapsedNs() / 1000000); }
+unsigned long micros() { return (unsigned long)(elapsedNs() / 1000); }
+int64_t esp_timer_get_time() { return (int64_t)(elapsedNs() / 1000); }
+
+// CCOUNT 32 bit tràn như trên chip thật
+uint32_t EspClass::getCycleCount() { return (uint32_t)(elapsedNs() * HOST_CPU_FREQ_MHZ / 1000); }
+uint32_t EspClass::getFreeHeap() { return 0; }
+uint32_t EspClass::getMinFreeHeap() { return 0; }
+uint32_t EspClass::getFreePsram() { return 0; }
+
+void EspClass::restart() {
+    Serial.println("[HOST] ESP.restart()");
+    fflush(stdout);
+    exit(0);
+}
+
+void delay(uint32_t ms) { vTaskDelay(pdMS_TO_TICKS(ms)); }
+void yield() { std::this_thread::yield(); }
+bool psramFound() { return true; }
+
+uint32_t esp_random() {
+    static std::mutex lock;
+    static std::mt19937 rng(std::random_device{}());
+    std::lock_guard<std::mutex> guard(lock);
+    return rng();
+}
+
+// GPIO: mức của 64 chân + ISR gắn bằng attachInterrupt, gọi ngay trong
+// thread của hostSetPinLevel() như ngắt trên chip
+static std::atomic<int> pinLevels[64];
+static std::atomic<uint16_t> pinAnalog[64];
+static void (*pinIsr[64])(void);
+static int pinIsrMode[64];
+static std::mutex pinLock;
+
+void pinMode(uint8_t pin, uint8_t mode) {}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+    if (pin < 64) pinLevels[pin] = level ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin) { return pin < 64 ? pinLevels[pin].load() : LOW; }
+uint16_t analogRead(uint8_t pin) { return pin < 64 ? pinAnalog[pin].load() : 0; }
+int digitalPinToInterrupt(uint8_t pin) { return pin; }
+
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode) {
+    if (pin >= 64) return;
+    std::lock_guard<std::mutex> guard(pinLock);
+    pinIsr[pin] = isr;
+    pinIsrMode[pin] = mode;
+}
+
+void detachInterrupt(uint8_t pin) {
+    if (pin >= 64) return;
+    std::lock_guard<std::mutex> guard(pinLock);
+    pinIsr[pin] = nullptr;
+}
+
+void hostSetPinLevel(int pin, int level) {
+    if (pin < 0 || pin >= 64) return;
+    int before = pinLevels[pin].exchange(level ? HIGH : LOW);
+    if (before == (level ? HIGH : LOW)) return;
+    void (*isr)(void);
+    int mode;
+    {
+        std::lock_guard<std::mutex> guard(pinLock);
+        isr = pinIsr[pin];
+        mode = pinIsrMode[pin];
+    }
+    bool rising = level && !before;
+    if (isr && (mode == CHANGE || (mode == RISING && rising) || (mode == FALLING && !rising))) isr();
+}
+
+void hostSetAnalog(int pin, uint16_t value) {
+    if (pin >= 0 && pin < 64) pinAnalog[pin] = value;
+}
+
+void vPortEnterCritical(portMUX_TYPE* mux) {
+    while (__atomic_exchange_n(&mux->locked, 1, __ATOMIC_ACQUIRE)) {
+        std::this_thread::yield();
+    }
+}
+
+void vPortExitCritical(portMUX_TYPE* mux) {
+    __atomic_store_n(&mux->locked, 0, __ATOMIC_RELEASE);
+}
+
+BaseType_t xPortGetCoreID() { return hostCoreId; }
+void hostSetCoreId(int core) { hostCoreId = core; }
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+TickType_t xTaskGetTickCount() { return (TickType_t)millis(); }
+
+void vTaskDelayUntil(TickType_t* previousWake, TickType_t period) {
+    *previousWake += period;
+    TickType_t wait = *previousWake - xTaskGetTickCount();
+    // lỡ hạn (wait "âm") thì chạy ngay, như FreeRTOS
+    if (wait <= period) vTaskDelay(wait);
+}
+
+struct host_task {
+    TaskFunction_t fn;
+    void* arg;
+    int core;
+    std::string name;
+};
+
+static void* taskEntry(void* param) {
+    host_task* task = (host_task*)param;
+    hostSetCoreId(task->core);
+    pthread_setname_np(pthread_self(), task->name.substr(0, 15).c_str());
+    task->fn(task->arg);
+    // task FreeRTOS không được return; vẫn dọn nếu có
+    delete task;
+    return nullptr;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                                   void* arg, UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+    host_task* task = new host_task{fn, arg, core < 0 ? 0 : (int)core, name ? name : ""};
+    pthread_t thread;
+    if (pthread_create(&thread, nullptr, taskEntry, task) != 0) {
+        delete task;
+        return pdFAIL;
+    }
+    pthread_detach(thread);
+    if (handle) *handle = task;
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task != NULL) {
+        Serial.println("[HOST] vTaskDelete(other task) is not supported");
+        abort();
+    }
+    // handle vẫn có thể nằm trong biến của firmware nên không delete host_task ở đây
+    pthread_exit(nullptr);
+}
+
+struct host_queue {
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<std::vector<uint8_t>> items;
+    size_t length;
+    size_t itemSize;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    host_queue* queue = new host_queue;
+    queue->length = length;
+    queue->itemSize = itemSize;
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue) { delete queue; }
+
+static bool waitQueue(host_queue* queue, std::unique_lock<std::mutex>& guard, TickType_t timeout,
+                      const std::function<bool()>& ready) {
+    if (timeout == portMAX_DELAY) {
+        queue->changed.wait(guard, ready);
+        return true;
+    }
+    return queue->changed.wait_for(guard, std::chrono::milliseconds(timeout), ready);
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t timeout) {
+    std::unique_lock<std::mutex> guard(queue->lock);
+    if (!waitQueue(queue, guard, timeout, [&] { return queue->items.size() < queue->length; })) return pdFALSE;
+    const uint8_t* bytes = (const uint8_t*)item;
+    queue->items.emplace_back(bytes, bytes + queue->itemSize);
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t timeout) {
+    std::unique_lock<std::mutex> guard(queue->lock);
+    if (!waitQueue(queue, guard, timeout, [&] { return !queue->items.empty(); })) return pdFALSE;
+    memcpy(item, queue->items.front().data(), queue->itemSize);
+    queue->items.pop_front();
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> guard(queue->lock);
+    return (UBaseType_t)queue->items.size();
+}
+
+// Như FreeRTOS: SetBits đánh thức mọi task đang chờ mà điều kiện thỏa tại thời
+// điểm set, bit clearOnExit chỉ bị xóa sau khi đã duyệt hết waiter. Nếu để
+// waiter tự xóa khi thức dậy, waiter đầu tiên nuốt bit của những task còn lại.
+struct host_event_waiter {
+    EventBits_t bits;
+    bool waitForAll;
+    bool clearOnExit;
+    bool woken = false;
+    EventBits_t result = 0;
+};
+
+struct host_event_group {
+    std::mutex lock;
+    std::condition_variable changed;
+    EventBits_t bits = 0;
+    std::vector<host_event_waiter*> waiters;
+};
+
+static bool eventSatisfied(EventBits_t current, EventBits_t bits, bool waitForAll) {
+    return waitForAll ? (current & bits) == bits : (current & bits) != 0;
+}
+
+EventGroupHandle_t xEventGroupCreate() { return new host_event_group; }
+void vEventGroupDelete(EventGroupHandle_t group) { delete group; }
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+    std::lock_guard<std::mutex> guard(group->lock);
+    group->bits |= bits;
+    EventBits_t result = group->bits;
+    EventBits_t clear = 0;
+    for (host_event_waiter* waiter : group->waiters) {
+        if (waiter->woken || !eventSatisfied(group->bits, waiter->bits, waiter->waitForAll)) continue;
+        waiter->woken = true;
+        waiter->result = group->bits;
+        if (waiter->clearOnExit) clear |= waiter->bits;
+    }
+    group->bits &= ~clear;
+    group->changed.notify_all();
+    return result;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+    std::lock_guard<std::mutex> guard(group->lock);
+    EventBits_t before = group->bits;
+    group->bits &= ~bits;
+    return before;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits,
+                                BaseType_t clearOnExit, BaseType_t waitForAll, TickType_t timeout) {
+    std::unique_lock<std::mutex> guard(group->lock);
+    if (eventSatisfied(group->bits, bits, waitForAll)) {
+        EventBits_t result = group->bits;
+        if (clearOnExit) group->bits &= ~bits;
+        return result;
+    }
+    if (timeout == 0) return group->bits;
+
+    host_event_waiter waiter{ bits, waitForAll != pdFALSE, clearOnExit != pdFALSE };
+    group->waiters.push_back(&waiter);
+    auto woken = [&] { return waiter.woken; };
+    if (timeout == portMAX_DELAY) {
+        group->changed.wait(guard, woken);
+    } else {
+        group->changed.wait_for(guard, std::chrono::milliseconds(timeout), woken);
+    }
+    group->waiters.erase(std::find(group->waiters.begin(), group->waiters.end(), &waiter));
+    return waiter.woken ? waiter.result : group->bits;
+}
+uint16_t hostListenPort(uint16_t port) {
+    if (port >= 1024) return port;
+    const char* env = getenv("HOST_PORT_OFFSET");
+    return (uint16_t)(port + (env ? atoi(env) : 8000));
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#ifndef HOST_HAL_H
+#define HOST_HAL_H
+
+#include <stdint.h>
+
+// Điều khiển HAL giả lập từ test, không có trên thiết bị
+
+// core mà xPortGetCoreID() trả về cho thread hiện tại (mặc định 0)
+void hostSetCoreId(int core);
+
+// đổi mức chân input (PIR...), gọi ISR đã attachInterrupt nếu khớp cạnh
+void hostSetPinLevel(int pin, int level);
+void hostSetAnalog(int pin, uint16_t value);
+
+// Cổng < 1024 (HTTP 80, RTSP 554) cần root trên Linux: server của host build
+// listen ở port + HOST_PORT_OFFSET (biến môi trường, mặc định 8000)
+uint16_t hostListenPort(uint16_t port);
+
+// message MQTT "từ broker", giao cho callback ở lần PubSubClient::loop() kế tiếp
+void hostMqttInject(const char* topic, const char* payload);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,14 @@
+#ifndef HOST_JPEG_H
+#define HOST_JPEG_H
+
+// libjpeg dùng chung cho decoder/encoder giả lập và camera giả lập
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// components = 3 (RGB) hoặc 1 (xám)
+bool hostJpegEncode(const uint8_t* pixels, int width, int height, int components, int quality,
+                    std::vector<uint8_t>& out);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,207 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Host stand-in for the subset of the Arduino-ESP32 core used by the firmware.
+// Only what the sketch and the host tests call is declared here.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+
+using std::min;
+using std::max;
+
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+#define IRAM_ATTR
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void yield();
+
+// GPIO giả lập: chân output giữ mức đã ghi, chân input đọc mức do hostSetPinLevel() đặt
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+int digitalPinToInterrupt(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode);
+void detachInterrupt(uint8_t pin);
+
+bool psramFound();
+uint32_t esp_random();
+
+class String {
+public:
+    String(const char* s = "") : _s(s ? s : "") {}
+    String(const std::string& s) : _s(s) {}
+    explicit String(char c) : _s(1, c) {}
+    String(int value, unsigned char base = 10);
+    String(unsigned int value, unsigned char base = 10);
+    String(long value, unsigned char base = 10);
+    String(unsigned long value, unsigned char base = 10);
+    String(long long value, unsigned char base = 10);
+    String(unsigned long long value, unsigned char base = 10);
+    String(double value, unsigned int decimals = 2);
+
+    const char* c_str() const { return _s.c_str(); }
+    unsigned int length() const { return (unsigned int)_s.size(); }
+    bool isEmpty() const { return _s.empty(); }
+    void reserve(unsigned int size) { _s.reserve(size); }
+
+    char operator[](unsigned int index) const { return index < _s.size() ? _s[index] : 0; }
+    char& operator[](unsigned int index) { return _s[index]; }
+    char charAt(unsigned int index) const { return (*this)[index]; }
+    void setCharAt(unsigned int index, char c) { if (index < _s.size()) _s[index] = c; }
+
+    String& operator+=(const String& rhs) { _s += rhs._s; return *this; }
+    String& operator+=(const char* rhs) { if (rhs) _s += rhs; return *this; }
+    String& operator+=(char c) { _s += c; return *this; }
+    String& operator+=(int value) { return *this += String(value); }
+    String& operator+=(unsigned int value) { return *this += String(value); }
+    String& operator+=(long value) { return *this += String(value); }
+    String& operator+=(unsigned long value) { return *this += String(value); }
+    bool concat(const String& rhs) { *this += rhs; return true; }
+
+    bool operator==(const String& rhs) const { return _s == rhs._s; }
+    bool operator==(const char* rhs) const { return _s == (rhs ? rhs : ""); }
+    bool operator!=(const String& rhs) const { return !(*this == rhs); }
+    bool operator!=(const char* rhs) const { return !(*this == rhs); }
+    bool operator<(const String& rhs) const { return _s < rhs._s; }
+    bool equals(const String& rhs) const { return *this == rhs; }
+    bool equalsIgnoreCase(const String& rhs) const;
+    bool startsWith(const String& prefix) const;
+    bool endsWith(const String& suffix) const;
+
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const String& s, unsigned int from = 0) const;
+    int lastIndexOf(char c) const;
+    int lastIndexOf(const String& s) const;
+    String substring(unsigned int from) const;
+    String substring(unsigned int from, unsigned int to) const;
+
+    void replace(const String& find, const String& with);
+    void remove(unsigned int index, unsigned int count = (unsigned int)-1);
+    void trim();
+    void toLowerCase();
+    void toUpperCase();
+    long toInt() const { return atol(_s.c_str()); }
+    float toFloat() const { return (float)atof(_s.c_str()); }
+
+    friend String operator+(const String& lhs, const String& rhs) { String r(lhs); r += rhs; return r; }
+    friend String operator+(const String& lhs, const char* rhs) { String r(lhs); r += rhs; return r; }
+    friend String operator+(const char* lhs, const String& rhs) { String r(lhs); r += rhs; return r; }
+    friend String operator+(const String& lhs, char rhs) { String r(lhs); r += rhs; return r; }
+    friend String operator+(const String& lhs, int rhs) { String r(lhs); r += rhs; return r; }
+    friend String operator+(const String& lhs, unsigned long rhs) { String r(lhs); r += rhs; return r; }
+
+private:
+    std::string _s;
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buf, size_t len);
+    size_t write(const char* s) { return s ? write((const uint8_t*)s, strlen(s)) : 0; }
+
+    size_t print(const char* s) { return write(s); }
+    size_t print(const String& s) { return write((const uint8_t*)s.c_str(), s.length()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int value) { return print(String(value)); }
+    size_t print(unsigned int value) { return print(String(value)); }
+    size_t print(long value) { return print(String(value)); }
+    size_t print(unsigned long value) { return print(String(value)); }
+    size_t print(double value, int decimals = 2) { return print(String(value, decimals)); }
+    size_t println() { return write("\r\n"); }
+    template <typename T> size_t println(const T& value) { size_t n = print(value); return n + println(); }
+    size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() { return -1; }
+    void setTimeout(unsigned long timeoutMs) { _timeout = timeoutMs; }
+    size_t readBytes(uint8_t* buf, size_t len);
+    size_t readBytes(char* buf, size_t len) { return readBytes((uint8_t*)buf, len); }
+    String readStringUntil(char terminator);
+
+protected:
+    unsigned long _timeout = 1000;
+};
+
+#define SERIAL_8N1 0x800001c
+
+// UART 0 là stdout của tiến trình; UART khác (modem SIM) không nối đi đâu,
+// ghi bị bỏ và không bao giờ có byte để đọc
+class HardwareSerial : public Stream {
+public:
+    HardwareSerial(int uart = 0) : _uart(uart) {}
+    void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1) {}
+    void end() {}
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buf, size_t len) override;
+    using Print::write;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    void flush() { if (_uart == 0) fflush(stdout); }
+    operator bool() const { return true; }
+
+private:
+    int _uart;
+};
+extern HardwareSerial Serial;
+
+class IPAddress {
+public:
+    IPAddress() : _addr(0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+        : _addr((uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24)) {}
+    IPAddress(uint32_t addr) : _addr(addr) {}     // thứ tự byte mạng như lwIP
+    operator uint32_t() const { return _addr; }
+    uint8_t operator[](int index) const { return (uint8_t)(_addr >> (index * 8)); }
+    bool operator==(const IPAddress& rhs) const { return _addr == rhs._addr; }
+    bool operator!=(const IPAddress& rhs) const { return _addr != rhs._addr; }
+    String toString() const;
+
+private:
+    uint32_t _addr;
+};
+
+// Chu kỳ CPU giả lập từ đồng hồ monotonic ở HOST_CPU_FREQ_MHZ
+#define HOST_CPU_FREQ_MHZ 240
+
+class EspClass {
+public:
+    uint32_t getCycleCount();
+    uint32_t getCpuFreqMHz() { return HOST_CPU_FREQ_MHZ; }
+    uint32_t getFreeHeap();
+    uint32_t getMinFreeHeap();
+    uint32_t getFreePsram();
+    void restart();
+};
+extern EspClass ESP;
+
+#endif
\ No newline at end of file
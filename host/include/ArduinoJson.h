@@ -0,0 +1,300 @@
+#ifndef HOST_ARDUINOJSON_H
+#define HOST_ARDUINOJSON_H
+
+// ArduinoJson tối thiểu cho host: document là một object phẳng (chuỗi, số,
+// bool), đủ cho payload MQTT của firmware. Object/array lồng nhau khi parse
+// được bỏ qua, đọc ra như null.
+#include <Arduino.h>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class JsonDocument {
+public:
+    struct Value {
+        enum Type { Null, Text, Number, Bool } type = Null;
+        std::string text;
+        double number = 0;
+    };
+
+    Value* find(const char* key) {
+        for (auto& member : _members) {
+            if (member.first == key) return &member.second;
+        }
+        return nullptr;
+    }
+
+    Value& slot(const char* key) {
+        Value* value = find(key);
+        if (value) return *value;
+        _members.emplace_back(key, Value());
+        return _members.back().second;
+    }
+
+    void clear() { _members.clear(); }
+    const std::vector<std::pair<std::string, Value>>& members() const { return _members; }
+
+    class Variant {
+    public:
+        Variant(JsonDocument* doc, const char* key) : _doc(doc), _key(key) {}
+
+        Variant& operator=(const char* text) {
+            Value& v = _doc->slot(_key.c_str());
+            v.type = text ? Value::Text : Value::Null;
+            v.text = text ? text : "";
+            return *this;
+        }
+        Variant& operator=(const String& text) { return *this = text.c_str(); }
+        Variant& operator=(bool flag) {
+            Value& v = _doc->slot(_key.c_str());
+            v.type = Value::Bool;
+            v.number = flag ? 1 : 0;
+            return *this;
+        }
+        template <typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value>::type>
+        Variant& operator=(T number) {
+            Value& v = _doc->slot(_key.c_str());
+            v.type = Value::Number;
+            v.number = (double)number;
+            return *this;
+        }
+
+        const char* operator|(const char* fallback) const {
+            Value* v = _doc->find(_key.c_str());
+            return v && v->type == Value::Text ? v->text.c_str() : fallback;
+        }
+        double operator|(double fallback) const {
+            Value* v = _doc->find(_key.c_str());
+            return v && (v->type == Value::Number || v->type == Value::Bool) ? v->number : fallback;
+        }
+        long operator|(int fallback) const {
+            Value* v = _doc->find(_key.c_str());
+            return v && (v->type == Value::Number || v->type == Value::Bool) ? (long)v->number : fallback;
+        }
+        bool isNull() const {
+            Value* v = _doc->find(_key.c_str());
+            return !v || v->type == Value::Null;
+        }
+
+    private:
+        JsonDocument* _doc;
+        std::string _key;
+    };
+
+    Variant operator[](const char* key) { return Variant(this, key); }
+
+private:
+    std::vector<std::pair<std::string, Value>> _members;
+};
+
+typedef JsonDocument::Variant JsonVariant;
+
+template <size_t Capacity>
+class StaticJsonDocument : public JsonDocument {};
+
+class DeserializationError {
+public:
+    enum Code { Ok, EmptyInput, InvalidInput };
+    DeserializationError(Code code = Ok) : _code(code) {}
+    explicit operator bool() const { return _code != Ok; }
+    Code code() const { return _code; }
+    const char* c_str() const { return _code == Ok ? "Ok" : _code == EmptyInput ? "EmptyInput" : "InvalidInput"; }
+
+private:
+    Code _code;
+};
+
+namespace host_json {
+
+inline void skipSpace(const char*& p) {
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+}
+
+inline bool parseString(const char*& p, std::string& out) {
+    if (*p != '"') return false;
+    p++;
+    while (*p && *p != '"') {
+        if (*p == '\\') {
+            p++;
+            switch (*p) {
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                case 'r': out += '\r'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u': out += '?'; p += 4; continue;   // không cần Unicode escape
+                case '\0': return false;
+                default: out += *p; break;
+            }
+            p++;
+            continue;
+        }
+        out += *p++;
+    }
+    if (*p != '"') return false;
+    p++;
+    return true;
+}
+
+// bỏ qua một giá trị bất kỳ (kể cả object/array lồng nhau)
+inline bool skipValue(const char*& p) {
+    skipSpace(p);
+    if (*p == '"') {
+        std::string ignored;
+        return parseString(p, ignored);
+    }
+    if (*p == '{' || *p == '[') {
+        char close = *p == '{' ? '}' : ']';
+        p++;
+        skipSpace(p);
+        if (*p == close) {
+            p++;
+            return true;
+        }
+        for (;;) {
+            if (close == '}') {
+                std::string key;
+                skipSpace(p);
+                if (!parseString(p, key)) return false;
+                skipSpace(p);
+                if (*p++ != ':') return false;
+            }
+            if (!skipValue(p)) return false;
+            skipSpace(p);
+            if (*p == ',') {
+                p++;
+                continue;
+            }
+            if (*p != close) return false;
+            p++;
+            return true;
+        }
+    }
+    const char* start = p;
+    while (*p && *p != ',' && *p != '}' && *p != ']' && *p != ' ' && *p != '\r' && *p != '\n' && *p != '\t') p++;
+    return p != start;
+}
+
+inline bool parseValue(const char*& p, JsonDocument::Value& value) {
+    skipSpace(p);
+    if (*p == '"') {
+        value.type = JsonDocument::Value::Text;
+        return parseString(p, value.text);
+    }
+    if (*p == '{' || *p == '[') {
+        value.type = JsonDocument::Value::Null;
+        return skipValue(p);
+    }
+    if (strncmp(p, "true", 4) == 0 || strncmp(p, "false", 5) == 0) {
+        value.type = JsonDocument::Value::Bool;
+        value.number = *p == 't';
+        p += *p == 't' ? 4 : 5;
+        return true;
+    }
+    if (strncmp(p, "null", 4) == 0) {
+        value.type = JsonDocument::Value::Null;
+        p += 4;
+        return true;
+    }
+    char* end = nullptr;
+    value.number = strtod(p, &end);
+    if (end == p) return false;
+    value.type = JsonDocument::Value::Number;
+    p = end;
+    return true;
+}
+
+inline void appendEscaped(std::string& out, const std::string& text) {
+    out += '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if ((unsigned char)c < 0x20) {
+            char esc[8];
+            snprintf(esc, sizeof(esc), "\\u%04x", (unsigned char)c);
+            out += esc;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+inline std::string serialize(const JsonDocument& doc) {
+    std::string out = "{";
+    bool first = true;
+    for (const auto& member : doc.members()) {
+        if (!first) out += ',';
+        first = false;
+        appendEscaped(out, member.first);
+        out += ':';
+        const JsonDocument::Value& v = member.second;
+        char num[32];
+        switch (v.type) {
+            case JsonDocument::Value::Null: out += "null"; break;
+            case JsonDocument::Value::Text: appendEscaped(out, v.text); break;
+            case JsonDocument::Value::Bool: out += v.number ? "true" : "false"; break;
+            case JsonDocument::Value::Number:
+                if (v.number == (double)(long long)v.number) snprintf(num, sizeof(num), "%lld", (long long)v.number);
+                else snprintf(num, sizeof(num), "%.9g", v.number);
+                out += num;
+                break;
+        }
+    }
+    out += '}';
+    return out;
+}
+
+}  // namespace host_json
+
+inline DeserializationError deserializeJson(JsonDocument& doc, const char* input) {
+    doc.clear();
+    if (!input || !*input) return DeserializationError::EmptyInput;
+    const char* p = input;
+    host_json::skipSpace(p);
+    if (*p++ != '{') return DeserializationError::InvalidInput;
+    host_json::skipSpace(p);
+    if (*p == '}') return DeserializationError::Ok;
+    for (;;) {
+        std::string key;
+        host_json::skipSpace(p);
+        if (!host_json::parseString(p, key)) return DeserializationError::InvalidInput;
+        host_json::skipSpace(p);
+        if (*p++ != ':') return DeserializationError::InvalidInput;
+        if (!host_json::parseValue(p, doc.slot(key.c_str()))) return DeserializationError::InvalidInput;
+        host_json::skipSpace(p);
+        if (*p == ',') {
+            p++;
+            continue;
+        }
+        return *p == '}' ? DeserializationError::Ok : DeserializationError::InvalidInput;
+    }
+}
+
+inline DeserializationError deserializeJson(JsonDocument& doc, const String& input) {
+    return deserializeJson(doc, input.c_str());
+}
+
+// như ArduinoJson: cắt bớt khi buffer nhỏ, luôn kết thúc bằng '\0', trả số byte đã ghi
+inline size_t serializeJson(const JsonDocument& doc, char* buffer, size_t size) {
+    if (size == 0) return 0;
+    std::string out = host_json::serialize(doc);
+    size_t n = std::min(out.size(), size - 1);
+    memcpy(buffer, out.data(), n);
+    buffer[n] = '\0';
+    return n;
+}
+
+template <size_t N>
+inline size_t serializeJson(const JsonDocument& doc, char (&buffer)[N]) {
+    return serializeJson(doc, buffer, N);
+}
+
+inline size_t serializeJson(const JsonDocument& doc, String& output) {
+    output = String(host_json::serialize(doc));
+    return output.length();
+}
+
+#endif
\ No newline at end of file
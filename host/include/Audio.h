@@ -0,0 +1,17 @@
+#ifndef HOST_AUDIO_H
+#define HOST_AUDIO_H
+
+// Không có I2S: file được "phát" xong ngay, chỉ ghi log tên file
+#include <SD.h>
+
+class Audio {
+public:
+    bool setPinout(uint8_t bclk, uint8_t lrc, uint8_t dout) { return true; }
+    void setVolume(uint8_t volume) {}
+    bool connecttoFS(SDFS& fs, const char* path);
+    bool isRunning() const { return false; }
+    uint32_t stopSong() { return 0; }
+    void loop() {}
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,88 @@
+#ifndef HOST_BLYNK_SIMPLE_ESP32_H
+#define HOST_BLYNK_SIMPLE_ESP32_H
+
+// Blynk trên host không có cloud: connect() luôn thất bại nên firmware chạy
+// như khi mất Internet. BlynkTimer chạy thật vì servo dùng nó.
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+
+#define V0 0
+#define V1 1
+#define V2 2
+#define V3 3
+#define V4 4
+#define V5 5
+#define V6 6
+#define V7 7
+#define V8 8
+#define V9 9
+#define V10 10
+#define V11 11
+#define V12 12
+#define V13 13
+#define V14 14
+#define V15 15
+
+class BlynkParam {
+public:
+    explicit BlynkParam(const char* value = "") : _value(value) {}
+    int asInt() const { return atoi(_value); }
+    double asDouble() const { return atof(_value); }
+    const char* asStr() const { return _value; }
+
+private:
+    const char* _value;
+};
+
+struct BlynkReq {
+    uint8_t pin;
+};
+
+#define BLYNK_CONCAT(a, b) a##b
+#define BLYNK_CONCAT2(a, b) BLYNK_CONCAT(a, b)
+#define BLYNK_WRITE(pin) void BLYNK_CONCAT2(BlynkWidgetWrite, pin)(BlynkReq & request, const BlynkParam & param)
+#define BLYNK_CONNECTED() void BlynkOnConnected()
+#define BLYNK_DISCONNECTED() void BlynkOnDisconnected()
+
+class BlynkHost {
+public:
+    void config(const char* auth, const char* domain = "blynk.cloud", uint16_t port = 80) {}
+    bool connect(unsigned long timeoutMs = 18000) { return false; }
+    bool connected() const { return false; }
+    void disconnect() {}
+    void run() {}
+    void syncAll() {}
+    void virtualWrite(int pin, int value) {}
+    void logEvent(const char* event, const char* description = "") {}
+};
+extern BlynkHost Blynk;
+
+class BlynkTimer {
+public:
+    typedef void (*timer_callback)();
+
+    int setInterval(unsigned long intervalMs, timer_callback callback) {
+        _timers.push_back(Timer{ intervalMs, millis(), callback });
+        return (int)_timers.size() - 1;
+    }
+
+    void run() {
+        unsigned long now = millis();
+        for (auto& timer : _timers) {
+            if (now - timer.last < timer.interval) continue;
+            timer.last = now;
+            timer.callback();
+        }
+    }
+
+private:
+    struct Timer {
+        unsigned long interval;
+        unsigned long last;
+        timer_callback callback;
+    };
+    std::vector<Timer> _timers;
+};
+
+#endif
\ No newline at end of file
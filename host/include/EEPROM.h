@@ -0,0 +1,26 @@
+#ifndef HOST_EEPROM_H
+#define HOST_EEPROM_H
+
+// EEPROM trong RAM, mới mỗi lần chạy (toàn 0xFF như flash đã xóa)
+#include <Arduino.h>
+#include <vector>
+
+class EEPROMClass {
+public:
+    bool begin(size_t size) {
+        if (_data.size() < size) _data.resize(size, 0xFF);
+        return true;
+    }
+    uint8_t read(int address) const { return address >= 0 && address < (int)_data.size() ? _data[address] : 0; }
+    void write(int address, uint8_t value) {
+        if (address >= 0 && address < (int)_data.size()) _data[address] = value;
+    }
+    bool commit() { return true; }
+    size_t length() const { return _data.size(); }
+
+private:
+    std::vector<uint8_t> _data;
+};
+extern EEPROMClass EEPROM;
+
+#endif
\ No newline at end of file
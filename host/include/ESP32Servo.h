@@ -0,0 +1,21 @@
+#ifndef HOST_ESP32SERVO_H
+#define HOST_ESP32SERVO_H
+
+#include <Arduino.h>
+
+// Servo không có PWM thật, chỉ giữ góc cuối cùng
+class Servo {
+public:
+    void setPeriodHertz(int hertz) {}
+    int attach(int pin) { _pin = pin; return 1; }
+    void detach() { _pin = -1; }
+    bool attached() const { return _pin >= 0; }
+    void write(int angle) { _angle = angle; }
+    int read() const { return _angle; }
+
+private:
+    int _pin = -1;
+    int _angle = 90;
+};
+
+#endif
\ No newline at end of file
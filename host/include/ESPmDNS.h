@@ -0,0 +1,15 @@
+#ifndef HOST_ESPMDNS_H
+#define HOST_ESPMDNS_H
+
+#include <Arduino.h>
+
+// mDNS không quảng bá gì trên host, truy cập bằng IP in ra ở log
+class MDNSResponder {
+public:
+    bool begin(const char* hostName) { return true; }
+    void end() {}
+    bool addService(const char* service, const char* proto, uint16_t port) { return true; }
+};
+extern MDNSResponder MDNS;
+
+#endif
\ No newline at end of file
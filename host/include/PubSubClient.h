@@ -0,0 +1,40 @@
+#ifndef HOST_PUBSUBCLIENT_H
+#define HOST_PUBSUBCLIENT_H
+
+// Broker MQTT giả lập trong tiến trình: connect() luôn thành công, publish()
+// in ra log, message cho topic đã subscribe được đưa vào bằng hostMqttInject()
+// (host_hal.h) và giao cho callback ở loop() như khi đọc từ socket.
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+#define MQTT_CONNECTED 0
+#define MQTT_DISCONNECTED -1
+
+class PubSubClient {
+public:
+    typedef std::function<void(char*, uint8_t*, unsigned int)> MQTT_CALLBACK_SIGNATURE_T;
+
+    PubSubClient(WiFiClient& client) {}
+
+    PubSubClient& setServer(const char* domain, uint16_t port);
+    PubSubClient& setCallback(MQTT_CALLBACK_SIGNATURE_T callback) { _callback = callback; return *this; }
+
+    bool connect(const char* id, const char* user = nullptr, const char* pass = nullptr);
+    void disconnect() { _connected = false; }
+    bool connected() const { return _connected; }
+    int state() const { return _connected ? MQTT_CONNECTED : MQTT_DISCONNECTED; }
+
+    bool subscribe(const char* topic);
+    bool publish(const char* topic, const char* payload, bool retained = false);
+    bool loop();
+
+private:
+    MQTT_CALLBACK_SIGNATURE_T _callback;
+    std::vector<std::string> _topics;
+    bool _connected = false;
+};
+
+#endif
\ No newline at end of file
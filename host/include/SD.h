@@ -0,0 +1,69 @@
+#ifndef HOST_SD_H
+#define HOST_SD_H
+
+// Thẻ SD là một thư mục của host (HOST_SD_DIR, mặc định ./host_sd),
+// đường dẫn "/events/x.avi" nằm dưới thư mục đó
+#include <Arduino.h>
+#include <memory>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+typedef enum { CARD_NONE, CARD_MMC, CARD_SD, CARD_SDHC, CARD_UNKNOWN } sdcard_type_t;
+
+class File : public Stream {
+public:
+    File() {}
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t len) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    size_t read(uint8_t* buf, size_t len);
+    int peek() override;
+    bool seek(uint32_t pos);
+    size_t position() const;
+    size_t size() const;
+    void flush();
+    void close() { _impl.reset(); }
+    operator bool() const { return (bool)_impl; }
+
+    bool isDirectory() const;
+    File openNextFile(const char* mode = FILE_READ);
+    const char* name() const;
+    const char* path() const;
+
+    struct Impl;
+
+private:
+    friend class SDFS;
+    std::shared_ptr<Impl> _impl;
+};
+
+class SDFS {
+public:
+    bool begin(uint8_t ssPin = 5);
+    void end() {}
+    sdcard_type_t cardType() const { return _mounted ? CARD_SDHC : CARD_NONE; }
+    uint64_t cardSize() const;
+    uint64_t totalBytes() const;
+    uint64_t usedBytes() const;
+
+    File open(const char* path, const char* mode = FILE_READ);
+    File open(const String& path, const char* mode = FILE_READ) { return open(path.c_str(), mode); }
+    bool exists(const char* path) const;
+    bool exists(const String& path) const { return exists(path.c_str()); }
+    bool mkdir(const char* path);
+    bool remove(const char* path);
+    bool rmdir(const char* path);
+
+private:
+    std::string hostPath(const char* path) const;
+    std::string _root;
+    bool _mounted = false;
+};
+extern SDFS SD;
+
+#endif
\ No newline at end of file
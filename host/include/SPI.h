@@ -0,0 +1,14 @@
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+// Bus SPI chỉ có SD dùng, SD trên host là thư mục nên không cần bus thật
+#include <Arduino.h>
+
+class SPIClass {
+public:
+    void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1) {}
+    void end() {}
+};
+extern SPIClass SPI;
+
+#endif
\ No newline at end of file
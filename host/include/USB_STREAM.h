@@ -0,0 +1,62 @@
+#ifndef HOST_USB_STREAM_H
+#define HOST_USB_STREAM_H
+
+// Camera UVC giả lập: một thread phát lại các file JPEG trong HOST_CAMERA_DIR
+// (theo thứ tự tên, lặp vòng) với chu kỳ frame_interval, copy vào frame buffer
+// rồi gọi callback như driver thật. Không có thư mục thì phát khung hình tổng
+// hợp đúng độ phân giải đang cấu hình.
+#include <Arduino.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef struct {
+    uint8_t* data;
+    size_t data_bytes;
+    uint32_t width;
+    uint32_t height;
+    uint32_t sequence;
+} uvc_frame_t;
+
+typedef void(uvc_frame_callback_t)(uvc_frame_t* frame, void* arg);
+
+class USB_STREAM {
+public:
+    ~USB_STREAM() { stop(); }
+
+    // frame_interval tính bằng đơn vị 100 ns như UVC
+    void uvcConfiguration(uint16_t width, uint16_t height, uint32_t frameInterval,
+                          uint32_t transferBufferSize, uint8_t* transferBufferA, uint8_t* transferBufferB,
+                          uint32_t frameBufferSize, uint8_t* frameBuffer);
+    void uvcCamRegisterCb(uvc_frame_callback_t* callback, void* arg);
+    void start();
+    void stop();
+    void uvcCamSuspend(void* ctrlValue);
+    void uvcCamResume(void* ctrlValue);
+    void uvcCamFrameReset(uint16_t width, uint16_t height, uint32_t frameInterval);
+
+private:
+    void run();
+    void loadFrames();
+
+    std::mutex _lock;
+    std::thread _thread;
+    std::atomic<bool> _running{false};
+    bool _suspended = false;
+
+    uint16_t _width = 0;
+    uint16_t _height = 0;
+    uint32_t _interval = 333333;
+    uint8_t* _frameBuf = nullptr;
+    uint32_t _frameBufSize = 0;
+    uvc_frame_callback_t* _callback = nullptr;
+    void* _callbackArg = nullptr;
+
+    std::vector<std::vector<uint8_t>> _frames;
+    bool _synthetic = false;
+    uint16_t _framesWidth = 0;
+    uint16_t _framesHeight = 0;
+};
+
+#endif
\ No newline at end of file
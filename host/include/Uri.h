@@ -0,0 +1,23 @@
+#ifndef HOST_URI_H
+#define HOST_URI_H
+
+#include <Arduino.h>
+#include <vector>
+
+// Khớp đường dẫn cho WebServer::on(), cùng giao diện với Arduino-ESP32
+class Uri {
+public:
+    Uri(const char* uri) : _uri(uri) {}
+    Uri(const String& uri) : _uri(uri) {}
+    virtual ~Uri() {}
+
+    virtual Uri* clone() const { return new Uri(_uri); }
+    virtual bool canHandle(const String& requestUri, std::vector<String>& pathArgs) {
+        return _uri == requestUri;
+    }
+
+protected:
+    const String _uri;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,87 @@
+#ifndef HOST_WEB_SERVER_H
+#define HOST_WEB_SERVER_H
+
+// HTTP/1.1 server tối thiểu trên WiFiServer, cùng luồng xử lý với WebServer
+// của Arduino-ESP32: handleClient() nhận một request, gọi handler rồi bỏ
+// tham chiếu tới client. Handler giữ bản copy của client() (stream, WebSocket,
+// tải clip) thì socket vẫn mở cho tới khi bản copy đó stop().
+#include <WiFi.h>
+#include "Uri.h"
+
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+#define CONTENT_LENGTH_NOT_SET ((size_t)-2)
+
+class WebServer {
+public:
+    typedef std::function<void(void)> THandlerFunction;
+
+    WebServer(int port = 80) : _server(port) {}
+
+    void begin();
+    void stop();
+    void handleClient();
+
+    void on(const Uri& uri, THandlerFunction handler) { on(uri, HTTP_ANY, handler); }
+    void on(const Uri& uri, HTTPMethod method, THandlerFunction handler);
+    void onNotFound(THandlerFunction handler) { _notFound = handler; }
+    void collectHeaders(const char* headerKeys[], size_t count);
+
+    WiFiClient client() { return _client; }
+    String uri() const { return _uri; }
+    HTTPMethod method() const { return _method; }
+
+    String arg(const String& name) const;
+    String arg(int index) const;
+    String argName(int index) const;
+    int args() const { return (int)_args.size(); }
+    bool hasArg(const String& name) const;
+    String pathArg(unsigned int index) const;
+    String header(const String& name) const;
+    bool hasHeader(const String& name) const;
+
+    void sendHeader(const String& name, const String& value, bool first = false);
+    void setContentLength(size_t length) { _contentLength = length; }
+    void send(int code, const char* contentType = nullptr, const String& content = String(""));
+    void send(int code, const String& contentType, const String& content) {
+        send(code, contentType.c_str(), content);
+    }
+    void sendContent(const String& content) { sendContent(content.c_str(), content.length()); }
+    void sendContent(const char* content, size_t len);
+
+private:
+    struct Route {
+        std::unique_ptr<Uri> uri;
+        HTTPMethod method;
+        THandlerFunction handler;
+    };
+    typedef std::pair<String, String> KeyValue;
+
+    bool readRequest();
+    void parseArgs(const String& data);
+    void writeAll(const char* data, size_t len);
+
+    WiFiServer _server;
+    std::vector<Route> _routes;
+    THandlerFunction _notFound;
+    std::vector<String> _collect;
+
+    WiFiClient _client;
+    HTTPMethod _method = HTTP_ANY;
+    String _uri;
+    std::vector<KeyValue> _args;
+    std::vector<KeyValue> _headers;
+    std::vector<String> _pathArgs;
+    std::vector<KeyValue> _responseHeaders;
+    size_t _contentLength = CONTENT_LENGTH_NOT_SET;
+    bool _chunked = false;
+    bool _headersSent = false;
+};
+
+#endif
\ No newline at end of file
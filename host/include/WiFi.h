@@ -0,0 +1,66 @@
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+// Wi-Fi giả lập: STA luôn kết nối được ngay (mạng của máy host), AP chỉ ghi
+// lại cấu hình. Socket đi qua WiFiClient/WiFiServer trên POSIX.
+#include <Arduino.h>
+#include "WiFiClient.h"
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_DISCONNECTED = 6,
+} wl_status_t;
+
+typedef enum {
+    WIFI_AUTH_OPEN = 0,
+    WIFI_AUTH_WEP,
+    WIFI_AUTH_WPA_PSK,
+    WIFI_AUTH_WPA2_PSK,
+    WIFI_AUTH_WPA_WPA2_PSK,
+} wifi_auth_mode_t;
+
+typedef enum {
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+    WIFI_AP = 2,
+    WIFI_AP_STA = 3,
+} wifi_mode_t;
+
+class WiFiClass {
+public:
+    bool mode(wifi_mode_t mode) { _mode = mode; return true; }
+    wifi_mode_t getMode() const { return _mode; }
+
+    wl_status_t begin(const char* ssid, const char* password = nullptr);
+    bool disconnect(bool wifiOff = false);
+    wl_status_t status() const { return _status; }
+    IPAddress localIP() const;
+    bool setAutoReconnect(bool enable) { return true; }
+    bool persistent(bool enable) { return true; }
+    bool setSleep(bool enable) { return true; }
+
+    bool softAPConfig(IPAddress ip, IPAddress gateway, IPAddress subnet);
+    bool softAP(const char* ssid, const char* password = nullptr, int channel = 1,
+                int hidden = 0, int maxConnection = 4);
+    bool softAPdisconnect(bool wifiOff = false);
+    IPAddress softAPIP() const { return _apIp; }
+
+    // một mạng duy nhất: mạng của host
+    int16_t scanNetworks(bool async = false, bool showHidden = false, bool passive = false,
+                         uint32_t maxMsPerChannel = 300);
+    String SSID(uint8_t index = 0) const;
+    int32_t RSSI(uint8_t index = 0) const { return -40; }
+    wifi_auth_mode_t encryptionType(uint8_t index) const { return WIFI_AUTH_WPA2_PSK; }
+
+private:
+    wifi_mode_t _mode = WIFI_STA;
+    wl_status_t _status = WL_DISCONNECTED;
+    String _ssid;
+    IPAddress _apIp;
+};
+extern WiFiClass WiFi;
+
+#endif
\ No newline at end of file
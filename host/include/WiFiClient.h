@@ -0,0 +1,57 @@
+#ifndef HOST_WIFI_CLIENT_H
+#define HOST_WIFI_CLIENT_H
+
+#include <Arduino.h>
+#include <memory>
+
+// Socket TCP POSIX, chia sẻ giữa các bản copy như WiFiClient của Arduino-ESP32:
+// fd chỉ bị đóng khi bản copy cuối cùng bị hủy hoặc stop()
+class WiFiClient : public Stream {
+public:
+    WiFiClient() {}
+    explicit WiFiClient(int fd);
+
+    int connect(const char* host, uint16_t port);
+    bool connected();
+    void stop();
+    int fd() const;
+    operator bool() { return connected(); }
+
+    IPAddress remoteIP() const;
+    uint16_t remotePort() const;
+    IPAddress localIP() const;
+    int setNoDelay(bool noDelay);
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t len) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int read(uint8_t* buf, size_t len);
+    int peek() override;
+
+private:
+    struct Socket;
+    std::shared_ptr<Socket> _socket;
+};
+
+class WiFiServer {
+public:
+    WiFiServer(uint16_t port = 80) : _port(port) {}
+    ~WiFiServer() { stop(); }
+
+    void begin(uint16_t port = 0);
+    void stop();
+    // không chặn: client đang chờ accept, hoặc WiFiClient rỗng
+    WiFiClient available();
+    WiFiClient accept() { return available(); }
+    void setNoDelay(bool noDelay) { _noDelay = noDelay; }
+    operator bool() const { return _listenFd >= 0; }
+
+private:
+    uint16_t _port;
+    int _listenFd = -1;
+    bool _noDelay = false;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,10 @@
+#ifndef HOST_DRIVER_GPIO_H
+#define HOST_DRIVER_GPIO_H
+
+#include <Arduino.h>
+
+typedef int gpio_num_t;
+
+static inline int gpio_get_level(gpio_num_t pin) { return digitalRead(pin); }
+
+#endif
\ No newline at end of file
@@ -0,0 +1,22 @@
+#ifndef HOST_ESP_HEAP_CAPS_H
+#define HOST_ESP_HEAP_CAPS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_DMA      (1 << 3)
+
+// Trên host mọi vùng nhớ là heap thường
+static inline void* heap_caps_malloc(size_t size, uint32_t) { return malloc(size); }
+static inline void heap_caps_free(void* ptr) { free(ptr); }
+
+static inline void* heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t) {
+    // aligned_alloc cần size là bội của alignment
+    return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,9 @@
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+
+#include <stdint.h>
+
+// us kể từ lúc tiến trình chạy, như esp_timer tính từ lúc boot
+int64_t esp_timer_get_time();
+
+#endif
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+// FreeRTOS trên host: task là pthread, tick 1 ms, critical section là spinlock.
+// Không có scheduler thật nên ưu tiên và core pinning bị bỏ qua.
+
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define portNUM_PROCESSORS 2
+
+typedef struct {
+    volatile int locked;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED {0}
+
+void vPortEnterCritical(portMUX_TYPE* mux);
+void vPortExitCritical(portMUX_TYPE* mux);
+
+#define portENTER_CRITICAL(mux) vPortEnterCritical(mux)
+#define portEXIT_CRITICAL(mux) vPortExitCritical(mux)
+#define portENTER_CRITICAL_ISR(mux) vPortEnterCritical(mux)
+#define portEXIT_CRITICAL_ISR(mux) vPortExitCritical(mux)
+
+// core của thread hiện tại, test đặt bằng hostSetCoreId() (host_hal.h)
+BaseType_t xPortGetCoreID();
+
+#endif
\ No newline at end of file
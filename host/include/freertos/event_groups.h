@@ -0,0 +1,16 @@
+#ifndef HOST_FREERTOS_EVENT_GROUPS_H
+#define HOST_FREERTOS_EVENT_GROUPS_H
+
+#include "FreeRTOS.h"
+
+typedef struct host_event_group* EventGroupHandle_t;
+typedef uint32_t EventBits_t;
+
+EventGroupHandle_t xEventGroupCreate();
+void vEventGroupDelete(EventGroupHandle_t group);
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits,
+                                BaseType_t clearOnExit, BaseType_t waitForAll, TickType_t timeout);
+
+#endif
\ No newline at end of file
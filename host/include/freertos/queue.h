@@ -0,0 +1,15 @@
+#ifndef HOST_FREERTOS_QUEUE_H
+#define HOST_FREERTOS_QUEUE_H
+
+#include "FreeRTOS.h"
+
+typedef struct host_queue* QueueHandle_t;
+
+// Queue copy theo giá trị như FreeRTOS, mutex + condition variable
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+void vQueueDelete(QueueHandle_t queue);
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t timeout);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t timeout);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,20 @@
+#ifndef HOST_FREERTOS_TASK_H
+#define HOST_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef struct host_task* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+// Task là pthread detached; stack và priority bị bỏ qua, core chỉ đặt
+// giá trị xPortGetCoreID() trả về trong task
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                                   void* arg, UBaseType_t priority, TaskHandle_t* handle, BaseType_t core);
+// chỉ hỗ trợ task tự xóa (NULL), như mọi chỗ firmware gọi
+void vTaskDelete(TaskHandle_t task);
+
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t* previousWake, TickType_t period);
+TickType_t xTaskGetTickCount();
+
+#endif
\ No newline at end of file
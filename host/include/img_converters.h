@@ -0,0 +1,22 @@
+#ifndef HOST_IMG_CONVERTERS_H
+#define HOST_IMG_CONVERTERS_H
+
+// Encoder JPEG của esp32-camera trên libjpeg; RGB888 đọc theo thứ tự BGR như trên chip
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    PIXFORMAT_RGB565,
+    PIXFORMAT_YUV422,
+    PIXFORMAT_YUV420,
+    PIXFORMAT_GRAYSCALE,
+    PIXFORMAT_JPEG,
+    PIXFORMAT_RGB888,
+} pixformat_t;
+
+typedef size_t (*jpg_out_cb)(void* arg, size_t index, const void* data, size_t len);
+
+bool fmt2jpg_cb(uint8_t* src, size_t src_len, uint16_t width, uint16_t height, pixformat_t format,
+                uint8_t quality, jpg_out_cb cb, void* arg);
+
+#endif
\ No newline at end of file
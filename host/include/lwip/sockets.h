@@ -0,0 +1,64 @@
+#ifndef HOST_LWIP_SOCKETS_H
+#define HOST_LWIP_SOCKETS_H
+
+// lwIP socket API trên socket POSIX. Ghi dùng MSG_NOSIGNAL: peer đóng kết nối
+// thì trả EPIPE như lwIP thay vì SIGPIPE cả tiến trình.
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "host_hal.h"
+
+static inline int lwip_socket(int domain, int type, int protocol) { return socket(domain, type, protocol); }
+static inline int lwip_close(int fd) { return close(fd); }
+static inline int lwip_fcntl(int fd, int cmd, int value) { return fcntl(fd, cmd, value); }
+
+// cổng đặc quyền được dời như WiFiServer (hostListenPort)
+static inline int lwip_bind(int fd, const struct sockaddr* addr, socklen_t len) {
+    if (addr->sa_family == AF_INET && len >= (socklen_t)sizeof(struct sockaddr_in)) {
+        struct sockaddr_in mapped = *(const struct sockaddr_in*)addr;
+        mapped.sin_port = htons(hostListenPort(ntohs(mapped.sin_port)));
+        return bind(fd, (const struct sockaddr*)&mapped, sizeof(mapped));
+    }
+    return bind(fd, addr, len);
+}
+
+static inline ssize_t lwip_recv(int fd, void* buf, size_t len, int flags) { return recv(fd, buf, len, flags); }
+
+static inline ssize_t lwip_recvfrom(int fd, void* buf, size_t len, int flags, struct sockaddr* from, socklen_t* fromLen) {
+    return recvfrom(fd, buf, len, flags, from, fromLen);
+}
+
+static inline ssize_t lwip_send(int fd, const void* buf, size_t len, int flags) {
+    return send(fd, buf, len, flags | MSG_NOSIGNAL);
+}
+
+static inline ssize_t lwip_sendmsg(int fd, const struct msghdr* msg, int flags) {
+    return sendmsg(fd, msg, flags | MSG_NOSIGNAL);
+}
+
+static inline ssize_t lwip_writev(int fd, const struct iovec* iov, int iovcnt) {
+    struct msghdr msg = {};
+    msg.msg_iov = (struct iovec*)iov;
+    msg.msg_iovlen = iovcnt;
+    return sendmsg(fd, &msg, MSG_NOSIGNAL);
+}
+
+static inline int lwip_select(int maxFd, fd_set* readSet, fd_set* writeSet, fd_set* exceptSet,
+                              struct timeval* timeout) {
+    return select(maxFd, readSet, writeSet, exceptSet, timeout);
+}
+
+static inline int lwip_setsockopt(int fd, int level, int name, const void* value, socklen_t len) {
+    return setsockopt(fd, level, name, value, len);
+}
+
+#endif
\ No newline at end of file
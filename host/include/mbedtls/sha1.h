@@ -0,0 +1,9 @@
+#ifndef HOST_MBEDTLS_SHA1_H
+#define HOST_MBEDTLS_SHA1_H
+
+#include <stddef.h>
+
+// SHA-1 của OpenSSL (libcrypto) trên host
+int mbedtls_sha1(const unsigned char* input, size_t ilen, unsigned char output[20]);
+
+#endif
\ No newline at end of file
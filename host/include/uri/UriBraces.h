@@ -0,0 +1,34 @@
+#ifndef HOST_URI_BRACES_H
+#define HOST_URI_BRACES_H
+
+#include "../Uri.h"
+
+// "{}" khớp một đoạn đường dẫn (không chứa '/'), đoạn đó thành pathArg
+class UriBraces : public Uri {
+public:
+    explicit UriBraces(const char* uri) : Uri(uri) {}
+    explicit UriBraces(const String& uri) : Uri(uri) {}
+
+    Uri* clone() const override { return new UriBraces(_uri); }
+
+    bool canHandle(const String& requestUri, std::vector<String>& pathArgs) override {
+        pathArgs.clear();
+        unsigned int u = 0, r = 0;
+        while (u < _uri.length()) {
+            if (_uri[u] == '{' && _uri[u + 1] == '}') {
+                int end = requestUri.indexOf('/', r);
+                if (end < 0) end = requestUri.length();
+                pathArgs.push_back(requestUri.substring(r, end));
+                r = end;
+                u += 2;
+                continue;
+            }
+            if (r >= requestUri.length() || _uri[u] != requestUri[r]) return false;
+            u++;
+            r++;
+        }
+        return r == requestUri.length();
+    }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include <esp_jpg_decode.h>
+#include <img_converters.h>
+#include "host_jpeg.h"
+
+#include <algorithm>
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+#include <jpeglib.h>
+
+struct host_jpeg_error {
+    struct jpeg_error_mgr mgr;
+    jmp_buf jump;
+};
+
+static void onJpegError(j_common_ptr cinfo) {
+    host_jpeg_error* err = (host_jpeg_error*)cinfo->err;
+    longjmp(err->jump, 1);
+}
+
+// tjpgd chỉ dùng bảng Huffman có trong file, libjpeg thì tự thêm bảng chuẩn:
+// kiểm tra trước để host từ chối đúng những frame mà chip từ chối
+static bool hasHuffmanTables(const uint8_t* data, size_t len) {
+    size_t pos = 2;
+    while (pos + 4 <= len) {
+        if (data[pos] != 0xFF) return false;
+        uint8_t marker = data[pos + 1];
+        if (marker == 0xC4) return true;
+        if (marker == 0xDA || marker == 0xD9) return false;
+        if (marker == 0xFF || marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+            pos += marker == 0xFF ? 1 : 2;
+            continue;
+        }
+        pos += 2 + ((data[pos + 2] << 8) | data[pos + 3]);
+    }
+    return false;
+}
+
+esp_err_t esp_jpg_decode(size_t len, jpg_scale_t scale, jpg_reader_cb reader, jpg_writer_cb writer, void* arg) {
+    std::vector<uint8_t> input(len);
+    if (reader(arg, 0, input.data(), len) != len) return ESP_FAIL;
+    if (len < 4 || input[0] != 0xFF || input[1] != 0xD8 || !hasHuffmanTables(input.data(), len)) return ESP_FAIL;
+
+    // mọi thứ cấp phát động khai báo trước setjmp để longjmp không bỏ qua destructor
+    std::vector<uint8_t> row;
+    struct jpeg_decompress_struct cinfo;
+    host_jpeg_error err;
+    cinfo.err = jpeg_std_error(&err.mgr);
+    err.mgr.error_exit = onJpegError;
+    if (setjmp(err.jump)) {
+        jpeg_destroy_decompress(&cinfo);
+        return ESP_FAIL;
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, input.data(), len);
+    if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK) {
+        jpeg_destroy_decompress(&cinfo);
+        return ESP_FAIL;
+    }
+    cinfo.out_color_space = JCS_RGB;
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = 1 << (int)scale;
+    jpeg_start_decompress(&cinfo);
+
+    uint16_t w = (uint16_t)cinfo.output_width;
+    uint16_t h = (uint16_t)cinfo.output_height;
+    bool ok = writer(arg, 0, 0, w, h, NULL);
+    row.resize((size_t)w * 3);
+    while (ok && cinfo.output_scanline < cinfo.output_height) {
+        uint16_t y = (uint16_t)cinfo.output_scanline;
+        JSAMPROW rows[1] = { row.data() };
+        jpeg_read_scanlines(&cinfo, rows, 1);
+        ok = writer(arg, 0, y, w, 1, row.data());
+    }
+    if (ok) ok = writer(arg, w, h, w, h, NULL);
+
+    if (ok) jpeg_finish_decompress(&cinfo);
+    else jpeg_abort_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    return ok ? ESP_OK : ESP_FAIL;
+}
+
+bool hostJpegEncode(const uint8_t* pixels, int width, int height, int components, int quality,
+                    std::vector<uint8_t>& out) {
+    struct jpeg_compress_struct cinfo;
+    host_jpeg_error err;
+    unsigned char* mem = nullptr;
+    unsigned long memLen = 0;
+
+    cinfo.err = jpeg_std_error(&err.mgr);
+    err.mgr.error_exit = onJpegError;
+    if (setjmp(err.jump)) {
+        jpeg_destroy_compress(&cinfo);
+        free(mem);
+        return false;
+    }
+
+    jpeg_create_compress(&cinfo);
+    jpeg_mem_dest(&cinfo, &mem, &memLen);
+    cinfo.image_width = width;
+    cinfo.image_height = height;
+    cinfo.input_components = components;
+    cinfo.in_color_space = components == 1 ? JCS_GRAYSCALE : JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, quality, TRUE);
+    jpeg_start_compress(&cinfo, TRUE);
+    while (cinfo.next_scanline < cinfo.image_height) {
+        JSAMPROW rows[1] = { (JSAMPROW)(pixels + (size_t)cinfo.next_scanline * width * components) };
+        jpeg_write_scanlines(&cinfo, rows, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+
+    out.assign(mem, mem + memLen);
+    free(mem);
+    return true;
+}
+
+bool fmt2jpg_cb(uint8_t* src, size_t src_len, uint16_t width, uint16_t height, pixformat_t format,
+                uint8_t quality, jpg_out_cb cb, void* arg) {
+    std::vector<uint8_t> pixels;
+    int components;
+    if (format == PIXFORMAT_RGB888) {
+        if (src_len < (size_t)width * height * 3) return false;
+        // RGB888 của esp32-camera lưu theo thứ tự BGR
+        pixels.resize((size_t)width * height * 3);
+        for (size_t i = 0; i < pixels.size(); i += 3) {
+            pixels[i] = src[i + 2];
+            pixels[i + 1] = src[i + 1];
+            pixels[i + 2] = src[i];
+        }
+        components = 3;
+    } else if (format == PIXFORMAT_GRAYSCALE) {
+        if (src_len < (size_t)width * height) return false;
+        pixels.assign(src, src + (size_t)width * height);
+        components = 1;
+    } else {
+        return false;
+    }
+
+    std::vector<uint8_t> jpeg;
+    if (!hostJpegEncode(pixels.data(), width, height, components, quality, jpeg)) return false;
+
+    // encoder của chip đẩy ra theo từng đoạn nhỏ, callback trả thiếu thì dừng
+    const size_t chunk = 1024;
+    for (size_t index = 0; index < jpeg.size(); index += chunk) {
+        size_t n = std::min(chunk, jpeg.size() - index);
+        if (cb(arg, index, jpeg.data() + index, n) != n) return false;
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,477 @@
+#include <WiFi.h>
+#include <WebServer.h>
+#include <lwip/sockets.h>
+#include "host_hal.h"
+
+#include <ifaddrs.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+
+WiFiClass WiFi;
+
+// Số lần chờ socket ghi được trước khi bỏ, như WIFI_CLIENT_MAX_WRITE_RETRY
+#define HOST_WRITE_RETRY 10
+#define HOST_WRITE_WAIT_MS 1000
+// thời gian chờ header của một request, như HTTP_MAX_DATA_WAIT
+#define HOST_HTTP_DATA_WAIT_MS 5000
+#define HOST_HTTP_MAX_HEADER (16 * 1024)
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* password) {
+    _ssid = ssid;
+    _status = WL_CONNECTED;
+    return _status;
+}
+
+bool WiFiClass::disconnect(bool wifiOff) {
+    _status = WL_DISCONNECTED;
+    return true;
+}
+
+// địa chỉ IPv4 đầu tiên không phải loopback, để URL in ra log dùng được từ máy khác
+IPAddress WiFiClass::localIP() const {
+    if (_status != WL_CONNECTED) return IPAddress();
+    struct ifaddrs* list = nullptr;
+    uint32_t found = htonl(INADDR_LOOPBACK);
+    if (getifaddrs(&list) == 0) {
+        for (struct ifaddrs* it = list; it; it = it->ifa_next) {
+            if (!it->ifa_addr || it->ifa_addr->sa_family != AF_INET) continue;
+            uint32_t addr = ((struct sockaddr_in*)it->ifa_addr)->sin_addr.s_addr;
+            if (addr == htonl(INADDR_LOOPBACK)) continue;
+            found = addr;
+            break;
+        }
+        freeifaddrs(list);
+    }
+    return IPAddress(found);
+}
+
+bool WiFiClass::softAPConfig(IPAddress ip, IPAddress gateway, IPAddress subnet) {
+    _apIp = ip;
+    return true;
+}
+
+bool WiFiClass::softAP(const char* ssid, const char* password, int channel, int hidden, int maxConnection) {
+    if (_apIp == IPAddress()) _apIp = IPAddress(192, 168, 4, 1);
+    return true;
+}
+
+bool WiFiClass::softAPdisconnect(bool wifiOff) {
+    _apIp = IPAddress();
+    return true;
+}
+
+int16_t WiFiClass::scanNetworks(bool async, bool showHidden, bool passive, uint32_t maxMsPerChannel) {
+    return 1;
+}
+
+String WiFiClass::SSID(uint8_t index) const {
+    return index == 0 ? String("host-lan") : String();
+}
+
+struct WiFiClient::Socket {
+    int fd;
+    explicit Socket(int f) : fd(f) {}
+    ~Socket() { ::close(fd); }
+};
+
+WiFiClient::WiFiClient(int fd) : _socket(std::make_shared<Socket>(fd)) {}
+
+int WiFiClient::connect(const char* host, uint16_t port) {
+    struct addrinfo hints = {};
+    struct addrinfo* result = nullptr;
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    char service[8];
+    snprintf(service, sizeof(service), "%u", port);
+    if (getaddrinfo(host, service, &hints, &result) != 0) return 0;
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int ok = fd >= 0 && ::connect(fd, result->ai_addr, result->ai_addrlen) == 0;
+    freeaddrinfo(result);
+    if (!ok) {
+        if (fd >= 0) ::close(fd);
+        return 0;
+    }
+    _socket = std::make_shared<Socket>(fd);
+    return 1;
+}
+
+int WiFiClient::fd() const { return _socket ? _socket->fd : -1; }
+
+void WiFiClient::stop() { _socket.reset(); }
+
+// còn kết nối khi chưa nhận FIN: recv peek trả 0 nghĩa là peer đã đóng
+bool WiFiClient::connected() {
+    if (!_socket) return false;
+    uint8_t probe;
+    ssize_t n = recv(_socket->fd, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (n > 0) return true;
+    if (n == 0) return false;
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+}
+
+IPAddress WiFiClient::remoteIP() const {
+    struct sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    if (!_socket || getpeername(_socket->fd, (struct sockaddr*)&addr, &len) != 0) return IPAddress();
+    return IPAddress(addr.sin_addr.s_addr);
+}
+
+uint16_t WiFiClient::remotePort() const {
+    struct sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    if (!_socket || getpeername(_socket->fd, (struct sockaddr*)&addr, &len) != 0) return 0;
+    return ntohs(addr.sin_port);
+}
+
+IPAddress WiFiClient::localIP() const {
+    struct sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    if (!_socket || getsockname(_socket->fd, (struct sockaddr*)&addr, &len) != 0) return IPAddress();
+    return IPAddress(addr.sin_addr.s_addr);
+}
+
+int WiFiClient::setNoDelay(bool noDelay) {
+    int flag = noDelay ? 1 : 0;
+    return _socket ? setsockopt(_socket->fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag)) : -1;
+}
+
+// ghi hết buffer kể cả khi socket đã O_NONBLOCK, bỏ cuộc sau HOST_WRITE_RETRY
+// lần không ghi được byte nào
+size_t WiFiClient::write(const uint8_t* buf, size_t len) {
+    if (!_socket) return 0;
+    size_t sent = 0;
+    int retry = HOST_WRITE_RETRY;
+    while (sent < len && retry > 0) {
+        ssize_t n = send(_socket->fd, buf + sent, len - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n > 0) {
+            sent += n;
+            retry = HOST_WRITE_RETRY;
+            continue;
+        }
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) break;
+        struct pollfd pfd = { _socket->fd, POLLOUT, 0 };
+        poll(&pfd, 1, HOST_WRITE_WAIT_MS);
+        retry--;
+    }
+    return sent;
+}
+
+int WiFiClient::available() {
+    if (!_socket) return 0;
+    int pending = 0;
+    if (ioctl(_socket->fd, FIONREAD, &pending) != 0) return 0;
+    return pending;
+}
+
+int WiFiClient::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int WiFiClient::read(uint8_t* buf, size_t len) {
+    if (!_socket) return -1;
+    ssize_t n = recv(_socket->fd, buf, len, MSG_DONTWAIT);
+    return n > 0 ? (int)n : -1;
+}
+
+int WiFiClient::peek() {
+    uint8_t c;
+    if (!_socket || recv(_socket->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) != 1) return -1;
+    return c;
+}
+
+void WiFiServer::begin(uint16_t port) {
+    if (port) _port = port;
+    stop();
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(hostListenPort(_port));
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 8) != 0) {
+        Serial.printf("[HOST] listen on port %u failed: %s\n", hostListenPort(_port), strerror(errno));
+        ::close(fd);
+        return;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    _listenFd = fd;
+}
+
+void WiFiServer::stop() {
+    if (_listenFd >= 0) ::close(_listenFd);
+    _listenFd = -1;
+}
+
+WiFiClient WiFiServer::available() {
+    if (_listenFd < 0) return WiFiClient();
+    int fd = accept4(_listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) return WiFiClient();
+    WiFiClient client(fd);
+    if (_noDelay) client.setNoDelay(true);
+    return client;
+}
+
+void WebServer::begin() { _server.begin(); }
+
+void WebServer::stop() {
+    _server.stop();
+    _client.stop();
+}
+
+void WebServer::on(const Uri& uri, HTTPMethod method, THandlerFunction handler) {
+    _routes.push_back(Route{ std::unique_ptr<Uri>(uri.clone()), method, handler });
+}
+
+void WebServer::collectHeaders(const char* headerKeys[], size_t count) {
+    _collect.clear();
+    for (size_t i = 0; i < count; i++) _collect.push_back(headerKeys[i]);
+}
+
+static String urlDecode(const String& text) {
+    String out;
+    for (unsigned int i = 0; i < text.length(); i++) {
+        char c = text[i];
+        if (c == '+') {
+            out += ' ';
+        } else if (c == '%' && i + 2 < text.length()) {
+            char hex[3] = { text[i + 1], text[i + 2], 0 };
+            out += (char)strtol(hex, nullptr, 16);
+            i += 2;
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+void WebServer::parseArgs(const String& data) {
+    int pos = 0;
+    while (pos < (int)data.length()) {
+        int end = data.indexOf('&', pos);
+        if (end < 0) end = data.length();
+        String pair = data.substring(pos, end);
+        int eq = pair.indexOf('=');
+        if (pair.length()) {
+            if (eq < 0) _args.push_back(KeyValue(urlDecode(pair), String()));
+            else _args.push_back(KeyValue(urlDecode(pair.substring(0, eq)), urlDecode(pair.substring(eq + 1))));
+        }
+        pos = end + 1;
+    }
+}
+
+// đọc request line + header (+ body form của POST), chờ tối đa HOST_HTTP_DATA_WAIT_MS
+bool WebServer::readRequest() {
+    std::string raw;
+    unsigned long start = millis();
+    size_t headerEnd = std::string::npos;
+    while ((headerEnd = raw.find("\r\n\r\n")) == std::string::npos) {
+        if (raw.size() > HOST_HTTP_MAX_HEADER || millis() - start > HOST_HTTP_DATA_WAIT_MS) return false;
+        struct pollfd pfd = { _client.fd(), POLLIN, 0 };
+        if (poll(&pfd, 1, 50) <= 0) continue;
+        uint8_t buf[1024];
+        int n = _client.read(buf, sizeof(buf));
+        if (n <= 0) {
+            if (!_client.connected()) return false;
+            continue;
+        }
+        raw.append((const char*)buf, n);
+    }
+    std::string body = raw.substr(headerEnd + 4);
+    raw.resize(headerEnd);
+
+    size_t lineEnd = raw.find("\r\n");
+    String requestLine(raw.substr(0, lineEnd));
+    int sp1 = requestLine.indexOf(' ');
+    int sp2 = requestLine.indexOf(' ', sp1 + 1);
+    if (sp1 < 0 || sp2 < 0) return false;
+    String methodName = requestLine.substring(0, sp1);
+    String target = requestLine.substring(sp1 + 1, sp2);
+
+    static const struct { const char* name; HTTPMethod method; } methods[] = {
+        { "GET", HTTP_GET }, { "HEAD", HTTP_HEAD }, { "POST", HTTP_POST }, { "PUT", HTTP_PUT },
+        { "PATCH", HTTP_PATCH }, { "DELETE", HTTP_DELETE }, { "OPTIONS", HTTP_OPTIONS },
+    };
+    _method = HTTP_ANY;
+    for (const auto& m : methods) {
+        if (methodName == m.name) _method = m.method;
+    }
+
+    int query = target.indexOf('?');
+    _uri = urlDecode(query < 0 ? target : target.substring(0, query));
+    if (query >= 0) parseArgs(target.substring(query + 1));
+
+    size_t contentLength = 0;
+    bool formBody = false;
+    size_t pos = lineEnd == std::string::npos ? raw.size() : lineEnd + 2;
+    while (pos < raw.size()) {
+        size_t end = raw.find("\r\n", pos);
+        if (end == std::string::npos) end = raw.size();
+        String line(raw.substr(pos, end - pos));
+        pos = end + 2;
+        int colon = line.indexOf(':');
+        if (colon <= 0) continue;
+        String name = line.substring(0, colon);
+        String value = line.substring(colon + 1);
+        value.trim();
+        _headers.push_back(KeyValue(name, value));
+        if (name.equalsIgnoreCase("Content-Length")) contentLength = value.toInt();
+        if (name.equalsIgnoreCase("Content-Type") && value.startsWith("application/x-www-form-urlencoded")) {
+            formBody = true;
+        }
+    }
+
+    while (body.size() < contentLength && millis() - start <= HOST_HTTP_DATA_WAIT_MS) {
+        struct pollfd pfd = { _client.fd(), POLLIN, 0 };
+        if (poll(&pfd, 1, 50) <= 0) continue;
+        uint8_t buf[1024];
+        int n = _client.read(buf, std::min(sizeof(buf), contentLength - body.size()));
+        if (n <= 0) {
+            if (!_client.connected()) break;
+            continue;
+        }
+        body.append((const char*)buf, n);
+    }
+    if (formBody) parseArgs(String(body));
+    else if (contentLength) _args.push_back(KeyValue("plain", String(body)));
+    return true;
+}
+
+void WebServer::handleClient() {
+    _client = _server.available();
+    if (!_client) return;
+
+    _args.clear();
+    _headers.clear();
+    _pathArgs.clear();
+    _responseHeaders.clear();
+    _contentLength = CONTENT_LENGTH_NOT_SET;
+    _chunked = false;
+    _headersSent = false;
+
+    if (readRequest()) {
+        bool handled = false;
+        for (auto& route : _routes) {
+            if (route.method != HTTP_ANY && route.method != _method) continue;
+            if (!route.uri->canHandle(_uri, _pathArgs)) continue;
+            route.handler();
+            handled = true;
+            break;
+        }
+        if (!handled) {
+            if (_notFound) _notFound();
+            else send(404, "text/plain", String("Not found: ") + _uri);
+        }
+        if (_chunked) sendContent("", 0);
+    }
+
+    // như Arduino-ESP32: server bỏ tham chiếu, socket chỉ đóng khi không còn ai giữ
+    _client = WiFiClient();
+}
+
+String WebServer::arg(const String& name) const {
+    for (const auto& kv : _args) {
+        if (kv.first == name) return kv.second;
+    }
+    return String();
+}
+
+String WebServer::arg(int index) const {
+    return index >= 0 && index < (int)_args.size() ? _args[index].second : String();
+}
+
+String WebServer::argName(int index) const {
+    return index >= 0 && index < (int)_args.size() ? _args[index].first : String();
+}
+
+bool WebServer::hasArg(const String& name) const {
+    for (const auto& kv : _args) {
+        if (kv.first == name) return true;
+    }
+    return false;
+}
+
+String WebServer::pathArg(unsigned int index) const {
+    return index < _pathArgs.size() ? _pathArgs[index] : String();
+}
+
+String WebServer::header(const String& name) const {
+    for (const auto& kv : _headers) {
+        if (kv.first.equalsIgnoreCase(name)) return kv.second;
+    }
+    return String();
+}
+
+bool WebServer::hasHeader(const String& name) const {
+    for (const auto& kv : _headers) {
+        if (kv.first.equalsIgnoreCase(name)) return true;
+    }
+    return false;
+}
+
+void WebServer::sendHeader(const String& name, const String& value, bool first) {
+    if (first) _responseHeaders.insert(_responseHeaders.begin(), KeyValue(name, value));
+    else _responseHeaders.push_back(KeyValue(name, value));
+}
+
+void WebServer::writeAll(const char* data, size_t len) {
+    if (len) _client.write((const uint8_t*)data, len);
+}
+
+static const char* reasonPhrase(int code) {
+    switch (code) {
+        case 200: return "OK";
+        case 204: return "No Content";
+        case 206: return "Partial Content";
+        case 302: return "Found";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 404: return "Not Found";
+        case 416: return "Range Not Satisfiable";
+        case 426: return "Upgrade Required";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default: return "";
+    }
+}
+
+void WebServer::send(int code, const char* contentType, const String& content) {
+    String head = String("HTTP/1.1 ") + code + " " + reasonPhrase(code) + "\r\n";
+    if (contentType && *contentType) head += String("Content-Type: ") + contentType + "\r\n";
+
+    size_t length = _contentLength == CONTENT_LENGTH_NOT_SET ? content.length() : _contentLength;
+    if (length == CONTENT_LENGTH_UNKNOWN) {
+        head += "Transfer-Encoding: chunked\r\n";
+        _chunked = true;
+    } else {
+        head += String("Content-Length: ") + (unsigned long)length + "\r\n";
+    }
+    for (const auto& kv : _responseHeaders) head += kv.first + ": " + kv.second + "\r\n";
+    head += "Connection: close\r\n\r\n";
+    _responseHeaders.clear();
+    _headersSent = true;
+
+    writeAll(head.c_str(), head.length());
+    if (_method != HTTP_HEAD && content.length()) sendContent(content.c_str(), content.length());
+}
+
+void WebServer::sendContent(const char* content, size_t len) {
+    if (!_chunked) {
+        writeAll(content, len);
+        return;
+    }
+    char sizeLine[16];
+    int n = snprintf(sizeLine, sizeof(sizeLine), "%zx\r\n", len);
+    writeAll(sizeLine, n);
+    writeAll(content, len);
+    writeAll("\r\n", 2);
+    // chunk rỗng kết thúc body, những lần gửi sau là raw như Arduino
+    if (len == 0) _chunked = false;
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <SPI.h>
+#include <ESPmDNS.h>
+#include <Audio.h>
+#include <PubSubClient.h>
+#include <BlynkSimpleEsp32.h>
+#include <mbedtls/sha1.h>
+#include <mbedtls/base64.h>
+#include "host_hal.h"
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <openssl/evp.h>
+#include <openssl/sha.h>
+
+EEPROMClass EEPROM;
+SPIClass SPI;
+MDNSResponder MDNS;
+BlynkHost Blynk;
+
+bool Audio::connecttoFS(SDFS& fs, const char* path) {
+    Serial.printf("[HOST] Audio: %s\n", path);
+    return fs.exists(path);
+}
+
+// message chờ giao cho PubSubClient::loop(), đẩy vào từ thread bất kỳ
+static std::mutex mqttLock;
+static std::deque<std::pair<std::string, std::string>> mqttInbox;
+
+void hostMqttInject(const char* topic, const char* payload) {
+    std::lock_guard<std::mutex> guard(mqttLock);
+    mqttInbox.emplace_back(topic, payload);
+}
+
+PubSubClient& PubSubClient::setServer(const char* domain, uint16_t port) {
+    Serial.printf("[HOST] MQTT broker %s:%u is simulated in-process\n", domain, port);
+    return *this;
+}
+
+bool PubSubClient::connect(const char* id, const char* user, const char* pass) {
+    _connected = true;
+    return true;
+}
+
+bool PubSubClient::subscribe(const char* topic) {
+    if (!_connected) return false;
+    _topics.push_back(topic);
+    return true;
+}
+
+bool PubSubClient::publish(const char* topic, const char* payload, bool retained) {
+    if (!_connected) return false;
+    Serial.printf("[HOST] MQTT publish %s%s: %s\n", topic, retained ? " (retained)" : "", payload);
+    return true;
+}
+
+bool PubSubClient::loop() {
+    if (!_connected) return false;
+    for (;;) {
+        std::pair<std::string, std::string> msg;
+        {
+            std::lock_guard<std::mutex> guard(mqttLock);
+            if (mqttInbox.empty()) break;
+            msg = mqttInbox.front();
+            mqttInbox.pop_front();
+        }
+        bool subscribed = false;
+        for (const auto& topic : _topics) subscribed |= topic == msg.first;
+        if (!subscribed || !_callback) continue;
+        std::string payload = msg.second;
+        _callback(&msg.first[0], (uint8_t*)&payload[0], (unsigned int)payload.size());
+    }
+    return true;
+}
+
+int mbedtls_sha1(const unsigned char* input, size_t ilen, unsigned char output[20]) {
+    SHA1(input, ilen, output);
+    return 0;
+}
+
+int mbedtls_base64_encode(unsigned char* dst, size_t dlen, size_t* olen, const unsigned char* src, size_t slen) {
+    size_t needed = 4 * ((slen + 2) / 3) + 1;
+    if (!dst || dlen < needed) {
+        *olen = needed;
+        return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
+    }
+    *olen = (size_t)EVP_EncodeBlock(dst, src, (int)slen);
+    return 0;
+}
\ No newline at end of file
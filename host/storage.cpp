@@ -0,0 +1,156 @@
+#include <SD.h>
+
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+SDFS SD;
+
+struct File::Impl {
+    std::string hostPath;
+    std::string path;     // đường dẫn phía firmware, bắt đầu bằng '/'
+    std::string name;
+    FILE* file = nullptr;
+    DIR* dir = nullptr;
+
+    ~Impl() {
+        if (file) fclose(file);
+        if (dir) closedir(dir);
+    }
+};
+
+static std::string baseName(const std::string& path) {
+    size_t slash = path.rfind('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+bool SDFS::begin(uint8_t ssPin) {
+    const char* dir = getenv("HOST_SD_DIR");
+    _root = dir && *dir ? dir : "host_sd";
+    ::mkdir(_root.c_str(), 0755);
+    struct stat st;
+    _mounted = stat(_root.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+    if (_mounted) Serial.printf("[HOST] SD card mapped to %s\n", _root.c_str());
+    return _mounted;
+}
+
+std::string SDFS::hostPath(const char* path) const {
+    std::string p = path ? path : "";
+    if (p.empty() || p[0] != '/') p = "/" + p;
+    return _root + p;
+}
+
+uint64_t SDFS::totalBytes() const {
+    struct statvfs vfs;
+    if (!_mounted || statvfs(_root.c_str(), &vfs) != 0) return 0;
+    return (uint64_t)vfs.f_blocks * vfs.f_frsize;
+}
+
+uint64_t SDFS::cardSize() const { return totalBytes(); }
+
+uint64_t SDFS::usedBytes() const {
+    struct statvfs vfs;
+    if (!_mounted || statvfs(_root.c_str(), &vfs) != 0) return 0;
+    return (uint64_t)(vfs.f_blocks - vfs.f_bfree) * vfs.f_frsize;
+}
+
+File SDFS::open(const char* path, const char* mode) {
+    File f;
+    if (!_mounted) return f;
+    std::string host = hostPath(path);
+    auto impl = std::make_shared<File::Impl>();
+    impl->hostPath = host;
+    impl->path = host.substr(_root.size());
+    impl->name = baseName(impl->path);
+
+    struct stat st;
+    if (strcmp(mode, FILE_READ) == 0 && stat(host.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+        impl->dir = opendir(host.c_str());
+        if (!impl->dir) return f;
+    } else {
+        // FILE_WRITE của Arduino-ESP32 là "w": tạo mới/cắt file
+        const char* hostMode = strcmp(mode, FILE_WRITE) == 0 ? "w+b" : strcmp(mode, FILE_APPEND) == 0 ? "ab" : "rb";
+        impl->file = fopen(host.c_str(), hostMode);
+        if (!impl->file) return f;
+    }
+    f._impl = impl;
+    return f;
+}
+
+bool SDFS::exists(const char* path) const {
+    struct stat st;
+    return _mounted && stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool SDFS::mkdir(const char* path) {
+    return _mounted && (::mkdir(hostPath(path).c_str(), 0755) == 0 || errno == EEXIST);
+}
+
+bool SDFS::remove(const char* path) { return _mounted && unlink(hostPath(path).c_str()) == 0; }
+bool SDFS::rmdir(const char* path) { return _mounted && ::rmdir(hostPath(path).c_str()) == 0; }
+
+size_t File::write(const uint8_t* buf, size_t len) {
+    return _impl && _impl->file ? fwrite(buf, 1, len, _impl->file) : 0;
+}
+
+size_t File::read(uint8_t* buf, size_t len) {
+    return _impl && _impl->file ? fread(buf, 1, len, _impl->file) : 0;
+}
+
+int File::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int File::peek() {
+    if (!_impl || !_impl->file) return -1;
+    int c = fgetc(_impl->file);
+    if (c != EOF) ungetc(c, _impl->file);
+    return c == EOF ? -1 : c;
+}
+
+int File::available() {
+    if (!_impl || !_impl->file) return 0;
+    return (int)(size() - position());
+}
+
+bool File::seek(uint32_t pos) {
+    return _impl && _impl->file && fseek(_impl->file, pos, SEEK_SET) == 0;
+}
+
+size_t File::position() const {
+    if (!_impl || !_impl->file) return 0;
+    long pos = ftell(_impl->file);
+    return pos < 0 ? 0 : (size_t)pos;
+}
+
+size_t File::size() const {
+    if (!_impl) return 0;
+    if (_impl->file) fflush(_impl->file);
+    struct stat st;
+    return stat(_impl->hostPath.c_str(), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+void File::flush() {
+    if (_impl && _impl->file) fflush(_impl->file);
+}
+
+bool File::isDirectory() const { return _impl && _impl->dir; }
+
+File File::openNextFile(const char* mode) {
+    if (!_impl || !_impl->dir) return File();
+    while (struct dirent* entry = readdir(_impl->dir)) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        std::string child = _impl->path;
+        if (child.empty() || child.back() != '/') child += '/';
+        child += entry->d_name;
+        File f = SD.open(child.c_str(), mode);
+        if (f) return f;
+    }
+    return File();
+}
+
+const char* File::name() const { return _impl ? _impl->name.c_str() : ""; }
+const char* File::path() const { return _impl ? _impl->path.c_str() : ""; }
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include <USB_STREAM.h>
+#include "host_jpeg.h"
+
+#include <dirent.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+// số khung tổng hợp phát vòng khi không có HOST_CAMERA_DIR
+#define HOST_SYNTHETIC_FRAMES 30
+#define HOST_SYNTHETIC_QUALITY 80
+
+void USB_STREAM::uvcConfiguration(uint16_t width, uint16_t height, uint32_t frameInterval,
+                                  uint32_t transferBufferSize, uint8_t* transferBufferA, uint8_t* transferBufferB,
+                                  uint32_t frameBufferSize, uint8_t* frameBuffer) {
+    std::lock_guard<std::mutex> guard(_lock);
+    _width = width;
+    _height = height;
+    _interval = frameInterval ? frameInterval : 333333;
+    _frameBuf = frameBuffer;
+    _frameBufSize = frameBufferSize;
+}
+
+void USB_STREAM::uvcCamRegisterCb(uvc_frame_callback_t* callback, void* arg) {
+    std::lock_guard<std::mutex> guard(_lock);
+    _callback = callback;
+    _callbackArg = arg;
+}
+
+static bool readFile(const std::string& path, std::vector<uint8_t>& out) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    out.resize(size > 0 ? size : 0);
+    bool ok = size > 0 && fread(out.data(), 1, out.size(), f) == out.size();
+    fclose(f);
+    return ok;
+}
+
+static bool isJpegName(const std::string& name) {
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    auto ends = [&](const char* ext) {
+        size_t n = strlen(ext);
+        return lower.size() > n && lower.compare(lower.size() - n, n, ext) == 0;
+    };
+    return ends(".jpg") || ends(".jpeg");
+}
+
+// Khung tổng hợp: nền gradient + nhiễu hạt cố định + một vạch sáng chạy ngang,
+// đủ chi tiết để frame nén lớn hơn ngưỡng 2000 byte của frame_cb
+static void buildSynthetic(uint16_t width, uint16_t height, std::vector<std::vector<uint8_t>>& frames) {
+    std::vector<uint8_t> rgb((size_t)width * height * 3);
+    frames.clear();
+    for (int n = 0; n < HOST_SYNTHETIC_FRAMES; n++) {
+        int barX = (int)((long)n * width / HOST_SYNTHETIC_FRAMES);
+        int barW = std::max(4, width / 16);
+        uint32_t seed = 12345;
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                seed = seed * 1103515245 + 12345;
+                int grain = (int)((seed >> 16) & 0x1F) - 16;
+                uint8_t* px = &rgb[((size_t)y * width + x) * 3];
+                bool bar = x >= barX && x < barX + barW;
+                int r = bar ? 240 : x * 255 / width;
+                int g = bar ? 240 : y * 255 / height;
+                int b = bar ? 240 : 128;
+                px[0] = (uint8_t)std::min(255, std::max(0, r + grain));
+                px[1] = (uint8_t)std::min(255, std::max(0, g + grain));
+                px[2] = (uint8_t)std::min(255, std::max(0, b + grain));
+            }
+        }
+        std::vector<uint8_t> jpeg;
+        if (hostJpegEncode(rgb.data(), width, height, 3, HOST_SYNTHETIC_QUALITY, jpeg)) frames.push_back(jpeg);
+    }
+}
+
+void USB_STREAM::loadFrames() {
+    const char* dir = getenv("HOST_CAMERA_DIR");
+    _frames.clear();
+    _synthetic = false;
+
+    if (dir && *dir) {
+        std::vector<std::string> names;
+        if (DIR* d = opendir(dir)) {
+            while (struct dirent* entry = readdir(d)) {
+                if (isJpegName(entry->d_name)) names.push_back(entry->d_name);
+            }
+            closedir(d);
+        }
+        std::sort(names.begin(), names.end());
+        for (const auto& name : names) {
+            std::vector<uint8_t> data;
+            if (readFile(std::string(dir) + "/" + name, data)) _frames.push_back(data);
+        }
+        Serial.printf("[HOST] UVC replaying %u JPEG files from %s\n", (unsigned)_frames.size(), dir);
+        if (!_frames.empty()) return;
+    }
+
+    _synthetic = true;
+    buildSynthetic(_width, _height, _frames);
+    _framesWidth = _width;
+    _framesHeight = _height;
+    Serial.printf("[HOST] UVC generating %ux%u test pattern\n", _width, _height);
+}
+
+void USB_STREAM::start() {
+    if (_running) return;
+    loadFrames();
+    _suspended = false;
+    _running = true;
+    _thread = std::thread(&USB_STREAM::run, this);
+}
+
+void USB_STREAM::stop() {
+    if (!_running) return;
+    _running = false;
+    if (_thread.joinable()) _thread.join();
+}
+
+void USB_STREAM::uvcCamSuspend(void* ctrlValue) {
+    std::lock_guard<std::mutex> guard(_lock);
+    _suspended = true;
+}
+
+void USB_STREAM::uvcCamResume(void* ctrlValue) {
+    std::lock_guard<std::mutex> guard(_lock);
+    _suspended = false;
+}
+
+void USB_STREAM::uvcCamFrameReset(uint16_t width, uint16_t height, uint32_t frameInterval) {
+    std::lock_guard<std::mutex> guard(_lock);
+    _width = width;
+    _height = height;
+    _interval = frameInterval ? frameInterval : _interval;
+    // file JPEG phát lại giữ nguyên kích thước, khung tổng hợp thì tạo lại
+    if (_synthetic && (_framesWidth != width || _framesHeight != height)) {
+        buildSynthetic(width, height, _frames);
+        _framesWidth = width;
+        _framesHeight = height;
+    }
+}
+
+// thread "USB": mỗi frame_interval copy frame kế tiếp vào frame buffer và gọi
+// callback, frame lớn hơn buffer bị bỏ như driver thật
+void USB_STREAM::run() {
+    size_t next = 0;
+    uint32_t sequence = 0;
+    auto deadline = std::chrono::steady_clock::now();
+
+    while (_running) {
+        uint32_t interval;
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            interval = _interval;
+            if (!_suspended && !_frames.empty() && _callback && _frameBuf) {
+                const std::vector<uint8_t>& jpeg = _frames[next++ % _frames.size()];
+                if (jpeg.size() <= _frameBufSize) {
+                    memcpy(_frameBuf, jpeg.data(), jpeg.size());
+                    uvc_frame_t frame = { _frameBuf, jpeg.size(), _width, _height, sequence++ };
+                    _callback(&frame, _callbackArg);
+                }
+            }
+        }
+        deadline += std::chrono::nanoseconds((uint64_t)interval * 100);
+        auto now = std::chrono::steady_clock::now();
+        if (deadline < now) deadline = now;
+        std::this_thread::sleep_until(deadline);
+    }
+}
\ No newline at end of file
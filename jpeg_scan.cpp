@@ -0,0 +1,224 @@
+#include "jpeg_scan.h"
+#include <string.h>
+
+// tổng bảng lượng tử luma chuẩn (Annex K) ở quality 50
+#define IJG_LUMA_TABLE_SUM 3688
+
+// DHT với 4 bảng Huffman chuẩn (Annex K.3): DC/AC luma (id 0), DC/AC chroma (id 1)
+static const uint8_t standardDht[] = {
+    0xFF, 0xC4, 0x01, 0xA2,
+    0x00, 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0,
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+    0x10, 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7D,
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+    0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xA1, 0x08, 0x23, 0x42, 0xB1, 0xC1, 0x15, 0x52, 0xD1, 0xF0,
+    0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0A, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2A, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7,
+    0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5,
+    0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE1, 0xE2,
+    0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+    0xF9, 0xFA,
+    0x01, 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0,
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+    0x11, 0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77,
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+    0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xA1, 0xB1, 0xC1, 0x09, 0x23, 0x33, 0x52, 0xF0,
+    0x15, 0x62, 0x72, 0xD1, 0x0A, 0x16, 0x24, 0x34, 0xE1, 0x25, 0xF1, 0x17, 0x18, 0x19, 0x1A, 0x26,
+    0x27, 0x28, 0x29, 0x2A, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+    0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+    0x69, 0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5,
+    0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3,
+    0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA,
+    0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+    0xF9, 0xFA,
+};
+
+static inline uint16_t be16(const uint8_t* p) {
+    return ((uint16_t)p[0] << 8) | p[1];
+}
+
+// true nếu một trong 4 byte của w bằng 0xFF (phép "has zero byte" trên ~w)
+static inline bool wordHasFF(uint32_t w) {
+    uint32_t x = ~w;
+    return ((x - 0x01010101u) & ~x & 0x80808080u) != 0;
+}
+
+// Vị trí 0xFF tiếp theo từ i, hoặc len nếu không còn. Entropy data chiếm
+// gần hết frame nên đọc 4 byte một lần, chỉ đọc từng byte ở đầu (căn lề)
+// và trong word có 0xFF.
+static size_t findFF(const uint8_t* p, size_t i, size_t len) {
+    while (i < len && ((uintptr_t)(p + i) & 3)) {
+        if (p[i] == 0xFF) return i;
+        i++;
+    }
+
+    while (i + 4 <= len && !wordHasFF(*(const uint32_t*)(p + i))) i += 4;
+
+    while (i < len && p[i] != 0xFF) i++;
+    return i;
+}
+
+// Quality theo công thức scale của libjpeg: scale = 5000/q (q < 50), 200 - 2q
+static uint8_t estimateQuality(const uint8_t* table, bool wide) {
+    uint32_t sum = 0;
+    for (int k = 0; k < 64; k++) {
+        sum += wide ? be16(table + k * 2) : table[k];
+    }
+
+    uint32_t scale = (sum * 100 + IJG_LUMA_TABLE_SUM / 2) / IJG_LUMA_TABLE_SUM;
+    if (scale == 0) return 100;
+
+    uint32_t q = (scale <= 100) ? (200 - scale) / 2 : 5000 / scale;
+    if (q < 1) q = 1;
+    if (q > 100) q = 100;
+    return (uint8_t)q;
+}
+
+static bool parseDqt(const uint8_t* seg, size_t segLen, uint32_t segOffset, jpeg_info_t* info) {
+    size_t p = 0;
+    while (p < segLen) {
+        bool wide = (seg[p] >> 4) != 0;
+        uint8_t id = seg[p] & 0x0F;
+        size_t size = wide ? 128 : 64;
+        if (p + 1 + size > segLen) return false;
+
+        if (id == 0 && info->quality == 0) info->quality = estimateQuality(seg + p + 1, wide);
+        if (id < 2 && !wide) info->qtableOffset[id] = segOffset + p + 1;
+        info->qtables++;
+        p += 1 + size;
+    }
+    return true;
+}
+
+static uint8_t countDhtTables(const uint8_t* seg, size_t segLen) {
+    uint8_t tables = 0;
+    size_t p = 0;
+    while (p + 17 <= segLen) {
+        size_t symbols = 0;
+        for (int k = 1; k <= 16; k++) symbols += seg[p + k];
+        p += 17 + symbols;
+        if (p > segLen) break;
+        tables++;
+    }
+    return tables;
+}
+
+static bool isSof(uint8_t m) {
+    // C4 = DHT, C8 = JPG, CC = DAC nằm trong dải SOF nhưng không phải SOF
+    return m >= 0xC0 && m <= 0xCF && m != 0xC4 && m != 0xC8 && m != 0xCC;
+}
+
+static bool scanHeader(const uint8_t* data, size_t len, jpeg_info_t* info) {
+    size_t pos = 2;
+
+    while (pos < len) {
+        if (data[pos] != 0xFF) return false;
+        while (pos < len && data[pos] == 0xFF) pos++;     // byte fill
+        if (pos >= len) return false;
+
+        uint8_t m = data[pos++];
+        if (m == 0xD8 || m == 0xD9) return false;         // SOI/EOI trước SOS
+        if ((m >= 0xD0 && m <= 0xD7) || m == 0x01) continue;
+
+        if (pos + 2 > len) return false;
+        uint16_t segLen = be16(data + pos);
+        if (segLen < 2 || pos + segLen > len) return false;
+
+        const uint8_t* seg = data + pos + 2;
+        size_t bodyLen = segLen - 2;
+
+        if (isSof(m)) {
+            if (bodyLen < 6) return false;
+            info->height = be16(seg + 1);
+            info->width = be16(seg + 3);
+            info->components = seg[5];
+            if (info->components > 0 && bodyLen >= 9) info->sampling = seg[7];
+        } else if (m == 0xDB) {
+            if (!parseDqt(seg, bodyLen, pos + 2, info)) return false;
+        } else if (m == 0xC4) {
+            info->huffTables += countDhtTables(seg, bodyLen);
+        } else if (m == 0xDD) {
+            if (bodyLen < 2) return false;
+            info->restartInterval = be16(seg);
+        } else if (m == 0xDA) {
+            info->sosOffset = pos - 2;
+            info->scanOffset = pos + segLen;
+            return info->width != 0 && info->height != 0;
+        }
+
+        pos += segLen;
+    }
+
+    return false;
+}
+
+// Trong entropy data chỉ hợp lệ: FF00 (byte stuffing), RSTn, FF fill và EOI.
+// Sau EOI có thể còn padding của UVC nên không bắt EOI nằm cuối buffer.
+static bool scanEntropy(const uint8_t* data, size_t len, jpeg_info_t* info) {
+    size_t i = info->scanOffset;
+
+    while (true) {
+        i = findFF(data, i, len);
+        if (i + 1 >= len) return false;
+
+        uint8_t m = data[i + 1];
+        if (m == 0x00 || (m >= 0xD0 && m <= 0xD7)) {
+            i += 2;
+        } else if (m == 0xFF) {
+            i += 1;
+        } else if (m == 0xD9) {
+            info->eoiOffset = i;
+            return true;
+        } else {
+            return false;
+        }
+    }
+}
+
+bool jpegScan(const uint8_t* data, size_t len, jpeg_info_t* info) {
+    memset(info, 0, sizeof(*info));
+
+    if (!data || len < 4) return false;
+    if (data[0] != 0xFF || data[1] != 0xD8) return false;
+
+    if (!scanHeader(data, len, info)) return false;
+    return scanEntropy(data, len, info);
+}
+
+size_t jpegPatchedSize(const jpeg_info_t* info, size_t len) {
+    return info->huffTables ? len : len + sizeof(standardDht);
+}
+
+size_t jpegReadPatched(const uint8_t* data, size_t len, const jpeg_info_t* info,
+                       size_t index, uint8_t* buf, size_t count) {
+    size_t total = jpegPatchedSize(info, len);
+    if (index >= total) return 0;
+    if (index + count > total) count = total - index;
+
+    size_t sos = info->huffTables ? total : info->sosOffset;
+    size_t dhtEnd = info->huffTables ? total : sos + sizeof(standardDht);
+    size_t done = 0;
+    while (done < count) {
+        size_t i = index + done;
+        const uint8_t* src;
+        size_t n;
+        if (i < sos) {
+            src = data + i;
+            n = sos - i;
+        } else if (i < dhtEnd) {
+            src = standardDht + (i - sos);
+            n = dhtEnd - i;
+        } else {
+            src = data + (i - sizeof(standardDht));
+            n = total - i;
+        }
+        if (n > count - done) n = count - done;
+        if (buf) memcpy(buf + done, src, n);
+        done += n;
+    }
+    return count;
+}
\ No newline at end of file
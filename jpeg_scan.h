@@ -0,0 +1,38 @@
+#ifndef JPEG_SCAN_H
+#define JPEG_SCAN_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Thông tin lấy từ header JPEG, lưu cùng slot để snapshot/recorder/motion
+// không phải parse lại
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    uint16_t restartInterval;   // 0 nếu không có DRI
+    uint8_t components;
+    uint8_t sampling;           // H/V của component đầu: 0x21 = 4:2:2, 0x22 = 4:2:0
+    uint8_t qtables;            // số bảng lượng tử trong DQT
+    uint8_t quality;            // ước lượng theo bảng luma IJG, 0 nếu không có DQT
+    uint8_t huffTables;         // số bảng trong DHT, 0 nếu frame bỏ DHT (MJPEG của UVC)
+    uint32_t qtableOffset[2];   // 64 byte bảng 0/1 (8 bit, zigzag), 0 nếu không có
+    uint32_t sosOffset;         // vị trí marker SOS
+    uint32_t scanOffset;        // byte đầu tiên của entropy data (sau SOS)
+    uint32_t eoiOffset;         // vị trí marker EOI
+} jpeg_info_t;
+
+// Kiểm tra SOI, đi qua các segment header tới SOS rồi quét entropy data
+// tìm EOI. Trả false nếu frame bị cắt, thiếu SOF/EOI hoặc có marker lạ giữa
+// scan (thường là hai frame UVC dính nhau). Chỉ hỗ trợ baseline một scan
+// như MJPEG của UVC. Không phụ thuộc Arduino.
+bool jpegScan(const uint8_t* data, size_t len, jpeg_info_t* info);
+
+// MJPEG của UVC bỏ DHT và dùng bảng Huffman chuẩn (Annex K.3), tjpgd thì chỉ
+// đọc bảng có trong file. Đọc frame như thể DHT chuẩn nằm ngay trước SOS khi
+// info->huffTables == 0, dùng làm reader của esp_jpg_decode với độ dài
+// jpegPatchedSize(). buf NULL thì chỉ bỏ qua, như reader của tjpgd.
+size_t jpegPatchedSize(const jpeg_info_t* info, size_t len);
+size_t jpegReadPatched(const uint8_t* data, size_t len, const jpeg_info_t* info,
+                       size_t index, uint8_t* buf, size_t count);
+
+#endif
\ No newline at end of file
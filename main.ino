@@ -6,6 +6,7 @@
 #include "audio_handler.h"
 #include "sensors_handler.h"
 #include "security_system.h"
+#include "service_tasks.h"
 
 bool sdAudioInitialized = false;
 bool welcomeAudioPlayed = false;
@@ -94,11 +95,11 @@ void loop()
         }
     }
 
+    // cảm biến và an ninh chạy cả khi không có Wi-Fi (AP mode / mất mạng),
+    // chỉ phần gửi đi qua MQTT/Blynk phải chờ mạng
     if (wifiResultProcessed && !pirInitialized) {
-        if (wifiState == WIFI_STA_OK) {
-            initializeSensors();
-            systemReady = true; 
-        }
+        initializeSensors();
+        systemReady = true; 
         
         pirInitialized = true;
         return;
@@ -107,6 +108,7 @@ void loop()
     if (pirInitialized && !securitySystemInitialized) {
         initSecuritySystem();
         securitySystemInitialized = true;
+        startServiceTasks();
         return;
     }
 
@@ -132,19 +134,11 @@ void loop()
         return;
     }
 
+    // cảm biến, an ninh, Blynk và MQTT chạy ở service task (service_tasks.cpp)
     if (pirInitialized || systemReady) {
         handleWebServerLoop();
         handleWiFiLoop();
-        
-        if (systemReady && wifiState == WIFI_STA_OK) {
-            handleMotionLoop();
-            handleLDRLoop();
-            handleBlynkLoop();
-            
-            if (securitySystemInitialized) {
-                handleSecuritySystem();
-            }
-        }
+        handleCameraLoop();
     }
     
     vTaskDelay(pdMS_TO_TICKS(10));
@@ -0,0 +1,76 @@
+#include "metrics.h"
+
+metric_core_t metricCores[portNUM_PROCESSORS];
+
+static const char* const counterNames[MET_COUNTER_COUNT] = {
+    "camera_frames_received_total",
+    "camera_frames_dropped_size_total",
+    "camera_frames_dropped_corrupt_total",
+    "camera_frames_dropped_busy_total",
+    "stream_frames_sent_total",
+    "stream_queue_rejected_total",
+    "stream_clients_rejected_total",
+    "mqtt_published_total",
+    "mqtt_publish_failed_total",
+};
+
+static const char* const histNames[MET_HIST_COUNT] = {
+    "camera_frame_copy_seconds",
+    "stream_frame_send_seconds",
+    "mqtt_publish_seconds",
+};
+
+void metricObserveCycles(metric_hist_t id, uint32_t startCycles) {
+    uint32_t cycles = ESP.getCycleCount() - startCycles;
+    metricObserveUs(id, cycles / ESP.getCpuFreqMHz());
+}
+
+uint32_t metricCount(metric_counter_t id) {
+    uint32_t total = 0;
+    for (int c = 0; c < portNUM_PROCESSORS; c++) total += metricCores[c].counters[id];
+    return total;
+}
+
+static void appendGauge(String& out, const char* name, uint32_t value) {
+    char line[96];
+    snprintf(line, sizeof(line), "# TYPE %s gauge\n%s %u\n", name, name, value);
+    out += line;
+}
+
+void renderMetrics(String& out) {
+    char line[128];
+
+    for (int i = 0; i < MET_COUNTER_COUNT; i++) {
+        snprintf(line, sizeof(line), "# TYPE %s counter\n%s %u\n",
+                 counterNames[i], counterNames[i], metricCount((metric_counter_t)i));
+        out += line;
+    }
+
+    for (int h = 0; h < MET_HIST_COUNT; h++) {
+        snprintf(line, sizeof(line), "# TYPE %s histogram\n", histNames[h]);
+        out += line;
+
+        // bucket Prometheus là cộng dồn
+        uint32_t cumulative = 0;
+        uint64_t sumUs = 0;
+        // 64 bit trên Xtensa 32 bit: đọc atomic để không lấy nửa cũ nửa mới
+        for (int c = 0; c < portNUM_PROCESSORS; c++) sumUs += __atomic_load_n(&metricCores[c].sumUs[h], __ATOMIC_RELAXED);
+        for (int b = 0; b < METRIC_HIST_BUCKETS; b++) {
+            for (int c = 0; c < portNUM_PROCESSORS; c++) cumulative += metricCores[c].buckets[h][b];
+            if (b == METRIC_HIST_BUCKETS - 1) {
+                snprintf(line, sizeof(line), "%s_bucket{le=\"+Inf\"} %u\n", histNames[h], cumulative);
+            } else {
+                snprintf(line, sizeof(line), "%s_bucket{le=\"%g\"} %u\n",
+                         histNames[h], (double)(1UL << b) / 1e6, cumulative);
+            }
+            out += line;
+        }
+        snprintf(line, sizeof(line), "%s_sum %.6f\n%s_count %u\n",
+                 histNames[h], (double)sumUs / 1e6, histNames[h], cumulative);
+        out += line;
+    }
+
+    appendGauge(out, "heap_free_bytes", ESP.getFreeHeap());
+    appendGauge(out, "heap_min_free_bytes", ESP.getMinFreeHeap());
+    appendGauge(out, "psram_free_bytes", ESP.getFreePsram());
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "config.h"
+
+// Bộ đếm/histogram cho hot path, xuất dạng Prometheus text ở /metrics.
+// Mỗi core ghi vào hàng riêng của nó nên không tranh cache line giữa hai
+// core; task bị preempt giữa chừng hoặc ISR trên cùng core vẫn có thể chen
+// vào nên cập nhật bằng atomic relaxed. Lúc xuất mới cộng các hàng lại.
+
+typedef enum {
+    MET_FRAMES_RECEIVED,
+    MET_FRAMES_DROPPED_SIZE,       // ngoài khoảng 2000..MJPEG_BUF_SIZE
+    MET_FRAMES_DROPPED_CORRUPT,    // jpegScan từ chối
+    MET_FRAMES_DROPPED_BUSY,       // pool không còn slot ghi
+    MET_FRAMES_SENT,
+    MET_STREAM_QUEUE_REJECTED,
+    MET_STREAM_CLIENTS_REJECTED,   // đã đủ MAX_CLIENTS
+    MET_MQTT_PUBLISHED,
+    MET_MQTT_PUBLISH_FAILED,
+    MET_COUNTER_COUNT
+} metric_counter_t;
+
+typedef enum {
+    MET_HIST_FRAME_COPY,           // memcpy frame UVC vào slot
+    MET_HIST_STREAM_SEND,          // từ lúc bắt đầu part tới byte cuối, mỗi client
+    MET_HIST_MQTT_PUBLISH,
+    MET_HIST_COUNT
+} metric_hist_t;
+
+// bucket b có biên trên 2^b us, bucket cuối là +Inf
+#define METRIC_HIST_BUCKETS 20
+
+typedef struct {
+    uint32_t counters[MET_COUNTER_COUNT];
+    uint32_t buckets[MET_HIST_COUNT][METRIC_HIST_BUCKETS];
+    uint64_t sumUs[MET_HIST_COUNT];
+} metric_core_t;
+
+extern metric_core_t metricCores[portNUM_PROCESSORS];
+
+static inline void metricInc(metric_counter_t id) {
+    __atomic_fetch_add(&metricCores[xPortGetCoreID()].counters[id], 1, __ATOMIC_RELAXED);
+}
+
+static inline void metricObserveUs(metric_hist_t id, uint32_t us) {
+    int b = us ? 32 - __builtin_clz(us) : 0;
+    if (b >= METRIC_HIST_BUCKETS) b = METRIC_HIST_BUCKETS - 1;
+    metric_core_t& core = metricCores[xPortGetCoreID()];
+    __atomic_fetch_add(&core.buckets[id][b], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&core.sumUs[id], (uint64_t)us, __ATOMIC_RELAXED);
+}
+
+// startCycles lấy từ ESP.getCycleCount() trên cùng core (task đã pin core)
+void metricObserveCycles(metric_hist_t id, uint32_t startCycles);
+
+uint32_t metricCount(metric_counter_t id);
+void renderMetrics(String& out);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,223 @@
+#include "motion_detector.h"
+#include "camera_handler.h"
+#include "esp_jpg_decode.h"
+#include "frame_diff.h"
+
+// Xác nhận PIR bằng hình ảnh: giải mã JPEG ở tỉ lệ 1/8 (tjpgd chỉ lấy hệ số
+// DC của mỗi block 8x8), so sánh luma theo từng block với nền cập nhật dần.
+// Khi PIR kích hoạt, kết quả CONFIRMED/REJECTED có trong MOTION_CONFIRM_WINDOW_MS.
+
+#define GRID_MAX_W (MOTION_GRID_MAX_W)
+#define GRID_MAX_H (MOTION_GRID_MAX_H)
+
+static uint8_t* lumaCur = nullptr;
+static uint8_t* lumaBg = nullptr;
+static uint16_t gridW = 0;
+static uint16_t gridH = 0;
+static bool bgValid = false;
+
+static TaskHandle_t detectorHandle = NULL;
+static portMUX_TYPE verdictMux = portMUX_INITIALIZER_UNLOCKED;
+static MotionVerdict verdict = MOTION_VERDICT_NONE;
+static unsigned long confirmDeadline = 0;
+static uint32_t confirmAfterSeq = 0;
+static bool confirmNeedsBg = false;
+static int framesInWindow = 0;
+static volatile int lastChangedBlocks = 0;
+
+typedef struct {
+    const uint8_t* data;
+    size_t len;
+    const jpeg_info_t* info;
+    uint16_t w;
+    uint16_t h;
+} decode_ctx_t;
+
+static size_t jpegReader(void* arg, size_t index, uint8_t* buf, size_t len) {
+    decode_ctx_t* ctx = (decode_ctx_t*)arg;
+    return jpegReadPatched(ctx->data, ctx->len, ctx->info, index, buf, len);
+}
+
+static bool lumaWriter(void* arg, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t* data) {
+    decode_ctx_t* ctx = (decode_ctx_t*)arg;
+
+    if (!data) {
+        // lần gọi đầu (x=y=0) báo kích thước ảnh sau khi scale
+        if (x == 0 && y == 0) {
+            if (w > GRID_MAX_W || h > GRID_MAX_H) return false;
+            ctx->w = w;
+            ctx->h = h;
+        }
+        return true;
+    }
+
+    for (uint16_t row = 0; row < h; row++) {
+        uint8_t* dst = lumaCur + (y + row) * ctx->w + x;
+        for (uint16_t col = 0; col < w; col++) {
+            dst[col] = (77 * data[0] + 150 * data[1] + 29 * data[2]) >> 8;
+            data += 3;
+        }
+    }
+    return true;
+}
+
+static bool decodeLuma(const FrameRef& frame) {
+    // SOF đã parse sẵn: bỏ qua frame lớn hơn lưới mà không tốn công decode
+    if ((frame.info->width + 7) / 8 > GRID_MAX_W || (frame.info->height + 7) / 8 > GRID_MAX_H) return false;
+
+    // MJPEG của UVC thường không có DHT: jpegReader chèn bảng chuẩn cho tjpgd
+    decode_ctx_t ctx = { frame.data, frame.len, frame.info, 0, 0 };
+    size_t len = jpegPatchedSize(frame.info, frame.len);
+    if (esp_jpg_decode(len, JPG_SCALE_8X, jpegReader, lumaWriter, &ctx) != ESP_OK) return false;
+
+    if (ctx.w != gridW || ctx.h != gridH) {
+        // đổi độ phân giải: nền cũ không còn dùng được
+        gridW = ctx.w;
+        gridH = ctx.h;
+        bgValid = false;
+    }
+    return gridW >= MOTION_BLOCK && gridH >= MOTION_BLOCK;
+}
+
+static int countChangedBlocks() {
+    int changed = 0;
+    uint32_t threshold = MOTION_BLOCK_THRESHOLD * MOTION_BLOCK * MOTION_BLOCK;
+
+    for (int by = 0; by + MOTION_BLOCK <= gridH; by += MOTION_BLOCK) {
+        for (int bx = 0; bx + MOTION_BLOCK <= gridW; bx += MOTION_BLOCK) {
+            int off = by * gridW + bx;
+            if (blockDiffSum(lumaCur + off, lumaBg + off, gridW, MOTION_BLOCK) > threshold) changed++;
+        }
+    }
+    return changed;
+}
+
+static void updateBackground() {
+    size_t n = (size_t)gridW * gridH;
+    if (!bgValid) {
+        memcpy(lumaBg, lumaCur, n);
+        bgValid = true;
+        return;
+    }
+
+    // nền trôi chậm theo ánh sáng: bg += (cur - bg) / 8
+    for (size_t i = 0; i < n; i++) {
+        lumaBg[i] += ((int)lumaCur[i] - (int)lumaBg[i]) / 8;
+    }
+}
+
+static void analyseFrame(const FrameRef& frame) {
+    if (!decodeLuma(frame)) return;
+
+    portENTER_CRITICAL(&verdictMux);
+    bool confirming = (verdict == MOTION_VERDICT_PENDING) && frame.seq > confirmAfterSeq;
+    bool needBg = confirmNeedsBg;
+    portEXIT_CRITICAL(&verdictMux);
+
+    if (!bgValid || (confirming && needBg)) {
+        // camera vừa bật khi PIR kích hoạt: frame đầu tiên làm nền
+        memcpy(lumaBg, lumaCur, (size_t)gridW * gridH);
+        bgValid = true;
+        portENTER_CRITICAL(&verdictMux);
+        confirmNeedsBg = false;
+        portEXIT_CRITICAL(&verdictMux);
+        return;
+    }
+
+    int changed = countChangedBlocks();
+    lastChangedBlocks = changed;
+
+    if (confirming) {
+        portENTER_CRITICAL(&verdictMux);
+        framesInWindow++;
+        if (changed >= MOTION_MIN_BLOCKS) verdict = MOTION_VERDICT_CONFIRMED;
+        portEXIT_CRITICAL(&verdictMux);
+    } else {
+        // nền đứng yên trong cửa sổ xác nhận để người vừa vào không bị hòa vào nền
+        updateBackground();
+    }
+}
+
+static void detectorTask(void* pvParameters) {
+    uint32_t lastSeq = 0;
+    unsigned long lastAnalysis = 0;
+
+    while (true) {
+        if (framePool.waitForFrame(lastSeq, pdMS_TO_TICKS(200))) {
+            unsigned long elapsed = millis() - lastAnalysis;
+            if (elapsed < MOTION_SAMPLE_MS) {
+                vTaskDelay(pdMS_TO_TICKS(MOTION_SAMPLE_MS - elapsed));
+            }
+
+            FrameRef frame;
+            if (framePool.acquireLatest(frame, lastSeq)) {
+                lastSeq = frame.seq;
+                lastAnalysis = millis();
+                analyseFrame(frame);
+                framePool.release(frame);
+            }
+        }
+
+        portENTER_CRITICAL(&verdictMux);
+        if (verdict == MOTION_VERDICT_PENDING && (long)(millis() - confirmDeadline) >= 0) {
+            // Không có frame nào để xét: camera chưa kịp chạy hoặc UVC lỗi. Mặc định
+            // tin PIR (fail-open) để hệ thống an ninh không bị vô hiệu khi rút camera;
+            // đặt MOTION_CONFIRM_FAIL_OPEN = 0 nếu báo động giả đáng ngại hơn.
+            if (framesInWindow > 0) verdict = MOTION_VERDICT_REJECTED;
+            else verdict = MOTION_CONFIRM_FAIL_OPEN ? MOTION_VERDICT_CONFIRMED : MOTION_VERDICT_REJECTED;
+        }
+        portEXIT_CRITICAL(&verdictMux);
+    }
+}
+
+void startMotionDetector() {
+    if (detectorHandle != NULL) return;
+
+    lumaCur = (uint8_t*)heap_caps_malloc(GRID_MAX_W * GRID_MAX_H, MALLOC_CAP_SPIRAM);
+    lumaBg = (uint8_t*)heap_caps_malloc(GRID_MAX_W * GRID_MAX_H, MALLOC_CAP_SPIRAM);
+    if (!lumaCur || !lumaBg) {
+        Serial.println("[MOTION] Detector buffer allocation failed");
+        return;
+    }
+
+    xTaskCreatePinnedToCore(detectorTask, "MotionDetect", 6144, NULL, 1, &detectorHandle, PRO_CPU);
+}
+
+// Gọi từ SensorTask khi PIR lên HIGH, UVC bật ở handleCameraLoop kế tiếp
+void requestMotionConfirm() {
+    if (detectorHandle == NULL) {
+        portENTER_CRITICAL(&verdictMux);
+        verdict = MOTION_CONFIRM_FAIL_OPEN ? MOTION_VERDICT_CONFIRMED : MOTION_VERDICT_REJECTED;
+        portEXIT_CRITICAL(&verdictMux);
+        return;
+    }
+
+    cameraAcquireFromTask();
+
+    portENTER_CRITICAL(&verdictMux);
+    verdict = MOTION_VERDICT_PENDING;
+    confirmDeadline = millis() + MOTION_CONFIRM_WINDOW_MS;
+    confirmAfterSeq = framePool.latestSeq();
+    confirmNeedsBg = !bgValid;
+    framesInWindow = 0;
+    portEXIT_CRITICAL(&verdictMux);
+}
+
+// Trả về kết quả một lần; camera được nhả khi đã có kết luận
+MotionVerdict motionConfirmResult() {
+    portENTER_CRITICAL(&verdictMux);
+    MotionVerdict result = verdict;
+    if (result == MOTION_VERDICT_CONFIRMED || result == MOTION_VERDICT_REJECTED) {
+        verdict = MOTION_VERDICT_NONE;
+    }
+    portEXIT_CRITICAL(&verdictMux);
+
+    if ((result == MOTION_VERDICT_CONFIRMED || result == MOTION_VERDICT_REJECTED) && detectorHandle != NULL) {
+        cameraRelease();
+    }
+    return result;
+}
+
+int motionChangedBlocks() {
+    return lastChangedBlocks;
+}
\ No newline at end of file
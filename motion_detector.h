@@ -0,0 +1,18 @@
+#ifndef MOTION_DETECTOR_H
+#define MOTION_DETECTOR_H
+
+#include "config.h"
+
+enum MotionVerdict {
+    MOTION_VERDICT_NONE = 0,
+    MOTION_VERDICT_PENDING,
+    MOTION_VERDICT_CONFIRMED,
+    MOTION_VERDICT_REJECTED
+};
+
+void startMotionDetector();
+void requestMotionConfirm();
+MotionVerdict motionConfirmResult();
+int motionChangedBlocks();
+
+#endif
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include "pir_edges.h"
+
+void pirFilterInit(pir_filter_t* f, uint8_t level, uint32_t debounceMs, uint32_t cooldownMs) {
+    f->debounceMs = debounceMs;
+    f->cooldownMs = cooldownMs;
+    f->level = level;
+    f->pending = false;
+    f->pendingLevel = level;
+    f->pendingTime = 0;
+    f->started = false;
+    f->lastStart = 0;
+}
+
+void pirFilterResetCooldown(pir_filter_t* f) {
+    f->started = false;
+}
+
+static pir_event_t commitPending(pir_filter_t* f) {
+    pir_event_t ev = { PIR_EVENT_NONE, f->pendingTime };
+    f->pending = false;
+    f->level = f->pendingLevel;
+
+    if (!f->level) {
+        ev.type = PIR_EVENT_END;
+    } else if (!f->started || ev.time - f->lastStart > f->cooldownMs) {
+        f->started = true;
+        f->lastStart = ev.time;
+        ev.type = PIR_EVENT_START;
+    } else {
+        ev.type = PIR_EVENT_START_COOLDOWN;
+    }
+    return ev;
+}
+
+pir_event_t pirFilterPoll(pir_filter_t* f, uint32_t now) {
+    pir_event_t none = { PIR_EVENT_NONE, now };
+    if (!f->pending) return none;
+    // so sánh dạng int32 để không chốt sớm khi now lấy trước sườn trong ISR
+    if ((int32_t)(now - f->pendingTime) < (int32_t)f->debounceMs) return none;
+    return commitPending(f);
+}
+
+pir_event_t pirFilterEdge(pir_filter_t* f, const pir_edge_t* edge) {
+    pir_event_t ev = pirFilterPoll(f, edge->time);
+    uint8_t level = edge->level ? 1 : 0;
+
+    if (f->pending) {
+        // sườn ngược lại trước khi đủ debounce: xung nhiễu, giữ mức cũ
+        if (level != f->pendingLevel) f->pending = false;
+        return ev;
+    }
+
+    // trùng mức (mất một sườn do tràn queue) thì bỏ qua
+    if (level == f->level) return ev;
+
+    f->pending = true;
+    f->pendingLevel = level;
+    f->pendingTime = edge->time;
+    return ev;
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#ifndef PIR_EDGES_H
+#define PIR_EDGES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Sườn PIR bắt bằng ngắt GPIO và bộ lọc debounce/cooldown chạy trên chuỗi
+// sườn đó. Không phụ thuộc Arduino: trace sườn ghi lại có thể phát lại qua
+// cùng bộ lọc trên máy host.
+
+#define PIR_EDGE_QUEUE 32   // lũy thừa của 2
+
+typedef struct {
+    uint32_t time;          // millis() lúc vào ISR
+    uint8_t level;
+} pir_edge_t;
+
+// Một producer (ISR) và một consumer (SensorTask), không khóa
+typedef struct {
+    pir_edge_t edges[PIR_EDGE_QUEUE];
+    uint32_t head;          // chỉ producer ghi
+    uint32_t tail;          // chỉ consumer ghi
+    uint32_t overflows;
+} pir_edge_queue_t;
+
+// always_inline để nằm trọn trong ISR IRAM
+static inline __attribute__((always_inline))
+bool pirEdgePush(pir_edge_queue_t* q, uint32_t time, uint8_t level) {
+    uint32_t head = q->head;
+    if (head - __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE) >= PIR_EDGE_QUEUE) {
+        q->overflows++;
+        return false;
+    }
+    pir_edge_t* e = &q->edges[head & (PIR_EDGE_QUEUE - 1)];
+    e->time = time;
+    e->level = level;
+    __atomic_store_n(&q->head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+static inline bool pirEdgePop(pir_edge_queue_t* q, pir_edge_t* out) {
+    uint32_t tail = q->tail;
+    if (tail == __atomic_load_n(&q->head, __ATOMIC_ACQUIRE)) return false;
+    *out = q->edges[tail & (PIR_EDGE_QUEUE - 1)];
+    __atomic_store_n(&q->tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+typedef enum {
+    PIR_EVENT_NONE,
+    PIR_EVENT_START,            // lên HIGH ổn định, ngoài cooldown
+    PIR_EVENT_START_COOLDOWN,   // lên HIGH nhưng còn trong cooldown từ lần START trước
+    PIR_EVENT_END
+} pir_event_type_t;
+
+typedef struct {
+    pir_event_type_t type;
+    uint32_t time;              // thời điểm của sườn gốc, không phải lúc xử lý
+} pir_event_t;
+
+typedef struct {
+    uint32_t debounceMs;
+    uint32_t cooldownMs;
+    uint8_t level;              // mức đã ổn định
+    bool pending;               // có sườn đang chờ đủ debounceMs
+    uint8_t pendingLevel;
+    uint32_t pendingTime;
+    bool started;
+    uint32_t lastStart;
+} pir_filter_t;
+
+void pirFilterInit(pir_filter_t* f, uint8_t level, uint32_t debounceMs, uint32_t cooldownMs);
+void pirFilterResetCooldown(pir_filter_t* f);
+
+// Một sườn mới: sườn đang chờ được chốt nếu đã giữ đủ debounceMs tới sườn này,
+// xung ngắn hơn debounceMs bị bỏ. Trả về sự kiện của sườn vừa chốt (nếu có).
+pir_event_t pirFilterEdge(pir_filter_t* f, const pir_edge_t* edge);
+
+// Không có sườn mới tới thời điểm now: chốt sườn đang chờ nếu đã đủ debounceMs
+pir_event_t pirFilterPoll(pir_filter_t* f, uint32_t now);
+
+#endif
\ No newline at end of file
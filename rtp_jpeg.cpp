@@ -0,0 +1,93 @@
+#include "rtp_jpeg.h"
+
+static void put16(uint8_t* p, uint16_t v) {
+    p[0] = v >> 8;
+    p[1] = v & 0xFF;
+}
+
+static void put32(uint8_t* p, uint32_t v) {
+    p[0] = v >> 24;
+    p[1] = (v >> 16) & 0xFF;
+    p[2] = (v >> 8) & 0xFF;
+    p[3] = v & 0xFF;
+}
+
+// Yêu cầu frame baseline 3 component 4:2:2/4:2:0 với bảng Huffman chuẩn
+// như MJPEG của UVC (RFC 2435 không truyền DHT)
+bool rtpJpegBegin(rtp_jpeg_frame_t* f, const uint8_t* data, const jpeg_info_t* info,
+                  uint32_t timestamp90k, size_t mtu) {
+    if (info->sampling == 0x21) f->type = 0;
+    else if (info->sampling == 0x22) f->type = 1;
+    else return false;
+    if (info->components != 3 || info->qtableOffset[0] == 0) return false;
+    if (info->width > 2040 || info->height > 2040) return false;
+    if (info->eoiOffset <= info->scanOffset) return false;
+
+    if (info->restartInterval) f->type += 64;
+
+    f->q0 = data + info->qtableOffset[0];
+    f->q1 = info->qtableOffset[1] ? data + info->qtableOffset[1] : f->q0;
+    f->payload = data + info->scanOffset;
+    f->payloadLen = info->eoiOffset - info->scanOffset;
+    f->offset = 0;
+    f->mtu = mtu;
+    f->timestamp = timestamp90k;
+    f->restartInterval = info->restartInterval;
+    f->width8 = info->width / 8;
+    f->height8 = info->height / 8;
+    return true;
+}
+
+bool rtpJpegNext(rtp_jpeg_frame_t* f, uint16_t seq, uint32_t ssrc, rtp_jpeg_packet_t* pkt) {
+    if (f->offset >= f->payloadLen) return false;
+
+    bool first = (f->offset == 0);
+    size_t room = f->mtu - 12 - 8 - (f->restartInterval ? 4 : 0) - (first ? 4 + 128 : 0);
+    size_t n = f->payloadLen - f->offset;
+    if (n > room) n = room;
+    bool last = (f->offset + n == f->payloadLen);
+
+    uint8_t* hdr = pkt->header;
+    hdr[0] = 0x80;
+    hdr[1] = (last ? 0x80 : 0) | RTP_PT_JPEG;
+    put16(hdr + 2, seq);
+    put32(hdr + 4, f->timestamp);
+    put32(hdr + 8, ssrc);
+    size_t h = 12;
+
+    put32(hdr + h, f->offset);                  // byte đầu = type-specific (0)
+    hdr[h + 4] = f->type;
+    hdr[h + 5] = 255;
+    hdr[h + 6] = f->width8;
+    hdr[h + 7] = f->height8;
+    h += 8;
+
+    if (f->restartInterval) {
+        put16(hdr + h, f->restartInterval);
+        put16(hdr + h + 2, 0xFFFF);             // F = L = 1, restart count 0x3FFF
+        h += 4;
+    }
+
+    if (first) {
+        hdr[h] = 0;                             // MBZ
+        hdr[h + 1] = 0;                         // bảng 8 bit
+        put16(hdr + h + 2, 128);
+        h += 4;
+    }
+
+    pkt->headerLen = h;
+    pkt->segments = 0;
+    if (first) {
+        pkt->segment[pkt->segments] = f->q0;
+        pkt->segmentLen[pkt->segments++] = 64;
+        pkt->segment[pkt->segments] = f->q1;
+        pkt->segmentLen[pkt->segments++] = 64;
+    }
+    pkt->segment[pkt->segments] = f->payload + f->offset;
+    pkt->segmentLen[pkt->segments++] = n;
+    pkt->len = h + (first ? 128 : 0) + n;
+    pkt->last = last;
+
+    f->offset += n;
+    return true;
+}
\ No newline at end of file
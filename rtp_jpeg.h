@@ -0,0 +1,47 @@
+#ifndef RTP_JPEG_H
+#define RTP_JPEG_H
+
+#include "jpeg_scan.h"
+
+// Đóng gói RTP/JPEG (RFC 2435) theo từng gói: entropy data từ sau SOS tới
+// trước EOI cắt theo MTU, gói đầu mang bảng lượng tử (Q = 255), marker bit ở
+// gói cuối của frame. Payload trỏ thẳng vào frame, không copy. Không phụ
+// thuộc Arduino.
+
+#define RTP_PT_JPEG 26
+#define RTP_JPEG_HEADER_MAX (12 + 8 + 4 + 4)   // RTP + JPEG + restart + bảng lượng tử
+
+typedef struct {
+    const uint8_t* q0;
+    const uint8_t* q1;
+    const uint8_t* payload;
+    size_t payloadLen;
+    size_t offset;          // byte entropy data kế tiếp cần đóng gói
+    size_t mtu;
+    uint32_t timestamp;     // 90 kHz
+    uint16_t restartInterval;
+    uint8_t type;
+    uint8_t width8;
+    uint8_t height8;
+} rtp_jpeg_frame_t;
+
+// Một gói RTP: header rồi tối đa ba đoạn (bảng 0, bảng 1, entropy data)
+typedef struct {
+    uint8_t header[RTP_JPEG_HEADER_MAX];
+    size_t headerLen;
+    const uint8_t* segment[3];
+    size_t segmentLen[3];
+    int segments;
+    size_t len;             // tổng độ dài gói RTP
+    bool last;
+} rtp_jpeg_packet_t;
+
+// false nếu frame không gửi được qua RFC 2435 (không phải YUV 4:2:2/4:2:0
+// 3 component, thiếu DQT, hoặc lớn hơn 2040 pixel mỗi chiều)
+bool rtpJpegBegin(rtp_jpeg_frame_t* f, const uint8_t* data, const jpeg_info_t* info,
+                  uint32_t timestamp90k, size_t mtu);
+
+// Gói kế tiếp của frame, false khi đã hết
+bool rtpJpegNext(rtp_jpeg_frame_t* f, uint16_t seq, uint32_t ssrc, rtp_jpeg_packet_t* pkt);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,540 @@
+#include "rtsp_server.h"
+#include "camera_handler.h"
+#include "rtp_jpeg.h"
+#include <lwip/sockets.h>
+
+// Mỗi session đọc thẳng frame từ framePool như /stream: payload RTP trỏ vào
+// slot (entropy data + bảng lượng tử trong DQT), không copy sang buffer riêng.
+// Session gửi frame dần qua từng vòng của rtspTask, nên một client TCP chậm
+// chỉ làm chậm chính nó.
+
+#define RTSP_REQ_MAX 768
+
+typedef struct {
+    bool active;
+    bool playing;
+    bool interleaved;
+    bool holdsCamera;
+    WiFiClient client;
+    uint32_t sessionId;
+    uint8_t rtpChannel;
+    struct sockaddr_in rtpAddr;
+    uint16_t rtcpPort;      // cổng RTCP của client (UDP), gói từ đó tính là keep-alive
+    uint16_t rtpSeq;
+    uint32_t ssrc;
+    uint32_t lastSeq;
+    unsigned long lastActivity;
+    char req[RTSP_REQ_MAX];
+    size_t reqLen;
+    size_t skip;            // byte RTCP xen kẽ ('$') client gửi lên, bỏ qua
+
+    // frame đang gửi và gói RTP hiện tại (gói TCP có thể ghi dở)
+    bool sending;
+    FrameRef frame;
+    rtp_jpeg_frame_t rtp;
+    rtp_jpeg_packet_t pkt;
+    uint8_t pktPrefix[4];   // '$', channel, độ dài gói (RTSP interleaved)
+    size_t pktLen;          // 0 = chưa có gói chờ gửi
+    size_t pktSent;
+    unsigned long lastProgress;
+} rtsp_session_t;
+
+static WiFiServer rtspServer(RTSP_PORT);
+static TaskHandle_t rtspTaskHandle = NULL;
+static volatile bool rtspRunning = false;
+static int rtpSocket = -1;
+static int rtcpSocket = -1;
+static rtsp_session_t sessions[RTSP_MAX_SESSIONS];
+
+// Giá trị header (không phân biệt hoa thường), false nếu không có
+static bool headerValue(const char* req, const char* name, char* out, size_t outLen) {
+    size_t nameLen = strlen(name);
+    const char* line = strstr(req, "\r\n");
+
+    while (line) {
+        line += 2;
+        if (strncasecmp(line, name, nameLen) == 0 && line[nameLen] == ':') {
+            const char* v = line + nameLen + 1;
+            while (*v == ' ') v++;
+            size_t n = strcspn(v, "\r\n");
+            if (n >= outLen) n = outLen - 1;
+            memcpy(out, v, n);
+            out[n] = '\0';
+            return true;
+        }
+        line = strstr(line, "\r\n");
+    }
+    return false;
+}
+
+static void finishFrame(rtsp_session_t* s) {
+    if (s->sending) framePool.release(s->frame);
+    s->sending = false;
+    s->pktLen = 0;
+}
+
+static void closeSession(rtsp_session_t* s) {
+    Serial.printf("[RTSP] Session %08X closed\n", s->sessionId);
+    finishFrame(s);
+    if (s->holdsCamera) cameraRelease();
+    s->client.stop();
+    s->active = false;
+    s->playing = false;
+    s->holdsCamera = false;
+}
+
+static void sendResponse(rtsp_session_t* s, const char* status, const char* cseq,
+                         const char* headers, const char* body) {
+    char resp[512];
+    int n = snprintf(resp, sizeof(resp), "RTSP/1.0 %s\r\nCSeq: %s\r\n%s", status, cseq, headers);
+    if (s->sessionId) {
+        n += snprintf(resp + n, sizeof(resp) - n, "Session: %08X;timeout=%u\r\n",
+                      s->sessionId, RTSP_SESSION_TIMEOUT_MS / 1000);
+    }
+    if (body) {
+        n += snprintf(resp + n, sizeof(resp) - n, "Content-Length: %u\r\n", (unsigned)strlen(body));
+    }
+    n += snprintf(resp + n, sizeof(resp) - n, "\r\n");
+
+    s->client.write((const uint8_t*)resp, min(n, (int)sizeof(resp) - 1));
+    if (body) s->client.write((const uint8_t*)body, strlen(body));
+}
+
+static void handleDescribe(rtsp_session_t* s, const char* cseq) {
+    String ip = WiFi.localIP().toString();
+    const camera_profile_t& profile = cameraProfiles[activeCameraProfile()];
+
+    char sdp[256];
+    snprintf(sdp, sizeof(sdp),
+             "v=0\r\no=- %u 1 IN IP4 %s\r\ns=%s\r\nc=IN IP4 0.0.0.0\r\nt=0 0\r\na=control:*\r\n"
+             "m=video 0 RTP/AVP %d\r\na=control:track1\r\na=framerate:%u\r\n",
+             (unsigned)millis(), ip.c_str(), MDNS_HOSTNAME, RTP_PT_JPEG,
+             (unsigned)(10000000 / profile.interval));
+
+    char headers[128];
+    snprintf(headers, sizeof(headers), "Content-Base: rtsp://%s:%d/\r\nContent-Type: application/sdp\r\n",
+             ip.c_str(), RTSP_PORT);
+    sendResponse(s, "200 OK", cseq, headers, sdp);
+}
+
+static void handleSetup(rtsp_session_t* s, const char* cseq) {
+    char transport[128];
+    if (!headerValue(s->req, "Transport", transport, sizeof(transport))) {
+        sendResponse(s, "461 Unsupported Transport", cseq, "", nullptr);
+        return;
+    }
+
+    char headers[160];
+    const char* p;
+    if (strstr(transport, "RTP/AVP/TCP") || strstr(transport, "interleaved=")) {
+        // RTP xen kẽ trên kết nối RTSP, dùng khi UDP bị chặn hoặc mất gói nhiều
+        s->interleaved = true;
+        s->rtpChannel = (p = strstr(transport, "interleaved=")) ? atoi(p + 12) : 0;
+        snprintf(headers, sizeof(headers), "Transport: RTP/AVP/TCP;unicast;interleaved=%u-%u;ssrc=%08X\r\n",
+                 s->rtpChannel, s->rtpChannel + 1, s->ssrc);
+    } else if ((p = strstr(transport, "client_port=")) != nullptr) {
+        int rtpPort = atoi(p + 12);
+        const char* dash = strchr(p + 12, '-');
+        s->rtcpPort = dash ? atoi(dash + 1) : rtpPort + 1;
+        s->interleaved = false;
+        memset(&s->rtpAddr, 0, sizeof(s->rtpAddr));
+        s->rtpAddr.sin_family = AF_INET;
+        s->rtpAddr.sin_port = htons(rtpPort);
+        s->rtpAddr.sin_addr.s_addr = (uint32_t)s->client.remoteIP();
+        snprintf(headers, sizeof(headers),
+                 "Transport: RTP/AVP;unicast;client_port=%d-%d;server_port=%d-%d;ssrc=%08X\r\n",
+                 rtpPort, s->rtcpPort, RTSP_RTP_PORT, RTSP_RTP_PORT + 1, s->ssrc);
+    } else {
+        sendResponse(s, "461 Unsupported Transport", cseq, "", nullptr);
+        return;
+    }
+
+    if (!s->sessionId) s->sessionId = esp_random();
+    sendResponse(s, "200 OK", cseq, headers, nullptr);
+}
+
+static void handlePlay(rtsp_session_t* s, const char* cseq) {
+    if (!s->sessionId) {
+        sendResponse(s, "455 Method Not Valid in This State", cseq, "", nullptr);
+        return;
+    }
+
+    // RTSP task không phải loop task: UVC bật ở handleCameraLoop
+    if (!s->holdsCamera) {
+        cameraAcquireFromTask();
+        s->holdsCamera = true;
+    }
+
+    char headers[64];
+    snprintf(headers, sizeof(headers), "Range: npt=0.000-\r\nRTP-Info: url=track1;seq=%u\r\n", s->rtpSeq);
+    sendResponse(s, "200 OK", cseq, headers, nullptr);
+
+    s->playing = true;
+    s->lastSeq = 0;
+    Serial.printf("[RTSP] Session %08X playing (%s)\n", s->sessionId, s->interleaved ? "TCP" : "UDP");
+}
+
+// Xử lý một request hoàn chỉnh trong s->req. Trả false nếu session đã đóng.
+static bool handleRequest(rtsp_session_t* s) {
+    char method[16] = "";
+    sscanf(s->req, "%15s", method);
+
+    char cseq[16];
+    if (!headerValue(s->req, "CSeq", cseq, sizeof(cseq))) strcpy(cseq, "0");
+
+    s->lastActivity = millis();
+
+    if (strcmp(method, "OPTIONS") == 0) {
+        sendResponse(s, "200 OK", cseq,
+                     "Public: OPTIONS, DESCRIBE, SETUP, PLAY, PAUSE, TEARDOWN, GET_PARAMETER\r\n", nullptr);
+    } else if (strcmp(method, "DESCRIBE") == 0) {
+        handleDescribe(s, cseq);
+    } else if (strcmp(method, "SETUP") == 0) {
+        handleSetup(s, cseq);
+    } else if (strcmp(method, "PLAY") == 0) {
+        handlePlay(s, cseq);
+    } else if (strcmp(method, "PAUSE") == 0) {
+        // nhả frame đang gửi dở và camera, PLAY sau đó giữ lại camera
+        s->playing = false;
+        finishFrame(s);
+        if (s->holdsCamera) {
+            cameraRelease();
+            s->holdsCamera = false;
+        }
+        sendResponse(s, "200 OK", cseq, "", nullptr);
+    } else if (strcmp(method, "GET_PARAMETER") == 0 || strcmp(method, "SET_PARAMETER") == 0) {
+        // keep-alive của client
+        sendResponse(s, "200 OK", cseq, "", nullptr);
+    } else if (strcmp(method, "TEARDOWN") == 0) {
+        sendResponse(s, "200 OK", cseq, "", nullptr);
+        closeSession(s);
+        return false;
+    } else {
+        sendResponse(s, "501 Not Implemented", cseq, "", nullptr);
+    }
+    return true;
+}
+
+// Đọc non-blocking, tách request theo "\r\n\r\n", bỏ qua gói RTCP xen kẽ.
+// RTCP receiver report cũng tính là client còn sống (RFC 2326 mục 12.37).
+static bool pollRequests(rtsp_session_t* s) {
+    while (s->client.available() > 0) {
+        int c = s->client.read();
+        if (c < 0) break;
+        s->lastActivity = millis();
+
+        if (s->skip > 0) {
+            s->skip--;
+            continue;
+        }
+
+        if (s->reqLen >= RTSP_REQ_MAX - 1) {
+            Serial.println("[RTSP] Request too large");
+            closeSession(s);
+            return false;
+        }
+        s->req[s->reqLen++] = (char)c;
+
+        if (s->req[0] == '$') {
+            if (s->reqLen == 4) {
+                s->skip = ((uint8_t)s->req[2] << 8) | (uint8_t)s->req[3];
+                s->reqLen = 0;
+            }
+            continue;
+        }
+
+        if (s->reqLen >= 4 && memcmp(s->req + s->reqLen - 4, "\r\n\r\n", 4) == 0) {
+            s->req[s->reqLen] = '\0';
+            s->reqLen = 0;
+            if (!handleRequest(s)) return false;
+        }
+    }
+    return true;
+}
+
+// RTCP receiver report qua UDP tới server_port + 1: không dùng nội dung,
+// chỉ làm keep-alive cho session có đúng địa chỉ và cổng RTCP của client
+static void pollRtcp() {
+    uint8_t buf[256];
+    struct sockaddr_in from;
+    socklen_t fromLen = sizeof(from);
+
+    while (lwip_recvfrom(rtcpSocket, buf, sizeof(buf), MSG_DONTWAIT, (struct sockaddr*)&from, &fromLen) > 0) {
+        for (int i = 0; i < RTSP_MAX_SESSIONS; i++) {
+            rtsp_session_t* s = &sessions[i];
+            if (!s->active || s->interleaved || s->rtpAddr.sin_addr.s_addr != from.sin_addr.s_addr) continue;
+            if (ntohs(from.sin_port) == s->rtcpPort) s->lastActivity = millis();
+        }
+        fromLen = sizeof(from);
+    }
+}
+
+// Frame tiếp theo cho session rảnh, frame không đóng gói được thì bỏ qua
+static void beginFrame(rtsp_session_t* s) {
+    if (!framePool.acquireLatest(s->frame, s->lastSeq)) return;
+    s->lastSeq = s->frame.seq;
+
+    if (!rtpJpegBegin(&s->rtp, s->frame.data, s->frame.info, s->frame.timestamp * 90, RTSP_RTP_MTU)) {
+        framePool.release(s->frame);
+        return;
+    }
+    s->sending = true;
+    s->pktLen = 0;
+    s->lastProgress = millis();
+}
+
+// Ghi tiếp gói hiện tại lên kết nối RTSP bằng writev non-blocking. Trả false
+// nếu socket lỗi; pktSent < pktLen nghĩa là socket đầy, ghi tiếp ở vòng sau.
+static bool continueInterleaved(rtsp_session_t* s) {
+    const rtp_jpeg_packet_t& pkt = s->pkt;
+    const uint8_t* bases[5] = { s->pktPrefix, pkt.header };
+    size_t lens[5] = { sizeof(s->pktPrefix), pkt.headerLen };
+    int parts = 2;
+    for (int i = 0; i < pkt.segments; i++, parts++) {
+        bases[parts] = pkt.segment[i];
+        lens[parts] = pkt.segmentLen[i];
+    }
+
+    struct iovec iov[5];
+    int cnt = 0;
+    size_t skip = s->pktSent;
+    for (int i = 0; i < parts; i++) {
+        if (skip >= lens[i]) {
+            skip -= lens[i];
+            continue;
+        }
+        iov[cnt].iov_base = (void*)(bases[i] + skip);
+        iov[cnt].iov_len = lens[i] - skip;
+        skip = 0;
+        cnt++;
+    }
+
+    ssize_t n = lwip_writev(s->client.fd(), iov, cnt);
+    if (n < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    s->pktSent += n;
+    s->lastProgress = millis();
+    return true;
+}
+
+// Gửi tối đa RTSP_PACE_BURST gói của frame đang gửi rồi nhường cho session
+// khác, để cả frame không dồn vào hàng đợi Wi-Fi trong một lần. Trả false
+// nếu phải đóng session.
+static bool pumpFrame(rtsp_session_t* s) {
+    for (int burst = 0; burst < RTSP_PACE_BURST; burst++) {
+        if (s->pktLen == 0) {
+            if (!rtpJpegNext(&s->rtp, s->rtpSeq, s->ssrc, &s->pkt)) {
+                finishFrame(s);
+                return true;
+            }
+            s->rtpSeq++;
+            s->pktSent = 0;
+            s->pktLen = s->pkt.len;
+            if (s->interleaved) {
+                s->pktPrefix[0] = '$';
+                s->pktPrefix[1] = s->rtpChannel;
+                s->pktPrefix[2] = s->pkt.len >> 8;
+                s->pktPrefix[3] = s->pkt.len & 0xFF;
+                s->pktLen += sizeof(s->pktPrefix);
+            }
+        }
+
+        if (s->interleaved) {
+            if (!continueInterleaved(s)) return false;
+            if (s->pktSent < s->pktLen) return true;
+        } else {
+            struct iovec iov[4];
+            int cnt = 0;
+            iov[cnt].iov_base = s->pkt.header;
+            iov[cnt++].iov_len = s->pkt.headerLen;
+            for (int i = 0; i < s->pkt.segments; i++) {
+                iov[cnt].iov_base = (void*)s->pkt.segment[i];
+                iov[cnt++].iov_len = s->pkt.segmentLen[i];
+            }
+
+            struct msghdr msg = {};
+            msg.msg_name = &s->rtpAddr;
+            msg.msg_namelen = sizeof(s->rtpAddr);
+            msg.msg_iov = iov;
+            msg.msg_iovlen = cnt;
+            // UDP hết pbuf thì mất gói, client tự bỏ frame thiếu
+            lwip_sendmsg(rtpSocket, &msg, 0);
+            s->lastProgress = millis();
+        }
+
+        s->pktLen = 0;
+        if (s->pkt.last) {
+            finishFrame(s);
+            return true;
+        }
+    }
+    return true;
+}
+
+static void acceptSession() {
+    WiFiClient client = rtspServer.available();
+    if (!client) return;
+
+    for (int i = 0; i < RTSP_MAX_SESSIONS; i++) {
+        rtsp_session_t* s = &sessions[i];
+        if (s->active) continue;
+
+        s->active = true;
+        s->playing = false;
+        s->interleaved = false;
+        s->holdsCamera = false;
+        s->client = client;
+        s->sessionId = 0;
+        s->rtpSeq = (uint16_t)esp_random();
+        s->ssrc = esp_random();
+        s->lastSeq = 0;
+        s->lastActivity = millis();
+        s->reqLen = 0;
+        s->skip = 0;
+        s->sending = false;
+        s->pktLen = 0;
+
+        // RTP xen kẽ ghi non-blocking, client không nhận thêm byte nào quá
+        // STREAM_SEND_TIMEOUT_MS thì đóng session
+        int fd = client.fd();
+        lwip_fcntl(fd, F_SETFL, lwip_fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        client.setNoDelay(true);
+
+        Serial.printf("[RTSP] Client %s connected (slot %d)\n", client.remoteIP().toString().c_str(), i);
+        return;
+    }
+
+    Serial.println("[RTSP] Max sessions reached, rejecting");
+    client.stop();
+}
+
+static void rtspTask(void* pvParameters) {
+    while (rtspRunning) {
+        acceptSession();
+        pollRtcp();
+
+        uint32_t seen = framePool.latestSeq();
+        bool anyPlaying = false;
+        bool anySending = false;
+        for (int i = 0; i < RTSP_MAX_SESSIONS; i++) {
+            rtsp_session_t* s = &sessions[i];
+            if (!s->active) continue;
+
+            if (!s->client.connected()) {
+                closeSession(s);
+                continue;
+            }
+            // response RTSP không được chen vào giữa một gói RTP xen kẽ ghi dở
+            if (s->pktLen == 0 && !pollRequests(s)) continue;
+
+            // UDP dựa vào keep-alive RTSP, TCP còn có RTCP xen kẽ
+            if (millis() - s->lastActivity > RTSP_SESSION_TIMEOUT_MS) {
+                Serial.printf("[RTSP] Session %08X timeout\n", s->sessionId);
+                closeSession(s);
+                continue;
+            }
+            if (s->sending && millis() - s->lastProgress > STREAM_SEND_TIMEOUT_MS) {
+                Serial.printf("[RTSP] Session %08X send timeout\n", s->sessionId);
+                closeSession(s);
+                continue;
+            }
+
+            if (s->playing && !s->sending) beginFrame(s);
+            if (s->sending && !pumpFrame(s)) {
+                Serial.printf("[RTSP] Session %08X send failed\n", s->sessionId);
+                closeSession(s);
+                continue;
+            }
+
+            if (s->playing) anyPlaying = true;
+            if (s->sending) anySending = true;
+        }
+
+        if (anySending) {
+            // giãn các đợt gói của frame, còn đọc keep-alive giữa các đợt
+            vTaskDelay(pdMS_TO_TICKS(RTSP_PACE_INTERVAL_MS));
+        } else if (anyPlaying) {
+            framePool.waitForFrame(seen, pdMS_TO_TICKS(50));
+        } else {
+            vTaskDelay(pdMS_TO_TICKS(20));
+        }
+    }
+
+    for (int i = 0; i < RTSP_MAX_SESSIONS; i++) {
+        if (sessions[i].active) closeSession(&sessions[i]);
+    }
+
+    rtspTaskHandle = NULL;
+    vTaskDelete(NULL);
+}
+
+static int bindUdp(uint16_t port) {
+    int fd = lwip_socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        Serial.printf("[RTSP] Cannot create UDP socket for port %d\n", port);
+        return -1;
+    }
+
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (lwip_bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        Serial.printf("[RTSP] Cannot bind UDP port %d (errno %d)\n", port, errno);
+        lwip_close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void startRtspServer() {
+    if (rtspTaskHandle != NULL) return;
+
+    // SETUP quảng bá server_port RTP-RTCP nên cả hai cổng phải bind được
+    rtpSocket = bindUdp(RTSP_RTP_PORT);
+    if (rtpSocket < 0) return;
+    rtcpSocket = bindUdp(RTSP_RTP_PORT + 1);
+    if (rtcpSocket < 0) {
+        lwip_close(rtpSocket);
+        rtpSocket = -1;
+        return;
+    }
+
+    rtspServer.begin();
+    rtspServer.setNoDelay(true);
+
+    rtspRunning = true;
+    if (xTaskCreatePinnedToCore(rtspTask, "RtspTask", 6144, NULL, 2, &rtspTaskHandle, APP_CPU) != pdPASS) {
+        rtspRunning = false;
+        rtspTaskHandle = NULL;
+        rtspServer.stop();
+        lwip_close(rtpSocket);
+        lwip_close(rtcpSocket);
+        rtpSocket = -1;
+        rtcpSocket = -1;
+        return;
+    }
+
+    Serial.printf("[RTSP] Server: rtsp://%s:%d/\n", WiFi.localIP().toString().c_str(), RTSP_PORT);
+}
+
+void stopRtspServer() {
+    if (rtspTaskHandle == NULL) return;
+
+    // task tự đóng session và nhả camera rồi mới thoát
+    rtspRunning = false;
+    for (int i = 0; i < 50 && rtspTaskHandle != NULL; i++) {
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+
+    rtspServer.stop();
+    if (rtpSocket >= 0) {
+        lwip_close(rtpSocket);
+        rtpSocket = -1;
+    }
+    if (rtcpSocket >= 0) {
+        lwip_close(rtcpSocket);
+        rtcpSocket = -1;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,11 @@
+#ifndef RTSP_SERVER_H
+#define RTSP_SERVER_H
+
+#include "config.h"
+
+// RTSP (RFC 2326) + RTP/JPEG (RFC 2435) cho NVR: rtsp://<ip>:RTSP_PORT/
+// RTP qua UDP, hoặc xen kẽ trên kết nối RTSP (TCP) nếu client yêu cầu.
+void startRtspServer();
+void stopRtspServer();
+
+#endif
\ No newline at end of file
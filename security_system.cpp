@@ -2,6 +2,12 @@
 #include "wifi_manager.h"
 #include "audio_handler.h"
 #include "sensors_handler.h"
+#include "event_buffer.h"
+#include "event_recorder.h"
+#include "camera_handler.h"
+#include "ws_stream.h"
+#include "metrics.h"
+#include "trace.h"
 
 SecurityState currentSecurityState = SECURITY_IDLE;
 unsigned long motionDetectedTime = 0;
@@ -17,8 +23,25 @@ PubSubClient mqttClient(espClient);
 
 static TaskHandle_t smsTaskHandle = NULL;
 
+// SensorTask là nơi duy nhất đổi currentSecurityState; NetTask và sensor
+// gửi sự kiện vào securityEventQueue. Ngược lại máy trạng thái không tự
+// publish MQTT (có thể chặn trên socket) mà xếp vào mqttOutQueue cho NetTask.
+typedef struct {
+    char topic[48];
+    char payload[256];
+    bool retained;
+} mqtt_out_t;
+
+static QueueHandle_t securityEventQueue = NULL;
+static QueueHandle_t mqttOutQueue = NULL;
+
 void initSecuritySystem() {
+    securityEventQueue = xQueueCreate(SECURITY_EVENT_QUEUE, sizeof(security_event_t));
+    mqttOutQueue = xQueueCreate(MQTT_OUT_QUEUE, sizeof(mqtt_out_t));
+    
     resetSecurityState();
+    startEventBuffer();
+    startEventRecorder();
     initSIM();
     
     if (wifiState == WIFI_STA_OK) {
@@ -126,7 +149,11 @@ void sendSMSTask(void* parameter) {
     Serial.printf("[SMS_TASK] Started on Core %d\n", xPortGetCoreID());
     unsigned long startTime = millis();
     
-    bool result = sendSMS(data->phoneNumber, data->message);
+    bool result;
+    {
+        TraceSpan span(TRACE_SMS);
+        result = sendSMS(data->phoneNumber, data->message);
+    }
     
     Serial.printf("[SMS_TASK] Completed in %lu ms (Result: %s)\n", 
                   millis() - startTime, result ? "SUCCESS" : "FAILED");
@@ -185,6 +212,7 @@ void connectMQTT()
         
         mqttClient.subscribe(MQTT_TOPIC_COMMAND);
         mqttClient.subscribe(MQTT_TOPIC_FAMILY_DETECT);
+        mqttClient.subscribe(MQTT_TOPIC_CAMERA_PROFILE);
         
         publishMQTTStatus("ESP32S3 online");
         Serial.println(" OK");
@@ -218,11 +246,43 @@ void mqttCallback(char* topic, byte* payload, unsigned int length)
             float confidence = doc["confidence"] | 0.0;
             
             Serial.printf("[SECURITY] Family: %s (%.2f)\n", user_name, confidence);
-            onFamilyMemberDetected();
+            postSecurityEvent(SECURITY_EVT_FAMILY_DETECTED);
+        }
+    }
+    else if (strcmp(topic, MQTT_TOPIC_CAMERA_PROFILE) == 0) {
+        // payload là tên profile, ví dụ "vga"
+        if (!setCameraProfile(findCameraProfile(message))) {
+            Serial.printf("[MQTT] Unknown camera profile: %s\n", message);
         }
     }
 }
 
+// publish() ghi thẳng vào socket nên có thể chặn NetTask khi mạng chậm
+static bool mqttPublish(const char* topic, const char* payload, bool retained) {
+    uint32_t start = ESP.getCycleCount();
+    bool ok = mqttClient.publish(topic, payload, retained);
+    metricObserveCycles(MET_HIST_MQTT_PUBLISH, start);
+    metricInc(ok ? MET_MQTT_PUBLISHED : MET_MQTT_PUBLISH_FAILED);
+    return ok;
+}
+
+// Chỉ xếp hàng, NetTask publish ở handleMqttLoop
+static void queueMqtt(const char* topic, const char* payload, bool retained) {
+    if (!mqttConnected || mqttOutQueue == NULL) return;
+    
+    mqtt_out_t msg;
+    strncpy(msg.topic, topic, sizeof(msg.topic) - 1);
+    msg.topic[sizeof(msg.topic) - 1] = '\0';
+    strncpy(msg.payload, payload, sizeof(msg.payload) - 1);
+    msg.payload[sizeof(msg.payload) - 1] = '\0';
+    msg.retained = retained;
+    
+    if (xQueueSend(mqttOutQueue, &msg, 0) != pdTRUE) {
+        Serial.printf("[MQTT] Outbox full, dropping %s\n", topic);
+        metricInc(MET_MQTT_PUBLISH_FAILED);
+    }
+}
+
 void publishMQTTStatus(const char* message) {
     if (!mqttConnected) return;
     
@@ -235,7 +295,7 @@ void publishMQTTStatus(const char* message) {
     char buffer[256];
     serializeJson(doc, buffer);
     
-    mqttClient.publish(MQTT_TOPIC_STATUS, buffer);
+    queueMqtt(MQTT_TOPIC_STATUS, buffer, false);
 }
 
 void sendNodeCommand(const char* device, const char* action) 
@@ -256,13 +316,26 @@ void sendNodeCommand(const char* device, const char* action)
     String topic = "security/node/";
     topic += device;
     
-    bool ok = mqttClient.publish(topic.c_str(), buffer, false);
+    queueMqtt(topic.c_str(), buffer, false);
     
-    Serial.printf("[MQTT] -> %s: %s (%s)\n", device, action, ok ? "OK" : "FAIL");
+    Serial.printf("[MQTT] -> %s: %s\n", device, action);
 }
 
-void handleSecuritySystem() 
+bool postSecurityEvent(SecurityEvent type) {
+    if (securityEventQueue == NULL) return false;
+    
+    security_event_t event = { type, millis() };
+    if (xQueueSend(securityEventQueue, &event, 0) != pdTRUE) {
+        Serial.printf("[SECURITY] Event queue full, dropping %d\n", (int)type);
+        return false;
+    }
+    return true;
+}
+
+// NetTask: kết nối lại, mqttClient.loop() và xả outbox
+void handleMqttLoop() 
 {
+    TraceSpan span(TRACE_MQTT);
     static unsigned long lastMQTTReconnectAttempt = 0;
     const unsigned long MQTT_RECONNECT_INTERVAL = 5000;
     
@@ -291,24 +364,72 @@ void handleSecuritySystem()
         }
     }
     
+    mqtt_out_t msg;
+    while (mqttOutQueue != NULL && xQueueReceive(mqttOutQueue, &msg, 0) == pdTRUE) 
+    {
+        if (!mqttConnected) continue;
+        if (!mqttPublish(msg.topic, msg.payload, msg.retained)) 
+        {
+            Serial.printf("[MQTT] Publish to %s failed\n", msg.topic);
+        }
+    }
+}
+
+// SensorTask: xử lý sự kiện theo thứ tự rồi kiểm tra các mốc thời gian
+void handleSecuritySystem() 
+{
+    TraceSpan span(TRACE_SECURITY);
+    
+    security_event_t event;
+    while (securityEventQueue != NULL && xQueueReceive(securityEventQueue, &event, 0) == pdTRUE) 
+    {
+        switch (event.type) 
+        {
+            case SECURITY_EVT_MOTION_CONFIRMED:
+                onMotionDetected(event.time);
+                break;
+            case SECURITY_EVT_MOTION_SEEN:
+                updateMotionTimestamp(event.time);
+                break;
+            case SECURITY_EVT_MOTION_ENDED:
+                onMotionEnded();
+                break;
+            case SECURITY_EVT_FAMILY_DETECTED:
+                onFamilyMemberDetected();
+                break;
+            case SECURITY_EVT_EMERGENCY_UNLOCK:
+                onEmergencyUnlock();
+                break;
+        }
+    }
+    
     checkSecurityTimers();
+    
+    // báo trạng thái mới cho dashboard qua /ws/stream
+    static SecurityState lastReportedState = SECURITY_IDLE;
+    if (currentSecurityState != lastReportedState) 
+    {
+        lastReportedState = currentSecurityState;
+        char event[WS_EVENT_MAX];
+        snprintf(event, sizeof(event), "{\"type\":\"security\",\"state\":%d}", (int)currentSecurityState);
+        wsPublishEvent(event);
+    }
 }
 
-void onMotionDetected() {
-    lastMotionSeenTime = millis();
+void onMotionDetected(unsigned long time) {
+    lastMotionSeenTime = time;
     
     if (currentSecurityState == SECURITY_IDLE) {
         Serial.println("\n[SECURITY] Motion detected - Starting countdown");
         
-        if (isAudioPlaying()) {
-            stopAudio();
-            vTaskDelay(pdMS_TO_TICKS(100));
-        }
+        // loop task đang phát sẽ dừng file cũ trước khi phát
+        requestAudio(AUDIO_MOTION_DETECTED);
         
-        playAudio(AUDIO_MOTION_DETECTED);
+        // đóng băng pre-roll + ghi tiếp post-roll trong ring PSRAM
+        triggerEventClip();
         
         currentSecurityState = SECURITY_WAITING_OWNER_SMS;
-        motionDetectedTime = millis();
+        motionDetectedTime = time;
         ownerSmsAlreadySent = false;
         neighborSmsAlreadySent = false;
         familyMemberDetected = false;
@@ -319,18 +440,21 @@ void onMotionDetected() {
             doc["timestamp"] = millis();
             doc["security_state"] = currentSecurityState;
             
-            char buffer[300];
+            char buffer[256];
             serializeJson(doc, buffer);
             
-            mqttClient.publish(MQTT_TOPIC_ALERT, buffer, true);
+            queueMqtt(MQTT_TOPIC_ALERT, buffer, true);
         }
         
         publishMQTTStatus("Motion detected");
     }
 }
 
-void updateMotionTimestamp() {
-    lastMotionSeenTime = millis();
+// PIR vẫn HIGH chỉ gia hạn khi đang đếm ngược
+void updateMotionTimestamp(unsigned long time) {
+    if (currentSecurityState != SECURITY_IDLE) {
+        lastMotionSeenTime = time;
+    }
 }
 
 // ✅ HÀM MỚI: Xử lý khi motion kết thúc
@@ -357,9 +481,7 @@ void onFamilyMemberDetected() {
     
     familyMemberDetected = true;
     
-    if (isAudioPlaying()) {
-        stopAudio();
-    }
+    requestAudioStop();
     
     sendNodeCommand("buzzer", "off");
     sendNodeCommand("lock", "unlock");
@@ -369,6 +491,20 @@ void onFamilyMemberDetected() {
     publishMQTTStatus("Family confirmed - system disarmed");
 }
 
+void onEmergencyUnlock() {
+    Serial.println("[EMERGENCY] Executing unlock sequence");
+    
+    requestAudioStop();
+    sendNodeCommand("buzzer", "off");
+    sendNodeCommand("lock", "unlock");
+    
+    if (currentSecurityState != SECURITY_IDLE) {
+        resetSecurityState();
+    }
+    
+    Serial.println("[EMERGENCY] Unlock completed");
+}
+
 void resetSecurityState() {
     Serial.println("[SECURITY] Reset to IDLE");
     
@@ -16,6 +16,7 @@
 #define MQTT_TOPIC_ALERT         "security/camera/alert"
 #define MQTT_TOPIC_FAMILY_DETECT "security/camera/family_detected"
 #define MQTT_TOPIC_CONFIRMATION  "security/camera/confirmation"
+#define MQTT_TOPIC_CAMERA_PROFILE "security/camera/profile"
 
 #define PHONE_NUMBER_OWNER    "0976168240"
 #define PHONE_NUMBER_NEIGHBOR "0976168240"
@@ -32,6 +33,20 @@ enum SecurityState {
     SECURITY_ALARM_ACTIVE
 };
 
+// Sự kiện gửi vào máy trạng thái, xử lý trong SensorTask
+enum SecurityEvent {
+    SECURITY_EVT_MOTION_CONFIRMED,   // PIR lên HIGH và camera xác nhận
+    SECURITY_EVT_MOTION_SEEN,        // PIR vẫn HIGH
+    SECURITY_EVT_MOTION_ENDED,
+    SECURITY_EVT_FAMILY_DETECTED,
+    SECURITY_EVT_EMERGENCY_UNLOCK
+};
+
+struct security_event_t {
+    SecurityEvent type;
+    unsigned long time;
+};
+
 struct SMSData {
     char phoneNumber[16];
     char message[160];
@@ -57,11 +72,16 @@ void mqttCallback(char* topic, byte* payload, unsigned int length);
 void publishMQTTStatus(const char* message);
 void sendNodeCommand(const char* device, const char* action);
 
+bool postSecurityEvent(SecurityEvent type);
 void handleSecuritySystem();
-void onMotionDetected();
-void updateMotionTimestamp();
+void handleMqttLoop();
+
+// Chỉ gọi trong SensorTask (qua handleSecuritySystem), task khác dùng postSecurityEvent
+void onMotionDetected(unsigned long time);
+void updateMotionTimestamp(unsigned long time);
 void onMotionEnded();  // ✅ HÀM MỚI
 void onFamilyMemberDetected();
+void onEmergencyUnlock();
 void resetSecurityState();
 void checkSecurityTimers();
 
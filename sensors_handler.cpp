@@ -1,6 +1,9 @@
 #include "sensors_handler.h"
 #include "audio_handler.h"
 #include "security_system.h"
+#include "motion_detector.h"
+#include "ws_stream.h"
+#include "pir_edges.h"
 #include "driver/gpio.h"
 
 bool systemReady = false;
@@ -23,6 +26,20 @@ unsigned long lastLDRRead = 0;
 unsigned long lastMotionUpdateTime = 0;
 const unsigned long motionUpdateInterval = 500;
 
+// PIR chờ camera xác nhận trước khi báo động
+static bool motionConfirmPending = false;
+static bool lastTriggerRejected = false;
+
+// Sườn PIR từ ISR, debounce + cooldown tính theo thời điểm sườn chứ không
+// theo lúc SensorTask kịp đọc
+static pir_edge_queue_t pirEdges;
+static pir_filter_t pirFilter;
+static uint32_t pirOverflowsSeen = 0;
+
+static void IRAM_ATTR pirIsr() {
+    pirEdgePush(&pirEdges, millis(), digitalRead(PIR_PIN));
+}
+
 void initializeSensors() 
 {
     pinMode(PIR_PIN, INPUT);
@@ -44,7 +61,14 @@ void initializeSensors()
     lastMotionTime = 0;
     lastMotionUpdateTime = 0;
     
-    Serial.println("[PIR] Initialized (polling mode)");
+    // PIR đã HIGH lúc khởi động được xử lý như một sườn lên
+    pirFilterInit(&pirFilter, LOW, PIR_DEBOUNCE_MS, motionCooldown);
+    if (radarVal == HIGH) pirEdgePush(&pirEdges, millis(), HIGH);
+    attachInterrupt(digitalPinToInterrupt(PIR_PIN), pirIsr, CHANGE);
+    
+    Serial.println("[PIR] Initialized (edge interrupt mode)");
+    
+    startMotionDetector();
     
     updateLEDsBasedOnConditions();
 }
@@ -58,6 +82,10 @@ void readLDRSensor() {
     if (wasDark != isDark) 
     {
         Serial.printf("[LDR] Light changed: %s (value=%d)\n", isDark ? "DARK" : "BRIGHT", ldrValue);
+        
+        char event[WS_EVENT_MAX];
+        snprintf(event, sizeof(event), "{\"type\":\"ldr\",\"dark\":%s,\"value\":%d}", isDark ? "true" : "false", ldrValue);
+        wsPublishEvent(event);
         updateLEDsBasedOnConditions();
     }
 }
@@ -115,65 +143,108 @@ void handleLDRLoop()
 void resetMotionCooldown() 
 {
     lastMotionTime = 0;
+    pirFilterResetCooldown(&pirFilter);
     Serial.println("[MOTION] Cooldown reset");
 }
 
+static void handlePirEvent(const pir_event_t& ev) 
+{
+    // ✅ Motion START
+    if (ev.type == PIR_EVENT_START) 
+    {
+        Serial.println("\n[MOTION] Motion started");
+        wsPublishEvent("{\"type\":\"pir\",\"motion\":true}");
+        
+        lastMotionTime = ev.time;
+        motionStartTime = ev.time;
+        radarState = HIGH;
+        motionInProgress = true;
+        lastMotionUpdateTime = ev.time;
+        
+        updateLEDsBasedOnConditions();
+        
+        // ✅ Trigger security system sau khi camera xác nhận (chỉ lần đầu)
+        lastTriggerRejected = false;
+        motionConfirmPending = true;
+        requestMotionConfirm();
+    }
+    else if (ev.type == PIR_EVENT_START_COOLDOWN) 
+    {
+        radarState = HIGH;
+    }
+    // ✅ Motion END → TẮT BUZZER NGAY LẬP TỨC
+    else if (ev.type == PIR_EVENT_END && radarState == HIGH) 
+    {
+        Serial.println("\n[MOTION] Motion ended");
+        wsPublishEvent("{\"type\":\"pir\",\"motion\":false}");
+        radarState = LOW;
+        motionInProgress = false;
+        
+        updateLEDsBasedOnConditions();
+        
+        // ✅ GỌI HÀM TẮT BUZZER KHI MOTION END (bỏ qua nếu PIR bị camera bác bỏ
+        // hoặc camera chưa xác nhận: khi đó báo động chưa bắt đầu)
+        if (!lastTriggerRejected && !motionConfirmPending) 
+        {
+            postSecurityEvent(SECURITY_EVT_MOTION_ENDED);
+        }
+    }
+}
+
 void handleMotionLoop() 
 {
     if (!systemReady) return;
     
-    radarVal = digitalRead(PIR_PIN);
-    unsigned long currentTime = millis();
-    
-    // ✅ Motion START
-    if (radarVal == HIGH && radarState == LOW) 
+    if (motionConfirmPending) 
     {
-        if (currentTime - lastMotionTime > motionCooldown) 
+        MotionVerdict verdict = motionConfirmResult();
+        if (verdict == MOTION_VERDICT_CONFIRMED && !motionInProgress) 
         {
-            Serial.println("\n[MOTION] Motion started");
-            
-            lastMotionTime = currentTime;
-            motionStartTime = currentTime;
-            radarState = HIGH;
-            motionInProgress = true;
-            lastMotionUpdateTime = currentTime;
-            
-            updateLEDsBasedOnConditions();
-            
-            // ✅ Trigger security system (chỉ lần đầu)
-            onMotionDetected();
-            
+            // PIR đã hết trước khi camera kết luận: không mở báo động muộn
+            motionConfirmPending = false;
+            Serial.println("[MOTION] Confirmed after motion ended, ignored");
         } 
-        else 
+        else if (verdict == MOTION_VERDICT_CONFIRMED) 
+        {
+            motionConfirmPending = false;
+            Serial.printf("[MOTION] Confirmed by camera (%d blocks)\n", motionChangedBlocks());
+            postSecurityEvent(SECURITY_EVT_MOTION_CONFIRMED);
+        } 
+        else if (verdict == MOTION_VERDICT_REJECTED) 
         {
-            radarState = HIGH;
+            motionConfirmPending = false;
+            lastTriggerRejected = true;
+            Serial.println("[MOTION] PIR trigger rejected by camera");
         }
     }
+    
+    pir_edge_t edge;
+    while (pirEdgePop(&pirEdges, &edge)) 
+    {
+        handlePirEvent(pirFilterEdge(&pirFilter, &edge));
+    }
+    
+    // queue tràn thì đã mất sườn: đồng bộ lại theo mức hiện tại
+    if (pirEdges.overflows != pirOverflowsSeen) 
+    {
+        pirOverflowsSeen = pirEdges.overflows;
+        edge.time = millis();
+        edge.level = digitalRead(PIR_PIN);
+        handlePirEvent(pirFilterEdge(&pirFilter, &edge));
+    }
+    
+    unsigned long currentTime = millis();
+    handlePirEvent(pirFilterPoll(&pirFilter, currentTime));
+    radarVal = pirFilter.level;
+    
     // ✅ Motion CONTINUE (throttle update)
-    else if (radarVal == HIGH && radarState == HIGH) 
+    if (radarState == HIGH && pirFilter.level == HIGH) 
     {
         // ✅ Chỉ cập nhật mỗi 500ms
         if (currentTime - lastMotionUpdateTime >= motionUpdateInterval) 
         {
             lastMotionUpdateTime = currentTime;
-            
-            extern SecurityState currentSecurityState;
-            if (currentSecurityState != SECURITY_IDLE) 
-            {
-                updateMotionTimestamp();
-            }
+            postSecurityEvent(SECURITY_EVT_MOTION_SEEN);
         }
     }
-    // ✅ Motion END → TẮT BUZZER NGAY LẬP TỨC
-    else if (radarVal == LOW && radarState == HIGH) 
-    {
-        Serial.println("\n[MOTION] Motion ended");
-        radarState = LOW;
-        motionInProgress = false;
-        
-        updateLEDsBasedOnConditions();
-        
-        // ✅ GỌI HÀM TẮT BUZZER KHI MOTION END
-        onMotionEnded();
-    }
 }
\ No newline at end of file
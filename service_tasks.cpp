@@ -0,0 +1,46 @@
+#include "service_tasks.h"
+#include "sensors_handler.h"
+#include "security_system.h"
+#include "blynk_handler.h"
+
+static TaskHandle_t sensorTaskHandle = NULL;
+static TaskHandle_t netTaskHandle = NULL;
+
+// Chu kỳ cố định: PIR -> báo động bị chặn trên bởi SENSOR_TASK_PERIOD_MS,
+// không phụ thuộc Blynk.connect hay MQTT reconnect đang chặn NetTask
+static void sensorTask(void*) {
+    TickType_t lastWake = xTaskGetTickCount();
+    while (true) {
+        handleMotionLoop();
+        handleLDRLoop();
+        handleSecuritySystem();
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(SENSOR_TASK_PERIOD_MS));
+    }
+}
+
+static void netTask(void*) {
+    while (true) {
+        handleBlynkLoop();
+        handleMqttLoop();
+        vTaskDelay(pdMS_TO_TICKS(NET_TASK_PERIOD_MS));
+    }
+}
+
+bool startServiceTasks() {
+    if (sensorTaskHandle != NULL) return true;
+
+    if (xTaskCreatePinnedToCore(sensorTask, "SensorTask", 6144, NULL, SENSOR_TASK_PRIORITY,
+                                &sensorTaskHandle, APP_CPU) != pdPASS) {
+        Serial.println("[SERVICE] Failed to create SensorTask");
+        return false;
+    }
+
+    if (xTaskCreatePinnedToCore(netTask, "NetTask", 8192, NULL, NET_TASK_PRIORITY,
+                                &netTaskHandle, PRO_CPU) != pdPASS) {
+        Serial.println("[SERVICE] Failed to create NetTask");
+        return false;
+    }
+
+    Serial.println("[SERVICE] Sensor and network tasks started");
+    return true;
+}
\ No newline at end of file
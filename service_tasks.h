@@ -0,0 +1,13 @@
+#ifndef SERVICE_TASKS_H
+#define SERVICE_TASKS_H
+
+#include "config.h"
+
+// Tách loop() thành các task có ưu tiên và core cố định:
+//   SensorTask (APP_CPU, SENSOR_TASK_PRIORITY): PIR, LDR, máy trạng thái an ninh
+//   NetTask    (PRO_CPU, NET_TASK_PRIORITY):    Blynk, MQTT
+//   loopTask   (ưu tiên 1):                     web server, portal Wi-Fi, camera, audio
+// Các task trao đổi qua queue: postSecurityEvent, outbox MQTT, requestAudio.
+bool startServiceTasks();
+
+#endif
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include "stream_latency.h"
+#include <string.h>
+
+const uint16_t streamAgeBucketMs[STREAM_AGE_BUCKETS] = {
+    10, 20, 30, 40, 50, 65, 80, 100, 130, 160, 200, 300, 500, 1000, 2000, 0xFFFF
+};
+
+void streamLatencyInit(stream_latency_t* l, uint32_t stallMs) {
+    memset(l->ageHist, 0, sizeof(l->ageHist));
+    l->avgFrameGap = 0;
+    l->stalls = 0;
+    l->stallMs = stallMs;
+}
+
+void streamLatencyRecordAge(stream_latency_t* l, uint32_t ageMs) {
+    int b = 0;
+    while (b < STREAM_AGE_BUCKETS - 1 && ageMs > streamAgeBucketMs[b]) b++;
+    l->ageHist[b]++;
+}
+
+void streamLatencyRecordGap(stream_latency_t* l, uint32_t gapMs) {
+    l->avgFrameGap = l->avgFrameGap ? (l->avgFrameGap * 7 + gapMs) / 8 : gapMs;
+    if (gapMs > l->stallMs) l->stalls++;
+}
+
+uint16_t streamLatencyPercentile(const stream_latency_t* l, uint32_t pct) {
+    uint32_t total = 0;
+    for (int b = 0; b < STREAM_AGE_BUCKETS; b++) total += l->ageHist[b];
+    if (total == 0) return 0;
+
+    uint32_t rank = (uint32_t)(((uint64_t)total * pct + 99) / 100);
+    uint32_t seen = 0;
+    for (int b = 0; b < STREAM_AGE_BUCKETS; b++) {
+        seen += l->ageHist[b];
+        if (seen >= rank) return streamAgeBucketMs[b];
+    }
+    return streamAgeBucketMs[STREAM_AGE_BUCKETS - 1];
+}
\ No newline at end of file
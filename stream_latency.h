@@ -0,0 +1,29 @@
+#ifndef STREAM_LATENCY_H
+#define STREAM_LATENCY_H
+
+#include <stdint.h>
+
+// Số liệu độ trễ của một client stream: histogram tuổi frame khi gửi xong,
+// EWMA khoảng cách giữa hai frame và số lần đứng hình. Không phụ thuộc
+// Arduino để kiểm thử trên host.
+
+// Biên trên (ms) các bucket tuổi frame: từ lúc publish tới byte cuối được ghi
+#define STREAM_AGE_BUCKETS 16
+
+typedef struct {
+    uint32_t ageHist[STREAM_AGE_BUCKETS];
+    uint32_t avgFrameGap;          // EWMA ms giữa hai frame gửi xong, 0 = chưa có
+    uint32_t stalls;
+    uint32_t stallMs;              // khoảng cách lớn hơn mức này tính là đứng hình
+} stream_latency_t;
+
+extern const uint16_t streamAgeBucketMs[STREAM_AGE_BUCKETS];
+
+void streamLatencyInit(stream_latency_t* l, uint32_t stallMs);
+void streamLatencyRecordAge(stream_latency_t* l, uint32_t ageMs);
+void streamLatencyRecordGap(stream_latency_t* l, uint32_t gapMs);
+
+// Percentile (1..100) theo biên trên của bucket chứa nó, 0 khi chưa có mẫu
+uint16_t streamLatencyPercentile(const stream_latency_t* l, uint32_t pct);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,227 @@
+#include "substream.h"
+#include "camera_handler.h"
+#include "esp_jpg_decode.h"
+#include "img_converters.h"
+
+// Camera chỉ xuất một định dạng qua USB_STREAM nên substream được tạo lại
+// từ frame chính: tjpgd decode ở tỉ lệ 1/4 (chỉ IDCT 2x2 mỗi block) ra
+// RGB888 rồi encode JPEG thẳng vào slot của subFramePool. Task chạy trên
+// PRO_CPU và chỉ làm việc khi có client /stream/sub.
+
+FramePool subFramePool;
+
+static TaskHandle_t substreamHandle = NULL;
+static uint8_t* rgbBuf = nullptr;
+static size_t rgbBufSize = 0;
+
+static int subConsumers = 0;
+static portMUX_TYPE subMux = portMUX_INITIALIZER_UNLOCKED;
+static substream_stats_t stats = {};
+
+// max theo hai cửa sổ liền nhau, chỉ task substream ghi: đọc stats không làm
+// mất giá trị của reader khác ([SUB] log và /stream/sub/stats)
+static uint32_t windowMaxUs = 0;
+static uint32_t prevWindowMaxUs = 0;
+static unsigned long windowStart = 0;
+
+typedef struct {
+    const uint8_t* data;
+    size_t len;
+    const jpeg_info_t* info;
+    uint16_t w;
+    uint16_t h;
+} decode_ctx_t;
+
+typedef struct {
+    frame_slot_t* slot;
+    size_t len;
+} encode_ctx_t;
+
+static size_t jpegReader(void* arg, size_t index, uint8_t* buf, size_t len) {
+    decode_ctx_t* ctx = (decode_ctx_t*)arg;
+    return jpegReadPatched(ctx->data, ctx->len, ctx->info, index, buf, len);
+}
+
+// tjpgd trả RGB, encoder của esp32-camera đọc RGB888 theo thứ tự BGR
+static bool rgbWriter(void* arg, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t* data) {
+    decode_ctx_t* ctx = (decode_ctx_t*)arg;
+
+    if (!data) {
+        if (x == 0 && y == 0) {
+            if ((size_t)w * h * 3 > rgbBufSize) return false;
+            ctx->w = w;
+            ctx->h = h;
+        }
+        return true;
+    }
+
+    for (uint16_t row = 0; row < h; row++) {
+        uint8_t* dst = rgbBuf + ((y + row) * ctx->w + x) * 3;
+        for (uint16_t col = 0; col < w; col++) {
+            dst[0] = data[2];
+            dst[1] = data[1];
+            dst[2] = data[0];
+            dst += 3;
+            data += 3;
+        }
+    }
+    return true;
+}
+
+static size_t slotWriter(void* arg, size_t index, const void* data, size_t len) {
+    encode_ctx_t* ctx = (encode_ctx_t*)arg;
+    if (index + len > ctx->slot->capacity) return 0;
+    memcpy(ctx->slot->data + index, data, len);
+    if (index + len > ctx->len) ctx->len = index + len;
+    return len;
+}
+
+static bool buildSubFrame(const FrameRef& frame, frame_slot_t* out) {
+    // frame UVC không có DHT: đọc qua jpegReadPatched như motion detector
+    decode_ctx_t dec = { frame.data, frame.len, frame.info, 0, 0 };
+
+    uint32_t start = micros();
+    size_t len = jpegPatchedSize(frame.info, frame.len);
+    if (esp_jpg_decode(len, JPG_SCALE_4X, jpegReader, rgbWriter, &dec) != ESP_OK) return false;
+    uint32_t decoded = micros();
+
+    encode_ctx_t enc = { out, 0 };
+    bool ok = fmt2jpg_cb(rgbBuf, (size_t)dec.w * dec.h * 3, dec.w, dec.h, PIXFORMAT_RGB888,
+                         SUB_STREAM_QUALITY, slotWriter, &enc);
+    uint32_t encoded = micros();
+    if (!ok || !jpegScan(out->data, enc.len, &out->info)) return false;
+
+    out->len = enc.len;
+
+    uint32_t decodeUs = decoded - start;
+    uint32_t encodeUs = encoded - decoded;
+    portENTER_CRITICAL(&subMux);
+    stats.frames++;
+    stats.decodeUs = stats.decodeUs ? (stats.decodeUs * 7 + decodeUs) / 8 : decodeUs;
+    stats.encodeUs = stats.encodeUs ? (stats.encodeUs * 7 + encodeUs) / 8 : encodeUs;
+    stats.avgBytes = stats.avgBytes ? (stats.avgBytes * 7 + enc.len) / 8 : enc.len;
+    unsigned long now = millis();
+    if (now - windowStart >= SUB_STATS_WINDOW_MS) {
+        prevWindowMaxUs = now - windowStart < 2 * SUB_STATS_WINDOW_MS ? windowMaxUs : 0;
+        windowMaxUs = 0;
+        windowStart = now;
+    }
+    if (decodeUs + encodeUs > windowMaxUs) windowMaxUs = decodeUs + encodeUs;
+    stats.width = dec.w;
+    stats.height = dec.h;
+    portEXIT_CRITICAL(&subMux);
+    return true;
+}
+
+static void substreamTask(void* pvParameters) {
+    uint32_t lastSeq = 0;
+    unsigned long lastFrame = 0;
+    unsigned long lastStatsPrint = 0;
+
+    while (true) {
+        portENTER_CRITICAL(&subMux);
+        bool active = subConsumers > 0;
+        portEXIT_CRITICAL(&subMux);
+
+        if (!active) {
+            vTaskDelay(pdMS_TO_TICKS(200));
+            continue;
+        }
+
+        if (!framePool.waitForFrame(lastSeq, pdMS_TO_TICKS(200))) continue;
+
+        // giới hạn FPS của substream để decode + encode không chiếm hết PRO_CPU
+        unsigned long elapsed = millis() - lastFrame;
+        if (elapsed < 1000 / SUB_STREAM_MAX_FPS) {
+            vTaskDelay(pdMS_TO_TICKS(1000 / SUB_STREAM_MAX_FPS - elapsed));
+        }
+
+        FrameRef frame;
+        if (!framePool.acquireLatest(frame, lastSeq)) continue;
+        lastSeq = frame.seq;
+        lastFrame = millis();
+
+        frame_slot_t* out = subFramePool.acquireWrite();
+        if (!out) {
+            framePool.release(frame);
+            portENTER_CRITICAL(&subMux);
+            stats.dropped++;
+            portEXIT_CRITICAL(&subMux);
+            continue;
+        }
+
+        bool ok = buildSubFrame(frame, out);
+        unsigned long captured = frame.timestamp;
+        framePool.release(frame);
+
+        if (ok) {
+            // tuổi frame ở /stream/sub tính từ lúc camera chụp, gồm cả decode + encode
+            subFramePool.publish(out, out->len, captured);
+        } else {
+            subFramePool.abort(out);
+            portENTER_CRITICAL(&subMux);
+            stats.dropped++;
+            portEXIT_CRITICAL(&subMux);
+        }
+
+        if (millis() - lastStatsPrint >= CAMERA_STATS_INTERVAL) {
+            lastStatsPrint = millis();
+            substream_stats_t s;
+            substreamStats(&s);
+            Serial.printf("[SUB] %ux%u frames=%u dropped=%u decode=%uus encode=%uus max=%uus bytes=%u\n",
+                          s.width, s.height, s.frames, s.dropped, s.decodeUs, s.encodeUs, s.maxUs, s.avgBytes);
+        }
+    }
+}
+
+// Buffer RGB theo profile lớn nhất sau khi scale 1/4
+bool initializeSubstream() {
+    size_t maxPixels = 0;
+    for (int i = 0; i < cameraProfileCount; i++) {
+        size_t pixels = (size_t)((cameraProfiles[i].width + 3) / 4) * ((cameraProfiles[i].height + 3) / 4);
+        if (pixels > maxPixels) maxPixels = pixels;
+    }
+
+    rgbBufSize = maxPixels * 3;
+    rgbBuf = (uint8_t*)heap_caps_malloc(rgbBufSize, MALLOC_CAP_SPIRAM);
+    if (!rgbBuf) return false;
+
+    if (!subFramePool.begin(SUB_POOL_SLOTS, SUB_BUF_SIZE)) {
+        heap_caps_free(rgbBuf);
+        rgbBuf = nullptr;
+        return false;
+    }
+    return true;
+}
+
+// Chỉ gọi từ loop task: giữ camera và tạo task ở lần dùng đầu tiên
+void substreamAcquire() {
+    cameraAcquire();
+
+    portENTER_CRITICAL(&subMux);
+    subConsumers++;
+    portEXIT_CRITICAL(&subMux);
+
+    if (substreamHandle == NULL && rgbBuf != nullptr) {
+        xTaskCreatePinnedToCore(substreamTask, "Substream", 8192, NULL, 1, &substreamHandle, PRO_CPU);
+    }
+}
+
+void substreamRelease() {
+    portENTER_CRITICAL(&subMux);
+    if (subConsumers > 0) subConsumers--;
+    portEXIT_CRITICAL(&subMux);
+
+    cameraRelease();
+}
+
+void substreamStats(substream_stats_t* out) {
+    portENTER_CRITICAL(&subMux);
+    *out = stats;
+    // cửa sổ chưa được task cuộn (substream rảnh): bỏ phần đã quá hạn
+    unsigned long age = millis() - windowStart;
+    uint32_t cur = age < 2 * SUB_STATS_WINDOW_MS ? windowMaxUs : 0;
+    uint32_t prev = age < SUB_STATS_WINDOW_MS ? prevWindowMaxUs : 0;
+    out->maxUs = max(cur, prev);
+    portEXIT_CRITICAL(&subMux);
+}
\ No newline at end of file
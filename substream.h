@@ -0,0 +1,26 @@
+#ifndef SUBSTREAM_H
+#define SUBSTREAM_H
+
+#include "config.h"
+#include "frame_pool.h"
+
+// Substream JPEG nhỏ (1/4 mỗi chiều) cho /stream/sub, tạo từ frame chính
+extern FramePool subFramePool;
+
+typedef struct {
+    uint32_t frames;
+    uint32_t dropped;
+    uint32_t decodeUs;      // EWMA thời gian decode 1/4
+    uint32_t encodeUs;      // EWMA thời gian encode lại
+    uint32_t maxUs;         // decode + encode lớn nhất trong 1-2 cửa sổ SUB_STATS_WINDOW_MS gần nhất
+    uint32_t avgBytes;
+    uint16_t width;
+    uint16_t height;
+} substream_stats_t;
+
+bool initializeSubstream();
+void substreamAcquire();
+void substreamRelease();
+void substreamStats(substream_stats_t* out);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+// Assert tối thiểu cho test host: in vị trí lỗi, test trả về khác 0 nếu có lỗi
+
+#include <stdio.h>
+
+static int testFailures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+        testFailures++; \
+    } \
+} while (0)
+
+#define CHECK_EQ(a, b) do { \
+    long long _a = (long long)(a), _b = (long long)(b); \
+    if (_a != _b) { \
+        fprintf(stderr, "%s:%d: CHECK_EQ failed: %s == %s (%lld vs %lld)\n", \
+                __FILE__, __LINE__, #a, #b, _a, _b); \
+        testFailures++; \
+    } \
+} while (0)
+
+#define TEST_RESULT() (testFailures == 0 ? 0 : 1)
+
+#endif
\ No newline at end of file
@@ -0,0 +1,91 @@
+// blockDiffSum (SWAR) so với vòng lặp scalar trên dữ liệu ngẫu nhiên và
+// trường hợp biên, kèm benchmark một lưới luma cỡ VGA/8 như motion_detector.
+
+#include "frame_diff.h"
+#include "test_check.h"
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+static uint32_t scalarDiffSum(const uint8_t* a, const uint8_t* b, int stride, int size) {
+    uint32_t sum = 0;
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            int d = (int)a[y * stride + x] - (int)b[y * stride + x];
+            sum += d < 0 ? -d : d;
+        }
+    }
+    return sum;
+}
+
+static void testRandomBlocks(std::mt19937& rng) {
+    const int strides[] = {16, 20, 40, 80, 100, 160};
+    for (int size = 4; size <= 16; size += 4) {
+        for (int stride : strides) {
+            if (stride < size) continue;
+            std::vector<uint8_t> a(stride * size + 3), b(stride * size + 3);
+            for (int iter = 0; iter < 500; iter++) {
+                for (size_t i = 0; i < a.size(); i++) {
+                    a[i] = rng() & 0xFF;
+                    b[i] = rng() & 0xFF;
+                }
+                // lệch 0..3 byte để kernel gặp địa chỉ không căn lề
+                int skew = iter & 3;
+                CHECK_EQ(blockDiffSum(a.data() + skew, b.data() + skew, stride, size),
+                         scalarDiffSum(a.data() + skew, b.data() + skew, stride, size));
+            }
+        }
+    }
+}
+
+// |a - b| = 255 ở mọi pixel: làn 16 bit đầy nhất ở size 16
+static void testExtremes() {
+    for (int size = 4; size <= 16; size += 4) {
+        std::vector<uint8_t> zero(size * size, 0), full(size * size, 255);
+        uint32_t want = 255u * size * size;
+        CHECK_EQ(blockDiffSum(zero.data(), full.data(), size, size), want);
+        CHECK_EQ(blockDiffSum(full.data(), zero.data(), size, size), want);
+        CHECK_EQ(blockDiffSum(full.data(), full.data(), size, size), 0);
+    }
+}
+
+template <typename Kernel>
+static double benchGridUs(Kernel kernel, const std::vector<uint8_t>& a, const std::vector<uint8_t>& b,
+                          int w, int h, int block, int iterations, uint32_t* sink) {
+    auto start = std::chrono::steady_clock::now();
+    for (int it = 0; it < iterations; it++) {
+        for (int by = 0; by + block <= h; by += block) {
+            for (int bx = 0; bx + block <= w; bx += block) {
+                int off = by * w + bx;
+                *sink += kernel(a.data() + off, b.data() + off, w, block);
+            }
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+}
+
+static void benchmark(std::mt19937& rng) {
+    const int w = 80, h = 60, block = 8;   // lưới luma 1/8 của 640x480, MOTION_BLOCK
+    std::vector<uint8_t> a(w * h), b(w * h);
+    for (int i = 0; i < w * h; i++) {
+        a[i] = rng() & 0xFF;
+        b[i] = a[i] + (rng() % 9) - 4;
+    }
+
+    uint32_t sinkSwar = 0, sinkScalar = 0;
+    double swar = benchGridUs(blockDiffSum, a, b, w, h, block, 20000, &sinkSwar);
+    double scalar = benchGridUs(scalarDiffSum, a, b, w, h, block, 20000, &sinkScalar);
+    CHECK_EQ(sinkSwar, sinkScalar);
+    printf("[bench] %dx%d grid, %dx%d blocks: swar %.2f us, scalar %.2f us\n",
+           w, h, block, block, swar, scalar);
+}
+
+int main() {
+    std::mt19937 rng(13);
+    testRandomBlocks(rng);
+    testExtremes();
+    benchmark(rng);
+    return TEST_RESULT();
+}
\ No newline at end of file
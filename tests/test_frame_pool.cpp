@@ -0,0 +1,204 @@
+// FramePool: một producer và nhiều consumer chạy đua; mỗi frame mang seq trong
+// payload nên consumer phát hiện được slot bị ghi đè khi đang giữ ref.
+
+#include "frame_pool.h"
+#include "test_check.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#define TEST_SLOTS 4
+#define TEST_SLOT_SIZE 4096
+#define TEST_FRAMES 20000
+#define TEST_READERS 3
+
+static void fillFrame(uint8_t* data, size_t len, uint32_t tag) {
+    for (size_t i = 0; i + 4 <= len; i += 4) memcpy(data + i, &tag, 4);
+}
+
+static bool frameIntact(const uint8_t* data, size_t len, uint32_t tag) {
+    for (size_t i = 0; i + 4 <= len; i += 4) {
+        uint32_t v;
+        memcpy(&v, data + i, 4);
+        if (v != tag) return false;
+    }
+    return true;
+}
+
+// Mọi slot rảnh khi pool đã invalidate và không reader nào giữ ref
+static size_t freeSlots(FramePool& pool) {
+    frame_slot_t* taken[TEST_SLOTS];
+    size_t n = 0;
+    while (n < TEST_SLOTS && (taken[n] = pool.acquireWrite()) != nullptr) n++;
+    for (size_t i = 0; i < n; i++) pool.abort(taken[i]);
+    return n;
+}
+
+static void testRace() {
+    FramePool pool;
+    CHECK(pool.begin(TEST_SLOTS, TEST_SLOT_SIZE));
+
+    std::atomic<bool> done(false);
+    std::atomic<uint32_t> corrupt(0);
+    std::atomic<uint32_t> outOfOrder(0);
+    std::vector<uint32_t> seen(TEST_READERS, 0);
+    uint32_t busy = 0;
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < TEST_READERS; r++) {
+        readers.emplace_back([&, r] {
+            uint32_t lastSeq = 0;
+            while (!done.load()) {
+                if (!pool.waitForFrame(lastSeq, pdMS_TO_TICKS(5))) continue;
+                FrameRef ref;
+                if (!pool.acquireLatest(ref, lastSeq)) continue;
+                if (ref.seq <= lastSeq) outOfOrder++;
+                // giữ ref một lúc để producer phải chạy vòng qua các slot khác
+                std::this_thread::yield();
+                uint32_t tag;
+                memcpy(&tag, ref.data, 4);
+                if (!frameIntact(ref.data, ref.len, tag)) corrupt++;
+                lastSeq = ref.seq;
+                seen[r]++;
+                pool.release(ref);
+            }
+        });
+    }
+
+    for (uint32_t i = 0; i < TEST_FRAMES; i++) {
+        frame_slot_t* slot = pool.acquireWrite();
+        if (!slot) {
+            busy++;
+            std::this_thread::yield();
+            continue;
+        }
+        size_t len = 64 + (i % (TEST_SLOT_SIZE / 4 - 16)) * 4;
+        fillFrame(slot->data, len, i);
+        pool.publish(slot, len);
+    }
+    done = true;
+    for (auto& t : readers) t.join();
+
+    CHECK_EQ(corrupt.load(), 0);
+    CHECK_EQ(outOfOrder.load(), 0);
+    for (int r = 0; r < TEST_READERS; r++) CHECK(seen[r] > 0);
+    // N-1 slot luôn sẵn cho producer khi reader chỉ giữ tối đa một ref mỗi người
+    CHECK(busy < TEST_FRAMES / 2);
+
+    // chỉ pool còn giữ latest
+    CHECK_EQ(freeSlots(pool), TEST_SLOTS - 1);
+    pool.invalidate();
+    CHECK_EQ(freeSlots(pool), TEST_SLOTS);
+    pool.end();
+}
+
+// Reader giữ ref qua invalidate() (camera tắt): slot chỉ rảnh khi reader release
+static void testInvalidateWithLiveReader() {
+    FramePool pool;
+    CHECK(pool.begin(TEST_SLOTS, TEST_SLOT_SIZE));
+
+    frame_slot_t* slot = pool.acquireWrite();
+    fillFrame(slot->data, 256, 7);
+    pool.publish(slot, 256);
+
+    FrameRef ref;
+    CHECK(pool.acquireLatest(ref));
+    uint32_t seq = ref.seq;
+
+    pool.invalidate();
+    CHECK_EQ(pool.latestSeq(), 0);
+    CHECK_EQ(freeSlots(pool), TEST_SLOTS - 1);
+    CHECK(frameIntact(ref.data, ref.len, 7));
+
+    pool.release(ref);
+    CHECK_EQ(freeSlots(pool), TEST_SLOTS);
+
+    // seq tiếp tục tăng sau khi camera bật lại
+    slot = pool.acquireWrite();
+    pool.publish(slot, 128);
+    CHECK(pool.latestSeq() > seq);
+    pool.end();
+}
+
+// Bit READY còn set từ frame reader đã có: waitForFrame không được trả về
+// sớm mà chờ hết timeout, rồi vẫn thức dậy khi có frame mới thật
+static void testStaleReadyBit() {
+    FramePool pool;
+    CHECK(pool.begin(TEST_SLOTS, TEST_SLOT_SIZE));
+
+    frame_slot_t* slot = pool.acquireWrite();
+    pool.publish(slot, 64);
+    uint32_t seq = pool.latestSeq();
+
+    auto start = std::chrono::steady_clock::now();
+    CHECK(!pool.waitForFrame(seq, pdMS_TO_TICKS(50)));
+    auto waited = std::chrono::steady_clock::now() - start;
+    CHECK(waited >= std::chrono::milliseconds(45));
+
+    std::thread producer([&pool] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        frame_slot_t* s = pool.acquireWrite();
+        pool.publish(s, 64);
+    });
+    start = std::chrono::steady_clock::now();
+    CHECK(pool.waitForFrame(seq, pdMS_TO_TICKS(2000)));
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(1000));
+    producer.join();
+    pool.end();
+}
+
+// Mỗi reader giữ một frame khác nhau: với slots - 2 reader producer luôn còn slot
+// ghi; khi số reader bằng số slot, acquireWrite trả nullptr (bỏ frame) thay vì
+// ghi đè frame đang bị giữ, và chạy lại ngay khi một reader release
+static void testReadersHoldEverySlot() {
+    FramePool pool;
+    CHECK(pool.begin(TEST_SLOTS, TEST_SLOT_SIZE));
+
+    FrameRef refs[TEST_SLOTS];
+    uint32_t tag = 0;
+    for (int r = 0; r < TEST_SLOTS - 2; r++) {
+        frame_slot_t* slot = pool.acquireWrite();
+        CHECK(slot != nullptr);
+        fillFrame(slot->data, 256, ++tag);
+        pool.publish(slot, 256);
+        CHECK(pool.acquireLatest(refs[r]));
+    }
+    for (int i = 0; i < 100; i++) {
+        frame_slot_t* slot = pool.acquireWrite();
+        CHECK(slot != nullptr);
+        if (!slot) break;
+        fillFrame(slot->data, 256, 1000 + i);
+        pool.publish(slot, 256);
+    }
+    for (int r = 0; r < TEST_SLOTS - 2; r++) CHECK(frameIntact(refs[r].data, refs[r].len, r + 1));
+
+    // hai reader nữa lấy latest rồi slot còn lại: mọi slot đều có ref
+    CHECK(pool.acquireLatest(refs[TEST_SLOTS - 2]));
+    frame_slot_t* slot = pool.acquireWrite();
+    CHECK(slot != nullptr);
+    fillFrame(slot->data, 256, ++tag);
+    pool.publish(slot, 256);
+    CHECK(pool.acquireLatest(refs[TEST_SLOTS - 1]));
+    CHECK(pool.acquireWrite() == nullptr);
+    CHECK(frameIntact(refs[TEST_SLOTS - 1].data, refs[TEST_SLOTS - 1].len, tag));
+    for (int r = 0; r < TEST_SLOTS - 2; r++) CHECK(frameIntact(refs[r].data, refs[r].len, r + 1));
+
+    pool.release(refs[0]);
+    slot = pool.acquireWrite();
+    CHECK(slot != nullptr);
+    pool.abort(slot);
+
+    for (int r = 1; r < TEST_SLOTS; r++) pool.release(refs[r]);
+    CHECK_EQ(freeSlots(pool), TEST_SLOTS - 1);
+    pool.end();
+}
+
+int main() {
+    testRace();
+    testInvalidateWithLiveReader();
+    testStaleReadyBit();
+    testReadersHoldEverySlot();
+    return TEST_RESULT();
+}
\ No newline at end of file
@@ -0,0 +1,145 @@
+// Frame không có DHT (MJPEG của UVC): decoder kiểu tjpgd từ chối, còn đọc qua
+// jpegReadPatched (bảng Annex K chèn trước SOS) phải ra đúng từng pixel như
+// frame gốc có DHT do libjpeg encode bằng bảng chuẩn.
+
+#include "jpeg_scan.h"
+#include "host_jpeg.h"
+#include "test_check.h"
+
+#include <esp_jpg_decode.h>
+#include <string.h>
+#include <vector>
+
+#define TEST_W 96
+#define TEST_H 64
+
+typedef struct {
+    const uint8_t* data;
+    size_t len;
+    const jpeg_info_t* info;   // nullptr: đọc nguyên frame
+    std::vector<uint8_t> rgb;
+    uint16_t w;
+    uint16_t h;
+} decode_ctx_t;
+
+static size_t reader(void* arg, size_t index, uint8_t* buf, size_t len) {
+    decode_ctx_t* ctx = (decode_ctx_t*)arg;
+    if (ctx->info) return jpegReadPatched(ctx->data, ctx->len, ctx->info, index, buf, len);
+    if (index >= ctx->len) return 0;
+    if (index + len > ctx->len) len = ctx->len - index;
+    if (buf) memcpy(buf, ctx->data + index, len);
+    return len;
+}
+
+static bool writer(void* arg, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t* data) {
+    decode_ctx_t* ctx = (decode_ctx_t*)arg;
+    if (!data) {
+        if (x == 0 && y == 0) {
+            ctx->w = w;
+            ctx->h = h;
+            ctx->rgb.assign((size_t)w * h * 3, 0);
+        }
+        return true;
+    }
+    for (uint16_t row = 0; row < h; row++) {
+        memcpy(&ctx->rgb[((size_t)(y + row) * ctx->w + x) * 3], data, (size_t)w * 3);
+        data += (size_t)w * 3;
+    }
+    return true;
+}
+
+static bool decode(const std::vector<uint8_t>& jpeg, const jpeg_info_t* info, jpg_scale_t scale, decode_ctx_t* ctx) {
+    ctx->data = jpeg.data();
+    ctx->len = jpeg.size();
+    ctx->info = info;
+    size_t len = info ? jpegPatchedSize(info, jpeg.size()) : jpeg.size();
+    return esp_jpg_decode(len, scale, reader, writer, ctx) == ESP_OK;
+}
+
+// Bỏ mọi segment DHT trước SOS, như frame MJPEG camera UVC gửi ra
+static std::vector<uint8_t> stripDht(const std::vector<uint8_t>& jpeg) {
+    std::vector<uint8_t> out(jpeg.begin(), jpeg.begin() + 2);
+    size_t pos = 2;
+    while (pos + 4 <= jpeg.size() && jpeg[pos] == 0xFF) {
+        uint8_t m = jpeg[pos + 1];
+        size_t segEnd = pos + 2 + ((jpeg[pos + 2] << 8) | jpeg[pos + 3]);
+        if (m == 0xDA) break;
+        if (m != 0xC4) out.insert(out.end(), jpeg.begin() + pos, jpeg.begin() + segEnd);
+        pos = segEnd;
+    }
+    out.insert(out.end(), jpeg.begin() + pos, jpeg.end());
+    return out;
+}
+
+static std::vector<uint8_t> makeImage() {
+    std::vector<uint8_t> rgb(TEST_W * TEST_H * 3);
+    for (int y = 0; y < TEST_H; y++) {
+        for (int x = 0; x < TEST_W; x++) {
+            uint8_t* px = &rgb[(y * TEST_W + x) * 3];
+            px[0] = (uint8_t)(x * 255 / TEST_W);
+            px[1] = (uint8_t)(y * 255 / TEST_H);
+            px[2] = (uint8_t)(((x / 8 + y / 8) & 1) ? 220 : 30);
+        }
+    }
+    return rgb;
+}
+
+static void testDhtLessFrame() {
+    std::vector<uint8_t> image = makeImage();
+    std::vector<uint8_t> jpeg;
+    CHECK(hostJpegEncode(image.data(), TEST_W, TEST_H, 3, 75, jpeg));
+
+    jpeg_info_t full;
+    CHECK(jpegScan(jpeg.data(), jpeg.size(), &full));
+    CHECK_EQ(full.huffTables, 4);
+    CHECK_EQ(jpegPatchedSize(&full, jpeg.size()), jpeg.size());
+
+    std::vector<uint8_t> bare = stripDht(jpeg);
+    jpeg_info_t info;
+    CHECK(jpegScan(bare.data(), bare.size(), &info));
+    CHECK_EQ(info.huffTables, 0);
+    CHECK_EQ(info.width, TEST_W);
+    CHECK_EQ(info.height, TEST_H);
+    CHECK_EQ(bare[info.sosOffset], 0xFF);
+    CHECK_EQ(bare[info.sosOffset + 1], 0xDA);
+
+    // tjpgd không có bảng mặc định
+    decode_ctx_t plain = {};
+    CHECK(!decode(bare, nullptr, JPG_SCALE_NONE, &plain));
+
+    // bản vá đọc lại được như một JPEG đầy đủ với 4 bảng
+    size_t patchedLen = jpegPatchedSize(&info, bare.size());
+    std::vector<uint8_t> patched(patchedLen);
+    CHECK_EQ(jpegReadPatched(bare.data(), bare.size(), &info, 0, patched.data(), patchedLen), patchedLen);
+    jpeg_info_t reparsed;
+    CHECK(jpegScan(patched.data(), patched.size(), &reparsed));
+    CHECK_EQ(reparsed.huffTables, 4);
+
+    // đọc từng đoạn nhỏ lệch biên DHT cho cùng kết quả
+    std::vector<uint8_t> pieces(patchedLen + 7, 0xEE);
+    size_t at = 0;
+    while (at < patchedLen) {
+        size_t n = jpegReadPatched(bare.data(), bare.size(), &info, at, pieces.data() + at, 13);
+        CHECK(n > 0);
+        if (n == 0) break;
+        at += n;
+    }
+    CHECK(memcmp(pieces.data(), patched.data(), patchedLen) == 0);
+    CHECK_EQ(jpegReadPatched(bare.data(), bare.size(), &info, patchedLen, pieces.data(), 4), 0);
+    CHECK_EQ(jpegReadPatched(bare.data(), bare.size(), &info, 10, nullptr, 500), 500);
+
+    jpg_scale_t scales[] = { JPG_SCALE_NONE, JPG_SCALE_4X, JPG_SCALE_8X };
+    for (jpg_scale_t scale : scales) {
+        decode_ctx_t ref = {}, dec = {};
+        CHECK(decode(jpeg, nullptr, scale, &ref));
+        CHECK(decode(bare, &info, scale, &dec));
+        CHECK_EQ(dec.w, ref.w);
+        CHECK_EQ(dec.h, ref.h);
+        CHECK(dec.rgb == ref.rgb);
+    }
+}
+
+int main() {
+    testDhtLessFrame();
+    return TEST_RESULT();
+}
\ No newline at end of file
@@ -0,0 +1,261 @@
+// jpegScan: frame baseline tổng hợp, cắt cụt ở mọi độ dài, hai frame dính nhau,
+// đột biến byte ngẫu nhiên và benchmark. Có thể truyền thư mục ảnh .jpg chụp từ
+// camera làm tham số để chạy thêm trên corpus thật.
+
+#include "jpeg_scan.h"
+#include "test_check.h"
+
+#include <chrono>
+#include <dirent.h>
+#include <random>
+#include <string>
+#include <vector>
+
+// bảng lượng tử luma chuẩn (Annex K), thứ tự zigzag không ảnh hưởng tổng
+static const uint8_t ijgLuma[64] = {
+    16, 11, 10, 16, 24, 40, 51, 61, 12, 12, 14, 19, 26, 58, 60, 55,
+    14, 13, 16, 24, 40, 57, 69, 56, 14, 17, 22, 29, 51, 87, 80, 62,
+    18, 22, 37, 56, 68, 109, 103, 77, 24, 35, 55, 64, 81, 104, 113, 92,
+    49, 64, 78, 87, 103, 121, 120, 101, 72, 92, 95, 98, 112, 100, 103, 99,
+};
+
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    uint8_t quality;
+    uint8_t sampling;
+    uint16_t restartInterval;
+    size_t entropyBytes;
+} frame_spec_t;
+
+static void put16(std::vector<uint8_t>& out, uint16_t v) {
+    out.push_back(v >> 8);
+    out.push_back(v & 0xFF);
+}
+
+static void putMarker(std::vector<uint8_t>& out, uint8_t m, uint16_t bodyLen) {
+    out.push_back(0xFF);
+    out.push_back(m);
+    put16(out, bodyLen + 2);
+}
+
+// Frame MJPEG kiểu UVC: DQT, SOF0, DHT, (DRI), SOS, entropy có byte stuffing + RST, EOI
+static std::vector<uint8_t> makeFrame(const frame_spec_t& spec, std::mt19937& rng, size_t* scanOffset) {
+    std::vector<uint8_t> out = {0xFF, 0xD8};
+
+    uint32_t scale = spec.quality < 50 ? 5000 / spec.quality : 200 - spec.quality * 2;
+    putMarker(out, 0xDB, 2 * 65);
+    for (int id = 0; id < 2; id++) {
+        out.push_back(id);
+        for (int k = 0; k < 64; k++) {
+            uint32_t v = (ijgLuma[k] * scale + 50) / 100;
+            out.push_back(v < 1 ? 1 : (v > 255 ? 255 : v));
+        }
+    }
+
+    putMarker(out, 0xC0, 15);
+    out.push_back(8);
+    put16(out, spec.height);
+    put16(out, spec.width);
+    out.push_back(3);
+    const uint8_t comps[9] = {1, spec.sampling, 0, 2, 0x11, 1, 3, 0x11, 1};
+    out.insert(out.end(), comps, comps + 9);
+
+    // DHT không được jpegScan kiểm nội dung, chỉ cần độ dài đúng
+    putMarker(out, 0xC4, 17 + 12);
+    out.push_back(0x00);
+    for (int i = 0; i < 16; i++) out.push_back(i == 0 ? 12 : 0);
+    for (int i = 0; i < 12; i++) out.push_back(i);
+
+    if (spec.restartInterval) {
+        putMarker(out, 0xDD, 2);
+        put16(out, spec.restartInterval);
+    }
+
+    putMarker(out, 0xDA, 10);
+    const uint8_t sos[10] = {3, 1, 0x00, 2, 0x11, 3, 0x11, 0, 63, 0};
+    out.insert(out.end(), sos, sos + 10);
+    *scanOffset = out.size();
+
+    int rst = 0;
+    for (size_t i = 0; i < spec.entropyBytes; i++) {
+        uint8_t b = rng() & 0xFF;
+        out.push_back(b);
+        if (b == 0xFF) out.push_back(0x00);
+        if (spec.restartInterval && i % 997 == 996) {
+            out.push_back(0xFF);
+            out.push_back(0xD0 + (rst++ & 7));
+        }
+    }
+
+    out.push_back(0xFF);
+    out.push_back(0xD9);
+    return out;
+}
+
+static void checkInvariants(const uint8_t* data, size_t len, const jpeg_info_t& info) {
+    CHECK(info.scanOffset > 0 && info.scanOffset <= info.eoiOffset);
+    CHECK(info.eoiOffset + 1 < len);
+    CHECK(data[info.eoiOffset] == 0xFF && data[info.eoiOffset + 1] == 0xD9);
+    CHECK(info.width != 0 && info.height != 0);
+}
+
+static void testValidFrames(std::mt19937& rng) {
+    const frame_spec_t specs[] = {
+        {640, 480, 80, 0x21, 0, 30000},
+        {800, 600, 50, 0x22, 40, 60000},
+        {320, 240, 20, 0x21, 0, 5000},
+        {1280, 720, 95, 0x21, 8, 120000},
+    };
+
+    for (const frame_spec_t& spec : specs) {
+        size_t scanOffset;
+        std::vector<uint8_t> frame = makeFrame(spec, rng, &scanOffset);
+
+        jpeg_info_t info;
+        CHECK(jpegScan(frame.data(), frame.size(), &info));
+        CHECK_EQ(info.width, spec.width);
+        CHECK_EQ(info.height, spec.height);
+        CHECK_EQ(info.components, 3);
+        CHECK_EQ(info.sampling, spec.sampling);
+        CHECK_EQ(info.restartInterval, spec.restartInterval);
+        CHECK_EQ(info.qtables, 2);
+        CHECK(abs((int)info.quality - spec.quality) <= 2);
+        CHECK(info.qtableOffset[0] != 0 && info.qtableOffset[1] == info.qtableOffset[0] + 65);
+        CHECK_EQ(info.scanOffset, scanOffset);
+        CHECK_EQ(info.eoiOffset, frame.size() - 2);
+
+        // padding sau EOI (UVC) vẫn hợp lệ
+        std::vector<uint8_t> padded = frame;
+        padded.insert(padded.end(), 37, 0x00);
+        CHECK(jpegScan(padded.data(), padded.size(), &info));
+        CHECK_EQ(info.eoiOffset, frame.size() - 2);
+
+        // mọi độ dài cắt cụt đều bị từ chối
+        int accepted = 0;
+        for (size_t cut = 0; cut < frame.size() - 1; cut++) {
+            if (jpegScan(frame.data(), cut, &info)) accepted++;
+        }
+        CHECK_EQ(accepted, 0);
+    }
+}
+
+// Frame bị cắt giữa entropy rồi frame kế tiếp nối vào (SOI giữa scan)
+static void testMergedFrames(std::mt19937& rng) {
+    const frame_spec_t spec = {640, 480, 70, 0x21, 0, 20000};
+    size_t scanA, scanB;
+    std::vector<uint8_t> a = makeFrame(spec, rng, &scanA);
+    std::vector<uint8_t> b = makeFrame(spec, rng, &scanB);
+
+    for (size_t cut = scanA + 1; cut < a.size() - 2; cut += 1777) {
+        std::vector<uint8_t> merged(a.begin(), a.begin() + cut);
+        // không để phần cắt kết thúc giữa một cặp FF xx
+        if (merged.back() == 0xFF) merged.pop_back();
+        merged.insert(merged.end(), b.begin(), b.end());
+
+        jpeg_info_t info;
+        CHECK(!jpegScan(merged.data(), merged.size(), &info));
+    }
+
+    // hai frame trọn vẹn nối nhau: nhận frame đầu, EOI của frame đầu
+    std::vector<uint8_t> both = a;
+    both.insert(both.end(), b.begin(), b.end());
+    jpeg_info_t info;
+    CHECK(jpegScan(both.data(), both.size(), &info));
+    CHECK_EQ(info.eoiOffset, a.size() - 2);
+}
+
+// Đột biến ngẫu nhiên: không đọc ngoài buffer (chạy kèm HOST_SANITIZE) và
+// khi chấp nhận thì kết quả vẫn tự nhất quán
+static void testMutations(std::mt19937& rng) {
+    const frame_spec_t spec = {320, 240, 60, 0x21, 16, 4000};
+    size_t scanOffset;
+    std::vector<uint8_t> base = makeFrame(spec, rng, &scanOffset);
+
+    for (int iter = 0; iter < 20000; iter++) {
+        std::vector<uint8_t> frame = base;
+        int flips = 1 + rng() % 4;
+        for (int f = 0; f < flips; f++) {
+            // dồn đột biến vào header nơi có nhiều nhánh parse
+            size_t span = (rng() & 1) ? scanOffset + 8 : frame.size();
+            frame[rng() % span] = rng() & 0xFF;
+        }
+        size_t len = (rng() % 8 == 0) ? rng() % frame.size() : frame.size();
+
+        // copy đúng len byte để ASan bắt được đọc quá cuối
+        std::vector<uint8_t> exact(frame.begin(), frame.begin() + len);
+        jpeg_info_t info;
+        if (jpegScan(exact.data(), exact.size(), &info)) checkInvariants(exact.data(), exact.size(), info);
+    }
+}
+
+static double benchUs(const std::vector<uint8_t>& frame, int iterations) {
+    jpeg_info_t info;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        if (!jpegScan(frame.data(), frame.size(), &info)) return -1;
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+}
+
+static void benchmark(std::mt19937& rng) {
+    const frame_spec_t spec = {800, 600, 80, 0x21, 0, 60000};
+    size_t scanOffset;
+    std::vector<uint8_t> frame = makeFrame(spec, rng, &scanOffset);
+    double us = benchUs(frame, 2000);
+    CHECK(us >= 0);
+    printf("[bench] synthetic %zu bytes: %.2f us/frame (%.0f MB/s)\n",
+           frame.size(), us, frame.size() / us);
+}
+
+// Corpus frame thật: mọi file .jpg phải được nhận, in thời gian trung bình
+static void scanCorpus(const char* dir) {
+    DIR* d = opendir(dir);
+    if (!d) {
+        fprintf(stderr, "cannot open corpus %s\n", dir);
+        testFailures++;
+        return;
+    }
+
+    int files = 0;
+    double totalUs = 0;
+    size_t totalBytes = 0;
+    struct dirent* entry;
+    while ((entry = readdir(d)) != nullptr) {
+        std::string name = entry->d_name;
+        if (name.size() < 4 || name.compare(name.size() - 4, 4, ".jpg") != 0) continue;
+
+        std::string path = std::string(dir) + "/" + name;
+        FILE* f = fopen(path.c_str(), "rb");
+        if (!f) continue;
+        std::vector<uint8_t> data;
+        uint8_t buf[4096];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.insert(data.end(), buf, buf + n);
+        fclose(f);
+
+        double us = benchUs(data, 200);
+        if (us < 0) fprintf(stderr, "rejected: %s\n", path.c_str());
+        CHECK(us >= 0);
+        totalUs += us;
+        totalBytes += data.size();
+        files++;
+    }
+    closedir(d);
+
+    if (files) {
+        printf("[bench] corpus %d files, avg %zu bytes: %.2f us/frame\n",
+               files, totalBytes / files, totalUs / files);
+    }
+}
+
+int main(int argc, char** argv) {
+    std::mt19937 rng(2435);
+    testValidFrames(rng);
+    testMergedFrames(rng);
+    testMutations(rng);
+    benchmark(rng);
+    if (argc > 1) scanCorpus(argv[1]);
+    return TEST_RESULT();
+}
\ No newline at end of file
@@ -0,0 +1,157 @@
+// Phát lại chuỗi sườn PIR qua queue SPSC + bộ lọc debounce/cooldown giống
+// SensorTask, so sánh với danh sách sự kiện mong đợi.
+
+#include "pir_edges.h"
+#include "test_check.h"
+
+#include <thread>
+#include <vector>
+
+#define DEBOUNCE_MS 50
+#define COOLDOWN_MS 5000
+
+typedef struct {
+    uint32_t time;
+    uint8_t level;
+} trace_edge_t;
+
+typedef struct {
+    pir_event_type_t type;
+    uint32_t time;
+} expected_t;
+
+// Đẩy trace qua queue rồi lọc; poll ở mỗi mốc pollStep ms như chu kỳ SensorTask
+static std::vector<pir_event_t> replay(const trace_edge_t* trace, size_t count, uint32_t endTime) {
+    pir_edge_queue_t queue = {};
+    pir_filter_t filter;
+    pirFilterInit(&filter, 0, DEBOUNCE_MS, COOLDOWN_MS);
+
+    std::vector<pir_event_t> events;
+    size_t next = 0;
+    for (uint32_t now = 0; now <= endTime; now += 10) {
+        while (next < count && trace[next].time <= now) {
+            CHECK(pirEdgePush(&queue, trace[next].time, trace[next].level));
+            next++;
+        }
+        pir_edge_t edge;
+        while (pirEdgePop(&queue, &edge)) {
+            pir_event_t ev = pirFilterEdge(&filter, &edge);
+            if (ev.type != PIR_EVENT_NONE) events.push_back(ev);
+        }
+        pir_event_t ev = pirFilterPoll(&filter, now);
+        if (ev.type != PIR_EVENT_NONE) events.push_back(ev);
+    }
+    return events;
+}
+
+static void expectEvents(const std::vector<pir_event_t>& got, const expected_t* want, size_t count) {
+    CHECK_EQ(got.size(), count);
+    for (size_t i = 0; i < count && i < got.size(); i++) {
+        CHECK_EQ(got[i].type, want[i].type);
+        CHECK_EQ(got[i].time, want[i].time);
+    }
+}
+
+// Nhiễu ngắn (luồng gió HVAC) bị bỏ, xung thật giữ thời điểm sườn gốc
+static void testGlitchesIgnored() {
+    const trace_edge_t trace[] = {
+        {1000, 1}, {1012, 0},           // 12 ms: nhiễu
+        {1500, 1}, {1530, 0},           // 30 ms: nhiễu
+        {2003, 1}, {3207, 0},           // chuyển động thật
+    };
+    const expected_t want[] = {
+        {PIR_EVENT_START, 2003},
+        {PIR_EVENT_END, 3207},
+    };
+    expectEvents(replay(trace, 6, 4000), want, 2);
+}
+
+// Lần lên thứ hai trong cooldown không kích hoạt lại, lần sau cooldown thì có
+static void testCooldown() {
+    const trace_edge_t trace[] = {
+        {1000, 1}, {2000, 0},
+        {4000, 1}, {4500, 0},
+        {6100, 1}, {7000, 0},
+    };
+    const expected_t want[] = {
+        {PIR_EVENT_START, 1000},
+        {PIR_EVENT_END, 2000},
+        {PIR_EVENT_START_COOLDOWN, 4000},
+        {PIR_EVENT_END, 4500},
+        {PIR_EVENT_START, 6100},
+        {PIR_EVENT_END, 7000},
+    };
+    expectEvents(replay(trace, 6, 8000), want, 6);
+}
+
+// Sườn trùng mức (mất một sườn do tràn queue) không tạo sự kiện giả
+static void testDuplicateLevels() {
+    const trace_edge_t trace[] = {
+        {1000, 1}, {1100, 1}, {1800, 0}, {1900, 0},
+    };
+    const expected_t want[] = {
+        {PIR_EVENT_START, 1000},
+        {PIR_EVENT_END, 1800},
+    };
+    expectEvents(replay(trace, 4, 3000), want, 2);
+}
+
+// Chuyển động bắt đầu sát lúc millis() tràn 32 bit
+static void testWraparound() {
+    pir_filter_t filter;
+    pirFilterInit(&filter, 0, DEBOUNCE_MS, COOLDOWN_MS);
+
+    pir_edge_t up = {0xFFFFFFF0u, 1};
+    CHECK_EQ(pirFilterEdge(&filter, &up).type, PIR_EVENT_NONE);
+    CHECK_EQ(pirFilterPoll(&filter, 0xFFFFFFF0u + 20).type, PIR_EVENT_NONE);
+    pir_event_t ev = pirFilterPoll(&filter, 0xFFFFFFF0u + DEBOUNCE_MS);
+    CHECK_EQ(ev.type, PIR_EVENT_START);
+    CHECK_EQ(ev.time, 0xFFFFFFF0u);
+
+    // cooldown tính qua điểm tràn
+    pir_edge_t down = {100, 0};
+    pirFilterEdge(&filter, &down);
+    CHECK_EQ(pirFilterPoll(&filter, 200).type, PIR_EVENT_END);
+    pir_edge_t again = {1000, 1};
+    pirFilterEdge(&filter, &again);
+    CHECK_EQ(pirFilterPoll(&filter, 1100).type, PIR_EVENT_START_COOLDOWN);
+}
+
+// Queue SPSC giữa hai thread: không mất, không lặp, đúng thứ tự
+static void testQueueThreads() {
+    static pir_edge_queue_t queue = {};
+    const uint32_t total = 50000;
+
+    std::thread producer([&] {
+        for (uint32_t i = 0; i < total; i++) {
+            while (!pirEdgePush(&queue, i, i & 1)) std::this_thread::yield();
+        }
+    });
+
+    uint32_t expected = 0;
+    while (expected < total) {
+        pir_edge_t edge;
+        if (!pirEdgePop(&queue, &edge)) {
+            std::this_thread::yield();
+            continue;
+        }
+        CHECK_EQ(edge.time, expected);
+        CHECK_EQ(edge.level, expected & 1);
+        expected++;
+    }
+    producer.join();
+
+    // overflows chỉ đếm lần push bị từ chối
+    pir_edge_queue_t full = {};
+    for (int i = 0; i < PIR_EDGE_QUEUE + 5; i++) pirEdgePush(&full, i, 1);
+    CHECK_EQ(full.overflows, 5);
+}
+
+int main() {
+    testGlitchesIgnored();
+    testCooldown();
+    testDuplicateLevels();
+    testWraparound();
+    testQueueThreads();
+    return TEST_RESULT();
+}
\ No newline at end of file
@@ -0,0 +1,154 @@
+// Header RTP/JPEG (RFC 2435) do rtpJpegNext dựng: trường RTP, fragment
+// offset, type/Q/kích thước, restart marker header, bảng lượng tử ở gói đầu,
+// marker bit ở gói cuối và payload ghép lại đúng entropy data.
+
+#include "rtp_jpeg.h"
+#include "test_check.h"
+
+#include <vector>
+
+static const size_t MTU = 1400;
+
+static uint32_t get32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static uint16_t get16(const uint8_t* p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+struct TestFrame {
+    std::vector<uint8_t> data;
+    jpeg_info_t info;
+};
+
+// Frame giả: bảng 0 ở byte 20, bảng 1 ở byte 90, entropy data từ byte 200
+static TestFrame makeFrame(size_t entropyLen, uint8_t sampling, uint16_t restartInterval, bool secondTable) {
+    TestFrame f;
+    f.data.resize(200 + entropyLen + 2);
+    for (size_t i = 0; i < f.data.size(); i++) f.data[i] = (uint8_t)(i * 31 + 7);
+
+    f.info = {};
+    f.info.width = 640;
+    f.info.height = 480;
+    f.info.restartInterval = restartInterval;
+    f.info.components = 3;
+    f.info.sampling = sampling;
+    f.info.qtables = secondTable ? 2 : 1;
+    f.info.qtableOffset[0] = 20;
+    f.info.qtableOffset[1] = secondTable ? 90 : 0;
+    f.info.scanOffset = 200;
+    f.info.eoiOffset = 200 + entropyLen;
+    return f;
+}
+
+static void checkFrame(const TestFrame& f, uint8_t wantType, uint32_t ts90k) {
+    rtp_jpeg_frame_t rtp;
+    CHECK(rtpJpegBegin(&rtp, f.data.data(), &f.info, ts90k, MTU));
+
+    const uint32_t ssrc = 0xA1B2C3D4;
+    uint16_t seq = 0xFFFE;               // số thứ tự tràn giữa frame
+    std::vector<uint8_t> payload;
+    rtp_jpeg_packet_t pkt;
+    int packets = 0;
+    bool sawLast = false;
+
+    while (rtpJpegNext(&rtp, seq, ssrc, &pkt)) {
+        const uint8_t* h = pkt.header;
+        bool first = (packets == 0);
+        CHECK(!sawLast);
+
+        CHECK_EQ(h[0], 0x80);                                  // V = 2, không P/X/CC
+        CHECK_EQ(h[1] & 0x7F, RTP_PT_JPEG);
+        CHECK_EQ(get16(h + 2), seq);
+        CHECK_EQ(get32(h + 4), ts90k);
+        CHECK_EQ(get32(h + 8), ssrc);
+
+        CHECK_EQ(h[12], 0);                                    // type-specific
+        CHECK_EQ(get32(h + 12) & 0xFFFFFF, payload.size());    // fragment offset
+        CHECK_EQ(h[16], wantType);
+        CHECK_EQ(h[17], 255);
+        CHECK_EQ(h[18], 640 / 8);
+        CHECK_EQ(h[19], 480 / 8);
+
+        size_t hl = 20;
+        if (f.info.restartInterval) {
+            CHECK_EQ(get16(h + hl), f.info.restartInterval);
+            CHECK_EQ(get16(h + hl + 2), 0xFFFF);
+            hl += 4;
+        }
+
+        if (first) {
+            CHECK_EQ(h[hl], 0);
+            CHECK_EQ(h[hl + 1], 0);
+            CHECK_EQ(get16(h + hl + 2), 128);
+            hl += 4;
+            CHECK_EQ(pkt.segments, 3);
+            CHECK(pkt.segment[0] == f.data.data() + 20);
+            CHECK(pkt.segment[1] == f.data.data() + (f.info.qtableOffset[1] ? 90 : 20));
+            CHECK_EQ(pkt.segmentLen[0], 64);
+            CHECK_EQ(pkt.segmentLen[1], 64);
+        } else {
+            CHECK_EQ(pkt.segments, 1);
+        }
+        CHECK_EQ(pkt.headerLen, hl);
+
+        size_t total = pkt.headerLen;
+        for (int i = 0; i < pkt.segments; i++) total += pkt.segmentLen[i];
+        CHECK_EQ(pkt.len, total);
+        CHECK(pkt.len <= MTU);
+
+        const uint8_t* entropy = pkt.segment[pkt.segments - 1];
+        payload.insert(payload.end(), entropy, entropy + pkt.segmentLen[pkt.segments - 1]);
+
+        sawLast = pkt.last;
+        CHECK_EQ((h[1] & 0x80) != 0, pkt.last);
+        seq++;
+        packets++;
+    }
+
+    CHECK(sawLast);
+    size_t entropyLen = f.info.eoiOffset - f.info.scanOffset;
+    CHECK_EQ(payload.size(), entropyLen);
+    CHECK(payload == std::vector<uint8_t>(f.data.begin() + 200, f.data.begin() + 200 + entropyLen));
+}
+
+static void testPacketHeaders() {
+    checkFrame(makeFrame(60000, 0x21, 0, true), 0, 90000);
+    checkFrame(makeFrame(60000, 0x22, 0, true), 1, 123456789);
+    checkFrame(makeFrame(45000, 0x21, 40, true), 64, 0xFFFFFFF0);
+    checkFrame(makeFrame(45000, 0x22, 40, false), 65, 7);
+
+    // vừa đúng một gói và vừa tràn sang gói thứ hai
+    checkFrame(makeFrame(MTU - 12 - 8 - 4 - 128, 0x21, 0, true), 0, 1);
+    checkFrame(makeFrame(MTU - 12 - 8 - 4 - 128 + 1, 0x21, 0, true), 0, 1);
+    checkFrame(makeFrame(1, 0x21, 0, true), 0, 1);
+}
+
+static void testRejects() {
+    rtp_jpeg_frame_t rtp;
+
+    TestFrame f = makeFrame(1000, 0x11, 0, true);              // 4:4:4
+    CHECK(!rtpJpegBegin(&rtp, f.data.data(), &f.info, 0, MTU));
+
+    f = makeFrame(1000, 0x21, 0, true);
+    f.info.components = 1;
+    CHECK(!rtpJpegBegin(&rtp, f.data.data(), &f.info, 0, MTU));
+
+    f = makeFrame(1000, 0x21, 0, true);
+    f.info.qtableOffset[0] = 0;
+    CHECK(!rtpJpegBegin(&rtp, f.data.data(), &f.info, 0, MTU));
+
+    f = makeFrame(1000, 0x21, 0, true);
+    f.info.width = 2048;
+    CHECK(!rtpJpegBegin(&rtp, f.data.data(), &f.info, 0, MTU));
+
+    f = makeFrame(0, 0x21, 0, true);
+    CHECK(!rtpJpegBegin(&rtp, f.data.data(), &f.info, 0, MTU));
+}
+
+int main() {
+    testPacketHeaders();
+    testRejects();
+    return TEST_RESULT();
+}
\ No newline at end of file
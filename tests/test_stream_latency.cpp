@@ -0,0 +1,89 @@
+// Histogram tuổi frame, percentile và EWMA/đứng hình của stream_latency
+// với các mẫu tính tay.
+
+#include "stream_latency.h"
+#include "test_check.h"
+
+static void testBucketEdges() {
+    stream_latency_t l;
+    streamLatencyInit(&l, 1000);
+
+    // biên trên thuộc chính bucket đó, vượt 1 ms sang bucket kế
+    streamLatencyRecordAge(&l, 0);
+    streamLatencyRecordAge(&l, 10);
+    streamLatencyRecordAge(&l, 11);
+    streamLatencyRecordAge(&l, 2000);
+    streamLatencyRecordAge(&l, 2001);
+    streamLatencyRecordAge(&l, 4000000000u);
+
+    CHECK_EQ(l.ageHist[0], 2);
+    CHECK_EQ(l.ageHist[1], 1);
+    CHECK_EQ(l.ageHist[STREAM_AGE_BUCKETS - 2], 1);
+    CHECK_EQ(l.ageHist[STREAM_AGE_BUCKETS - 1], 2);
+}
+
+static void testPercentiles() {
+    stream_latency_t l;
+    streamLatencyInit(&l, 1000);
+    CHECK_EQ(streamLatencyPercentile(&l, 50), 0);
+
+    // 90 mẫu 15 ms, 9 mẫu 120 ms, 1 mẫu 900 ms
+    for (int i = 0; i < 90; i++) streamLatencyRecordAge(&l, 15);
+    for (int i = 0; i < 9; i++) streamLatencyRecordAge(&l, 120);
+    streamLatencyRecordAge(&l, 900);
+
+    CHECK_EQ(streamLatencyPercentile(&l, 50), 20);
+    CHECK_EQ(streamLatencyPercentile(&l, 90), 20);
+    CHECK_EQ(streamLatencyPercentile(&l, 95), 130);
+    CHECK_EQ(streamLatencyPercentile(&l, 99), 130);
+    CHECK_EQ(streamLatencyPercentile(&l, 100), 1000);
+
+    // một mẫu duy nhất: mọi percentile là bucket của nó
+    stream_latency_t one;
+    streamLatencyInit(&one, 1000);
+    streamLatencyRecordAge(&one, 45);
+    CHECK_EQ(streamLatencyPercentile(&one, 1), 50);
+    CHECK_EQ(streamLatencyPercentile(&one, 99), 50);
+}
+
+// rank dùng 64 bit: số mẫu lớn không tràn total * pct
+static void testLargeCounts() {
+    stream_latency_t l;
+    streamLatencyInit(&l, 1000);
+    l.ageHist[0] = 3000000000u;
+    l.ageHist[5] = 1000000000u;
+    CHECK_EQ(streamLatencyPercentile(&l, 50), 10);
+    CHECK_EQ(streamLatencyPercentile(&l, 99), 65);
+}
+
+static void testGapAndStalls() {
+    stream_latency_t l;
+    streamLatencyInit(&l, 1000);
+
+    streamLatencyRecordGap(&l, 100);
+    CHECK_EQ(l.avgFrameGap, 100);          // mẫu đầu lấy nguyên giá trị
+    streamLatencyRecordGap(&l, 180);
+    CHECK_EQ(l.avgFrameGap, 110);          // (100*7 + 180) / 8
+    CHECK_EQ(l.stalls, 0);
+
+    streamLatencyRecordGap(&l, 1000);      // đúng ngưỡng chưa tính
+    CHECK_EQ(l.stalls, 0);
+    streamLatencyRecordGap(&l, 1001);
+    CHECK_EQ(l.stalls, 1);
+
+    // 30 fps ổn định: EWMA hội tụ về 33
+    for (int i = 0; i < 200; i++) streamLatencyRecordGap(&l, 33);
+    CHECK(l.avgFrameGap >= 33 && l.avgFrameGap <= 40);
+
+    streamLatencyInit(&l, 1000);
+    CHECK_EQ(l.avgFrameGap, 0);
+    CHECK_EQ(l.stalls, 0);
+}
+
+int main() {
+    testBucketEdges();
+    testPercentiles();
+    testLargeCounts();
+    testGapAndStalls();
+    return TEST_RESULT();
+}
\ No newline at end of file
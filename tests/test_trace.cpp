@@ -0,0 +1,123 @@
+// Ring trace: ghi vòng qua TRACE_RING_EVENTS, JSON xuất ra hợp lệ, giữ đúng
+// các sự kiện mới nhất theo thứ tự và ts tương đối qua lúc timer 32 bit tràn.
+
+#include "trace.h"
+#include "test_check.h"
+
+#include <string>
+#include <vector>
+
+static std::string traceJson;
+static size_t maxChunk = 0;
+
+static void collect(const char* chunk) {
+    size_t len = strlen(chunk);
+    if (len > maxChunk) maxChunk = len;
+    traceJson += chunk;
+}
+
+static std::string render() {
+    traceJson.clear();
+    maxChunk = 0;
+    renderTraceJson(collect);
+    return traceJson;
+}
+
+// Kiểm tra cú pháp JSON đủ cho output của trace (object, array, string, số)
+struct JsonCheck {
+    const char* p;
+    bool ok = true;
+
+    void ws() { while (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t') p++; }
+    bool expect(char c) { ws(); if (*p != c) return ok = false; p++; return true; }
+
+    void string() {
+        if (!expect('"')) return;
+        while (*p && *p != '"') {
+            if (*p == '\\') p++;
+            if (*p) p++;
+        }
+        expect('"');
+    }
+    void number() {
+        const char* s = p;
+        if (*p == '-') p++;
+        while (*p >= '0' && *p <= '9') p++;
+        if (p == s) ok = false;
+    }
+    void value() {
+        ws();
+        if (*p == '{') {
+            p++; ws();
+            if (*p == '}') { p++; return; }
+            do { string(); expect(':'); value(); ws(); } while (ok && *p == ',' && p++);
+            expect('}');
+        } else if (*p == '[') {
+            p++; ws();
+            if (*p == ']') { p++; return; }
+            do { value(); ws(); } while (ok && *p == ',' && p++);
+            expect(']');
+        } else if (*p == '"') {
+            string();
+        } else {
+            number();
+        }
+    }
+    bool run(const std::string& s) {
+        p = s.c_str();
+        value();
+        ws();
+        return ok && *p == '\0';
+    }
+};
+
+// ts của các sự kiện "X" theo thứ tự xuất hiện
+static std::vector<long> completeEventTs(const std::string& json) {
+    std::vector<long> ts;
+    const char* key = "\"ph\":\"X\",\"ts\":";
+    for (size_t pos = json.find(key); pos != std::string::npos; pos = json.find(key, pos + 1)) {
+        ts.push_back(strtol(json.c_str() + pos + strlen(key), nullptr, 10));
+    }
+    return ts;
+}
+
+static void testEmptyRing() {
+    std::string json = render();
+    CHECK(JsonCheck().run(json));
+    CHECK_EQ(completeEventTs(json).size(), 0);
+}
+
+static void testPartialRing() {
+    for (uint32_t i = 0; i < 100; i++) traceRecord((trace_span_t)(i % TRACE_SPAN_COUNT), 1000 + i * 10);
+
+    std::string json = render();
+    CHECK(JsonCheck().run(json));
+    std::vector<long> ts = completeEventTs(json);
+    CHECK_EQ(ts.size(), 100);
+    for (size_t i = 0; i < ts.size(); i++) CHECK_EQ(ts[i], (long)i * 10);
+}
+
+// Ghi vượt ring nhiều vòng với start băng qua 2^32: chỉ còn TRACE_RING_EVENTS
+// sự kiện mới nhất, ts tính từ sự kiện cũ nhất nên vẫn tăng dần
+static void testWrapAndTimerOverflow() {
+    const uint32_t total = TRACE_RING_EVENTS * 3 + 17;
+    const uint32_t firstStart = 0xFFFFFFFFu - TRACE_RING_EVENTS * 2;
+    for (uint32_t i = 0; i < total; i++) traceRecord(TRACE_HTTP, firstStart + i);
+
+    std::string json = render();
+    CHECK(JsonCheck().run(json));
+    CHECK(maxChunk < 1536);
+    std::vector<long> ts = completeEventTs(json);
+    CHECK_EQ(ts.size(), TRACE_RING_EVENTS);
+    for (size_t i = 0; i < ts.size(); i++) CHECK_EQ(ts[i], (long)i);
+    CHECK(json.find("\"name\":\"frame_cb\",\"ph\":\"X\"") == std::string::npos);
+}
+
+int main() {
+    testEmptyRing();          // trước initializeTrace
+    CHECK(initializeTrace());
+    testEmptyRing();
+    testPartialRing();
+    testWrapAndTimerOverflow();
+    return TEST_RESULT();
+}
\ No newline at end of file
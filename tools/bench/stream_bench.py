@@ -0,0 +1,356 @@
+#!/usr/bin/env python3
+"""Benchmark /stream với N client, mỗi client có băng thông và RTT riêng.
+
+Chạy trên Linux cạnh camera_iuh_host (hoặc thiết bị thật trong LAN):
+
+    stream_bench.py --clients 4 --duration 20 --link 8mbit:20 --link 1mbit:150 \\
+                    --netem --out report.json
+
+--link RATE:RTT_MS gán lần lượt cho từng client (quay vòng). Với --netem, mỗi
+client bind một địa chỉ nguồn riêng 127.0.0.(10+i) và được shape bằng tc htb +
+netem trên --dev (mặc định lo): chiều server→client giới hạn RATE và trễ RTT/2,
+chiều ngược lại trễ RTT/2. Cần quyền root; qdisc bị xóa khi kết thúc.
+
+Mỗi client đo phía nhận: số frame, FPS, bytes/s, khoảng cách giữa hai frame
+(p50/p95/p99), số lần đứng hình (khoảng cách > --stall-ms), RTT lúc connect và
+tcpi_rcv_rtt. Cuối lượt, /stream/stats của firmware được ghép theo IP nguồn để
+có frame age p50/p95/p99 tính từ timestamp của frame_cb tới byte cuối cùng được
+ghi ra socket. Báo cáo JSON ra stdout hoặc --out; --min-fps làm lệnh trả mã 1
+khi có client dưới ngưỡng, để CI bắt regression.
+"""
+
+import argparse
+import json
+import signal
+import socket
+import struct
+import subprocess
+import sys
+import threading
+import time
+import urllib.request
+from urllib.parse import urlsplit
+
+TCP_INFO_RCV_RTT_OFFSET = 92    # struct tcp_info: 8 byte u8 + 21 u32 trước tcpi_rcv_rtt
+
+
+class Deadline(Exception):
+    """Hết cửa sổ đo: kết thúc bình thường, không phải lỗi."""
+
+
+def percentile(values, pct):
+    if not values:
+        return 0.0
+    ordered = sorted(values)
+    rank = min(len(ordered) - 1, max(0, int(round(pct / 100.0 * (len(ordered) - 1)))))
+    return ordered[rank]
+
+
+def parse_link(text):
+    rate, _, rtt = text.partition(":")
+    if not rate or not rtt:
+        raise argparse.ArgumentTypeError("--link phải có dạng RATE:RTT_MS, ví dụ 2mbit:80")
+    return {"rate": rate, "rtt_ms": float(rtt)}
+
+
+class Netem:
+    """htb + netem trên một interface, mỗi client một class lọc theo IP nguồn."""
+
+    def __init__(self, dev, server_ip):
+        self.dev = dev
+        self.server_ip = server_ip
+        self.active = False
+        self.delay = True     # False khi kernel không có sch_netem: chỉ giới hạn băng thông
+
+    def tc(self, *args, check=True):
+        proc = subprocess.run(["tc"] + list(args), stdout=subprocess.DEVNULL, stderr=subprocess.PIPE)
+        if check and proc.returncode != 0:
+            raise RuntimeError("tc %s: %s" % (" ".join(args), proc.stderr.decode().strip()))
+        return proc.returncode == 0
+
+    def setup(self, clients):
+        self.tc("qdisc", "replace", "dev", self.dev, "root", "handle", "1:", "htb", "default", "1", "r2q", "1000")
+        self.active = True
+        self.tc("class", "add", "dev", self.dev, "parent", "1:", "classid", "1:1", "htb", "rate", "10gbit")
+        for c in clients:
+            classid = "1:%d" % (10 + c.index)
+            half_rtt = "%.1fms" % (c.link["rtt_ms"] / 2)
+            self.tc("class", "add", "dev", self.dev, "parent", "1:", "classid", classid,
+                    "htb", "rate", c.link["rate"], "ceil", c.link["rate"])
+            if c.link["rtt_ms"] > 0 and self.delay:
+                if not self.tc("qdisc", "add", "dev", self.dev, "parent", classid, "handle", "%d:" % (10 + c.index),
+                               "netem", "delay", half_rtt, "limit", "10000", check=False):
+                    print("cảnh báo: không thêm được netem, chỉ giới hạn băng thông", file=sys.stderr)
+                    self.delay = False
+            # server → client (dữ liệu) và client → server (ACK, request)
+            for match in (("dst", c.src_ip), ("src", c.src_ip)):
+                self.tc("filter", "add", "dev", self.dev, "parent", "1:", "protocol", "ip", "prio", "1",
+                        "u32", "match", "ip", match[0], match[1] + "/32", "flowid", classid)
+
+    def teardown(self):
+        if self.active:
+            subprocess.run(["tc", "qdisc", "del", "dev", self.dev, "root"],
+                           stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+            self.active = False
+
+
+class StreamClient(threading.Thread):
+    def __init__(self, index, host, port, path, link, src_ip, stall_ms, deadline):
+        super().__init__(daemon=True)
+        self.index = index
+        self.host = host
+        self.port = port
+        self.path = path
+        self.link = link
+        self.src_ip = src_ip
+        self.stall_ms = stall_ms
+        self.deadline = deadline
+        self.sock = None
+        self.error = None
+        self.connect_rtt_ms = None
+        self.status = None
+        self.first_frame_ms = None
+        self.arrivals = []
+        self.frame_bytes = 0
+        self.total_bytes = 0
+        self.rcv_rtt_ms = []
+
+    def sample_tcp_info(self):
+        try:
+            info = self.sock.getsockopt(socket.IPPROTO_TCP, socket.TCP_INFO, 104)
+        except OSError:
+            return
+        if len(info) >= TCP_INFO_RCV_RTT_OFFSET + 4:
+            rcv_rtt_us = struct.unpack_from("I", info, TCP_INFO_RCV_RTT_OFFSET)[0]
+            if rcv_rtt_us:
+                self.rcv_rtt_ms.append(rcv_rtt_us / 1000.0)
+
+    def run(self):
+        try:
+            self.stream()
+        except Deadline:
+            pass
+        except (OSError, ValueError) as exc:
+            self.error = str(exc)
+        finally:
+            if self.sock:
+                self.sock.close()
+
+    def stream(self):
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        if self.src_ip:
+            self.sock.bind((self.src_ip, 0))
+        self.sock.settimeout(5)
+        start = time.monotonic()
+        self.sock.connect((self.host, self.port))
+        self.connect_rtt_ms = (time.monotonic() - start) * 1000
+        request = "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n" % (self.path, self.host)
+        self.sock.sendall(request.encode())
+        sent_at = time.monotonic()
+
+        buf = bytearray()
+        header, buf = self.read_until(buf, b"\r\n\r\n")
+        status_line = header.split(b"\r\n", 1)[0].decode(errors="replace")
+        self.status = int(status_line.split()[1]) if len(status_line.split()) > 1 else 0
+        if self.status != 200:
+            raise ValueError("HTTP %s" % status_line)
+
+        last_sample = 0.0
+        while time.monotonic() < self.deadline:
+            part, buf = self.read_until(buf, b"\r\n\r\n")
+            length = None
+            for line in part.split(b"\r\n"):
+                name, _, value = line.partition(b":")
+                if name.strip().lower() == b"content-length":
+                    length = int(value)
+            if length is None:
+                continue
+            while len(buf) < length:
+                buf += self.recv()
+            now = time.monotonic()
+            buf = buf[length:]
+            if self.first_frame_ms is None:
+                self.first_frame_ms = (now - sent_at) * 1000
+            self.arrivals.append(now)
+            self.frame_bytes += length
+            if now - last_sample >= 0.5:
+                self.sample_tcp_info()
+                last_sample = now
+
+    def recv(self):
+        chunk = self.sock.recv(65536)
+        if not chunk:
+            raise ValueError("server đóng kết nối")
+        self.total_bytes += len(chunk)
+        return chunk
+
+    def read_until(self, buf, marker):
+        while True:
+            pos = buf.find(marker)
+            if pos >= 0:
+                return bytes(buf[:pos]), buf[pos + len(marker):]
+            if time.monotonic() >= self.deadline:
+                raise Deadline()
+            buf += self.recv()
+
+    def report(self, window_s):
+        gaps = [(b - a) * 1000 for a, b in zip(self.arrivals, self.arrivals[1:])]
+        span = self.arrivals[-1] - self.arrivals[0] if len(self.arrivals) > 1 else 0
+        return {
+            "id": self.index,
+            "src_ip": self.src_ip,
+            "link": self.link,
+            "status": self.status,
+            "error": self.error,
+            "connect_rtt_ms": round(self.connect_rtt_ms, 2) if self.connect_rtt_ms is not None else None,
+            "tcp_rcv_rtt_ms_p50": round(percentile(self.rcv_rtt_ms, 50), 2),
+            "first_frame_ms": round(self.first_frame_ms, 1) if self.first_frame_ms is not None else None,
+            "frames": len(self.arrivals),
+            "fps": round((len(self.arrivals) - 1) / span, 2) if span > 0 else 0.0,
+            "bytes_per_sec": int(self.total_bytes / window_s) if window_s > 0 else 0,
+            "avg_frame_bytes": int(self.frame_bytes / len(self.arrivals)) if self.arrivals else 0,
+            "gap_ms": {
+                "p50": round(percentile(gaps, 50), 1),
+                "p95": round(percentile(gaps, 95), 1),
+                "p99": round(percentile(gaps, 99), 1),
+                "max": round(max(gaps), 1) if gaps else 0.0,
+            },
+            "stalls": sum(1 for g in gaps if g > self.stall_ms),
+        }
+
+
+def fetch_json(url, timeout=5):
+    with urllib.request.urlopen(url, timeout=timeout) as resp:
+        return json.loads(resp.read().decode())
+
+
+def wait_for_server(base_url, timeout_s):
+    deadline = time.monotonic() + timeout_s
+    while time.monotonic() < deadline:
+        try:
+            with urllib.request.urlopen(base_url + "/metrics", timeout=2) as resp:
+                if resp.status == 200:
+                    return True
+        except OSError:
+            pass
+        time.sleep(0.5)
+    return False
+
+
+def main():
+    parser = argparse.ArgumentParser(description="N-client /stream benchmark, báo cáo JSON")
+    parser.add_argument("--url", default="http://127.0.0.1:8080", help="gốc HTTP của firmware")
+    parser.add_argument("--path", default="/stream", help="endpoint stream (/stream, /stream/sub, ...)")
+    parser.add_argument("--clients", type=int, default=4)
+    parser.add_argument("--duration", type=float, default=15.0, help="giây đo, sau warm-up")
+    parser.add_argument("--warmup", type=float, default=2.0, help="giây bỏ qua lúc đầu")
+    parser.add_argument("--link", type=parse_link, action="append", default=[],
+                        help="RATE:RTT_MS cho client, lặp lại được; thiếu thì không giới hạn")
+    parser.add_argument("--netem", action="store_true", help="áp --link bằng tc htb/netem (cần root)")
+    parser.add_argument("--dev", default="lo", help="interface cho tc")
+    parser.add_argument("--stall-ms", type=float, default=1000.0, help="khoảng cách frame tính là đứng hình")
+    parser.add_argument("--min-fps", type=float, default=0.0, help="trả mã 1 nếu client nào có fps thấp hơn")
+    parser.add_argument("--host-binary", help="tự chạy camera_iuh_host này trong lúc đo")
+    parser.add_argument("--out", help="ghi báo cáo JSON ra file thay vì stdout")
+    args = parser.parse_args()
+
+    base = args.url.rstrip("/")
+    split = urlsplit(base)
+    host = split.hostname or "127.0.0.1"
+    port = split.port or 80
+    server_ip = socket.gethostbyname(host)
+    if args.netem and not server_ip.startswith("127.") and args.dev == "lo":
+        parser.error("--netem trên lo chỉ dùng được với server 127.x; chọn --dev cho thiết bị thật")
+
+    firmware = None
+    if args.host_binary:
+        firmware = subprocess.Popen([args.host_binary], stdin=subprocess.PIPE,
+                                    stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    netem = Netem(args.dev, server_ip)
+
+    def cleanup(*_):
+        netem.teardown()
+        if firmware and firmware.poll() is None:
+            firmware.send_signal(signal.SIGTERM)
+            firmware.wait(timeout=5)
+
+    signal.signal(signal.SIGTERM, lambda *a: (cleanup(), sys.exit(1)))
+    try:
+        if not wait_for_server(base, 30 if firmware else 5):
+            print("không kết nối được %s/metrics" % base, file=sys.stderr)
+            return 2
+
+        links = args.link or [{"rate": None, "rtt_ms": 0.0}]
+        local = server_ip.startswith("127.")
+        start = time.monotonic()
+        deadline = start + args.warmup + args.duration
+        clients = []
+        for i in range(args.clients):
+            src_ip = "127.0.0.%d" % (10 + i) if local else None
+            clients.append(StreamClient(i, host, port, args.path, links[i % len(links)], src_ip,
+                                        args.stall_ms, deadline))
+        if args.netem:
+            try:
+                netem.setup([c for c in clients if c.link["rate"]])
+            except RuntimeError as exc:
+                print(exc, file=sys.stderr)
+                return 2
+
+        for c in clients:
+            c.start()
+        time.sleep(args.warmup)
+        # bỏ frame warm-up: chỉ tính từ mốc này
+        mark = time.monotonic()
+        bytes_at_mark = {c.index: c.total_bytes for c in clients}
+        time.sleep(max(0.0, deadline - time.monotonic() - 0.5))
+
+        # /stream/stats lấy trước khi client đóng, server mới còn giữ slot
+        try:
+            server_stats = fetch_json(base + "/stream/stats")
+        except (OSError, ValueError):
+            server_stats = []
+        for c in clients:
+            c.join(timeout=10)
+        window = time.monotonic() - mark
+
+        reports = []
+        for c in clients:
+            c.arrivals = [t for t in c.arrivals if t >= mark]
+            c.total_bytes -= bytes_at_mark[c.index]
+            r = c.report(window)
+            r["server"] = next((s for s in server_stats if c.src_ip and s.get("ip") == c.src_ip), None)
+            reports.append(r)
+
+        fps = [r["fps"] for r in reports]
+        report = {
+            "url": base + args.path,
+            "clients": args.clients,
+            "duration_s": round(window, 2),
+            "shaping": {"rate": args.netem, "delay": args.netem and netem.delay},
+            "stall_ms": args.stall_ms,
+            "summary": {
+                "total_fps": round(sum(fps), 2),
+                "min_fps": min(fps) if fps else 0.0,
+                "total_bytes_per_sec": sum(r["bytes_per_sec"] for r in reports),
+                "stalls": sum(r["stalls"] for r in reports),
+                "errors": sum(1 for r in reports if r["error"]),
+            },
+            "per_client": reports,
+        }
+    finally:
+        cleanup()
+
+    text = json.dumps(report, indent=2)
+    if args.out:
+        with open(args.out, "w") as f:
+            f.write(text + "\n")
+    else:
+        print(text)
+    if args.min_fps and report["summary"]["min_fps"] < args.min_fps:
+        print("min_fps %.2f < %.2f" % (report["summary"]["min_fps"], args.min_fps), file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,424 @@
+#!/usr/bin/env python3
+"""Client RTSP/RTP-JPEG tối giản để kiểm tra rtsp_server khi không có ffprobe/VLC.
+
+    rtsp_check.py rtsp://127.0.0.1:8554/ --transport udp --frames 30 \\
+                  --out frames/ --source-dir jpeg/
+
+Chạy OPTIONS, DESCRIBE, SETUP (TCP interleaved hoặc UDP), PLAY, PAUSE, PLAY,
+TEARDOWN và kiểm tra từng gói RTP theo RFC 3550/2435: version 2, PT 26, SSRC
+như SETUP báo, seq liên tục, mỗi frame một timestamp 90 kHz và marker ở gói
+cuối, fragment offset liền nhau, bảng lượng tử (Q=255) ở gói đầu của frame.
+Frame được ráp lại thành JFIF với header của RFC 2435 Appendix A (bảng Huffman
+chuẩn Annex K) và ghi vào --out. Với --source-dir (thư mục JPEG đưa cho
+camera_iuh_host --camera-dir), dữ liệu entropy và bảng lượng tử của mỗi frame
+phải trùng từng byte với một file nguồn. Với UDP, một RTCP receiver report
+được gửi tới server_port + 1 và cổng đó không được trả ICMP unreachable.
+Sau PAUSE không được còn gói RTP nào. Trả mã 1 khi có lỗi.
+"""
+
+import argparse
+import os
+import socket
+import struct
+import sys
+import time
+from urllib.parse import urlsplit
+
+RTP_PT_JPEG = 26
+PAUSE_GRACE_S = 0.3     # gói UDP đã vào hàng đợi trước khi server nhận PAUSE
+PAUSE_WATCH_S = 1.0
+UDP_RCVBUF = 4 << 20    # frame ~100 KB tới dồn từng đợt, buffer mặc định làm rơi gói
+
+# DHT với 4 bảng Huffman chuẩn (Annex K.3), giống standardDht trong jpeg_scan.cpp
+STD_DHT = bytes.fromhex(
+    "ffc401a20000010501010101010100000000000000000102030405060708090a0b100002010303020403050504040000017d"
+    "01020300041105122131410613516107227114328191a1082342b1c11552d1f02433627282090a161718191a25262728292a"
+    "3435363738393a434445464748494a535455565758595a636465666768696a737475767778797a838485868788898a929394"
+    "95969798999aa2a3a4a5a6a7a8a9aab2b3b4b5b6b7b8b9bac2c3c4c5c6c7c8c9cad2d3d4d5d6d7d8d9dae1e2e3e4e5e6e7e8"
+    "e9eaf1f2f3f4f5f6f7f8f9fa0100030101010101010101010000000000000102030405060708090a0b110002010204040304"
+    "0705040400010277000102031104052131061241510761711322328108144291a1b1c109233352f0156272d10a162434e125"
+    "f11718191a262728292a35363738393a434445464748494a535455565758595a636465666768696a737475767778797a8283"
+    "8485868788898a92939495969798999aa2a3a4a5a6a7a8a9aab2b3b4b5b6b7b8b9bac2c3c4c5c6c7c8c9cad2d3d4d5d6d7d8"
+    "d9dae2e3e4e5e6e7e8e9eaf2f3f4f5f6f7f8f9fa")
+
+
+class CheckError(Exception):
+    pass
+
+
+class Rtsp:
+    """Kết nối RTSP; gói interleaved ($) đến xen giữa response được gom vào self.rtp."""
+
+    def __init__(self, url, timeout):
+        parts = urlsplit(url)
+        self.url = url
+        self.host = parts.hostname
+        self.sock = socket.create_connection((parts.hostname, parts.port or 554), timeout=timeout)
+        self.buf = b""
+        self.cseq = 0
+        self.session = None
+        self.rtp = []
+
+    def _fill(self):
+        data = self.sock.recv(65536)
+        if not data:
+            raise CheckError("server closed the RTSP connection")
+        self.buf += data
+
+    def _interleaved(self):
+        """Tách một gói $ ở đầu buffer, False nếu chưa đủ byte."""
+        if len(self.buf) < 4:
+            return False
+        channel, length = self.buf[1], struct.unpack(">H", self.buf[2:4])[0]
+        if len(self.buf) < 4 + length:
+            return False
+        self.rtp.append((channel, self.buf[4:4 + length], time.monotonic()))
+        self.buf = self.buf[4 + length:]
+        return True
+
+    def read_interleaved(self, until):
+        """Nhận gói $ tới mốc until (monotonic); response RTSP thì báo lỗi."""
+        while time.monotonic() < until:
+            if self.buf[:1] == b"$":
+                if self._interleaved():
+                    continue
+            elif self.buf:
+                raise CheckError("unexpected RTSP data between packets: %r" % self.buf[:40])
+            self.sock.settimeout(max(0.01, until - time.monotonic()))
+            try:
+                self._fill()
+            except socket.timeout:
+                pass
+
+    def request(self, method, url=None, headers=None, expect=200):
+        self.cseq += 1
+        lines = ["%s %s RTSP/1.0" % (method, url or self.url), "CSeq: %d" % self.cseq]
+        if self.session:
+            lines.append("Session: %s" % self.session)
+        lines += ["%s: %s" % kv for kv in (headers or {}).items()]
+        self.sock.sendall(("\r\n".join(lines) + "\r\n\r\n").encode())
+
+        while True:
+            if self.buf[:1] == b"$":
+                if not self._interleaved():
+                    self._fill()
+                continue
+            end = self.buf.find(b"\r\n\r\n")
+            if end < 0:
+                self._fill()
+                continue
+            head = self.buf[:end].decode("latin-1").split("\r\n")
+            fields = {}
+            for line in head[1:]:
+                name, _, value = line.partition(":")
+                fields[name.strip().lower()] = value.strip()
+            length = int(fields.get("content-length", 0))
+            while len(self.buf) < end + 4 + length:
+                self._fill()
+            body = self.buf[end + 4:end + 4 + length]
+            self.buf = self.buf[end + 4 + length:]
+            break
+
+        status = head[0].split(" ", 2)
+        if int(status[1]) != expect:
+            raise CheckError("%s: expected %d, got %s" % (method, expect, head[0]))
+        if fields.get("cseq") != str(self.cseq):
+            raise CheckError("%s: CSeq %s != %d" % (method, fields.get("cseq"), self.cseq))
+        if "session" in fields:
+            self.session = fields["session"].split(";")[0]
+        return fields, body
+
+
+class Depacketizer:
+    """Kiểm tra gói RTP/JPEG (RFC 2435) và ráp lại frame."""
+
+    def __init__(self, ssrc):
+        self.ssrc = ssrc
+        self.seq = None
+        self.ts = None
+        self.parts = []
+        self.frames = []
+        self.packets = 0
+        self.errors = []
+
+    def error(self, msg):
+        if len(self.errors) < 20:
+            self.errors.append(msg)
+
+    def push(self, pkt):
+        if len(pkt) < 20 or pkt[0] >> 6 != 2:
+            return self.error("bad RTP header")
+        self.packets += 1
+        marker, pt = pkt[1] >> 7, pkt[1] & 0x7F
+        seq, ts, ssrc = struct.unpack(">HII", pkt[2:12])
+        csrc = pkt[0] & 0x0F
+        pos = 12 + 4 * csrc
+        if pkt[0] & 0x10:
+            pos += 4 + 4 * struct.unpack(">H", pkt[pos + 2:pos + 4])[0]
+        if pt != RTP_PT_JPEG:
+            self.error("payload type %d" % pt)
+        if self.ssrc is not None and ssrc != self.ssrc:
+            self.error("SSRC %08X != %08X" % (ssrc, self.ssrc))
+        if self.seq is not None and seq != (self.seq + 1) & 0xFFFF:
+            self.error("seq jump %d -> %d" % (self.seq, seq))
+            self.parts = []
+        self.seq = seq
+
+        hdr = pkt[pos:pos + 8]
+        offset = struct.unpack(">I", b"\0" + hdr[1:4])[0]
+        typ, q, width, height = hdr[4], hdr[5], hdr[6] * 8, hdr[7] * 8
+        pos += 8
+        restart = None
+        if typ >= 64:
+            restart = struct.unpack(">H", pkt[pos:pos + 2])[0]
+            pos += 4
+        qtables = None
+        if offset == 0:
+            if self.parts:
+                self.error("frame ts %u lost its marker packet" % self.ts)
+            self.parts = []
+            self.ts = ts
+            if q >= 128:
+                _, precision, qlen = struct.unpack(">BBH", pkt[pos:pos + 4])
+                if precision != 0 or qlen != 128:
+                    self.error("qtable header precision %d length %d" % (precision, qlen))
+                qtables = pkt[pos + 4:pos + 4 + qlen]
+                pos += 4 + qlen
+        elif ts != self.ts:
+            self.error("fragment of ts %u inside frame ts %u" % (ts, self.ts))
+        data = pkt[pos:]
+        have = sum(len(p[1]) for p in self.parts)
+        if offset != have:
+            self.error("fragment offset %d, expected %d" % (offset, have))
+        self.parts.append(((typ, q, width, height, restart, qtables), data))
+
+        if marker:
+            meta = self.parts[0][0]
+            if meta[5] is None:
+                self.error("frame ts %u has no qtables (Q=%d)" % (ts, meta[1]))
+            elif any(p[0][:5] != meta[:5] for p in self.parts):
+                self.error("main header changes within frame ts %u" % ts)
+            else:
+                self.frames.append((ts, meta, b"".join(p[1] for p in self.parts)))
+            self.parts = []
+
+
+def segment(marker, payload):
+    return struct.pack(">BBH", 0xFF, marker, len(payload) + 2) + payload
+
+
+def build_jfif(meta, scan):
+    """Header RFC 2435 Appendix A: type 0 là 4:2:2, type 1 là 4:2:0."""
+    typ, _, width, height, restart, qtables = meta
+    luma = 0x21 if typ & 0x3F == 0 else 0x22
+    out = b"\xff\xd8"
+    out += segment(0xDB, b"\x00" + qtables[:64] + b"\x01" + qtables[64:128])
+    out += segment(0xC0, struct.pack(">BHHB", 8, height, width, 3) +
+                   bytes([1, luma, 0, 2, 0x11, 1, 3, 0x11, 1]))
+    out += STD_DHT
+    if restart:
+        out += segment(0xDD, struct.pack(">H", restart))
+    out += segment(0xDA, bytes([3, 1, 0x00, 2, 0x11, 3, 0x11, 0, 63, 0]))
+    return out + scan + b"\xff\xd9"
+
+
+def jpeg_parts(data):
+    """(bảng lượng tử 0+1, entropy data) của một file JPEG nguồn."""
+    tables = {}
+    pos = 2
+    while pos + 4 <= len(data) and data[pos] == 0xFF:
+        marker = data[pos + 1]
+        end = pos + 2 + struct.unpack(">H", data[pos + 2:pos + 4])[0]
+        if marker == 0xDB:
+            p = pos + 4
+            while p < end:
+                tables[data[p] & 0x0F] = data[p + 1:p + 65]
+                p += 65
+        if marker == 0xDA:
+            eoi = data.rfind(b"\xff\xd9")
+            return tables.get(0, b"") + tables.get(1, tables.get(0, b"")), data[end:eoi]
+        pos = end
+    return None
+
+
+def udp_pair():
+    """Hai socket UDP ở cổng chẵn N và N+1 như client RTP thông thường."""
+    for _ in range(50):
+        rtp = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        rtp.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, UDP_RCVBUF)
+        rtp.bind(("0.0.0.0", 0))
+        port = rtp.getsockname()[1]
+        if port % 2 == 0:
+            rtcp = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+            try:
+                rtcp.bind(("0.0.0.0", port + 1))
+                return rtp, rtcp, port
+            except OSError:
+                rtcp.close()
+        rtp.close()
+    raise CheckError("cannot bind an RTP/RTCP port pair")
+
+
+def receiver_report(ssrc, source_ssrc):
+    """RTCP RR (PT 201) rỗng số liệu, đủ để server thấy client còn sống."""
+    return struct.pack(">BBHII", 0x81, 201, 7, ssrc, source_ssrc) + b"\0" * 20
+
+
+def collect_udp(sock, dep, until):
+    while time.monotonic() < until:
+        sock.settimeout(max(0.01, until - time.monotonic()))
+        try:
+            dep.push(sock.recv(65536))
+        except socket.timeout:
+            pass
+
+
+def wait_frames(dep, count, timeout, pump):
+    deadline = time.monotonic() + timeout
+    while len(dep.frames) < count and time.monotonic() < deadline:
+        pump(min(deadline, time.monotonic() + 0.2))
+    if len(dep.frames) < count:
+        raise CheckError("only %d/%d frames within %.0fs" % (len(dep.frames), count, timeout))
+
+
+def run(args):
+    rtsp = Rtsp(args.url, args.timeout)
+    _, body = rtsp.request("OPTIONS")
+    _, sdp = rtsp.request("DESCRIBE", headers={"Accept": "application/sdp"})
+    sdp = sdp.decode()
+    if "m=video 0 RTP/AVP %d" % RTP_PT_JPEG not in sdp:
+        raise CheckError("SDP has no JPEG video track:\n" + sdp)
+    control = "track1"
+    for line in sdp.splitlines():
+        if line.startswith("a=control:") and line[10:] != "*":
+            control = line[10:]
+    track = control if "://" in control else args.url.rstrip("/") + "/" + control
+
+    udp = None
+    if args.transport == "udp":
+        rtp_sock, rtcp_sock, port = udp_pair()
+        fields, _ = rtsp.request("SETUP", track, {"Transport": "RTP/AVP;unicast;client_port=%d-%d" % (port, port + 1)})
+        transport = fields.get("transport", "")
+        server = [p for p in transport.split(";") if p.startswith("server_port=")]
+        if not server:
+            raise CheckError("SETUP reply has no server_port: " + transport)
+        rtp_port, rtcp_port = (int(x) for x in server[0][12:].split("-"))
+        if rtcp_port != rtp_port + 1:
+            raise CheckError("server_port %d-%d is not an RTP/RTCP pair" % (rtp_port, rtcp_port))
+        udp = (rtp_sock, rtcp_sock, rtcp_port)
+    else:
+        fields, _ = rtsp.request("SETUP", track, {"Transport": "RTP/AVP/TCP;unicast;interleaved=0-1"})
+        transport = fields.get("transport", "")
+
+    ssrc = [p for p in transport.split(";") if p.startswith("ssrc=")]
+    dep = Depacketizer(int(ssrc[0][5:], 16) if ssrc else None)
+
+    if udp:
+        def pump(until):
+            collect_udp(udp[0], dep, until)
+    else:
+        def pump(until):
+            start = len(rtsp.rtp)
+            rtsp.read_interleaved(until)
+            for channel, pkt, _ in rtsp.rtp[start:]:
+                if channel == 0:
+                    dep.push(pkt)
+
+    report = {"transport": args.transport}
+    rtsp.request("PLAY", headers={"Range": "npt=0.000-"})
+    wait_frames(dep, args.frames, args.timeout, pump)
+
+    if udp:
+        # server_port + 1 phải bind: cổng đóng trả ICMP unreachable, socket
+        # connect() sẽ báo ECONNREFUSED ở lần send/recv kế tiếp
+        rtcp = udp[1]
+        rtcp.connect((rtsp.host, udp[2]))
+        try:
+            for _ in range(3):
+                rtcp.send(receiver_report(0x52545043, dep.ssrc or 0))
+                time.sleep(0.1)
+            rtcp.setblocking(False)
+            try:
+                rtcp.recv(1500)
+            except BlockingIOError:
+                pass
+        except ConnectionRefusedError:
+            raise CheckError("RTCP port %d is not bound (ICMP port unreachable)" % udp[2])
+        report["rtcp_port"] = udp[2]
+
+    # PAUSE: sau grace không còn gói nào, PLAY lại thì frame tiếp tục
+    rtsp.request("PAUSE")
+    paused_at = len(dep.frames)
+    pump(time.monotonic() + PAUSE_GRACE_S)
+    before = dep.packets
+    pump(time.monotonic() + PAUSE_WATCH_S)
+    if dep.packets != before:
+        raise CheckError("%d RTP packets after PAUSE" % (dep.packets - before))
+    dep.seq = None          # RFC 2326: seq sau PLAY lấy từ RTP-Info, không cần liền
+    dep.parts = []
+    fields, _ = rtsp.request("PLAY")
+    wait_frames(dep, len(dep.frames) + args.frames, args.timeout, pump)
+    report["frames_before_pause"] = paused_at
+    report["rtp_info"] = fields.get("rtp-info", "")
+    rtsp.request("TEARDOWN")
+
+    stamps = [f[0] for f in dep.frames]
+    if len(set(stamps)) != len(stamps):
+        raise CheckError("duplicate RTP timestamps")
+    report["frames"] = len(dep.frames)
+    report["packets"] = dep.packets
+    report["size"] = "%dx%d" % dep.frames[0][1][2:4]
+    report["type"] = dep.frames[0][1][0]
+
+    if args.out:
+        os.makedirs(args.out, exist_ok=True)
+        for i, (_, meta, scan) in enumerate(dep.frames):
+            with open(os.path.join(args.out, "frame%04d.jpg" % i), "wb") as f:
+                f.write(build_jfif(meta, scan))
+
+    if args.source_dir:
+        sources = {}
+        for name in sorted(os.listdir(args.source_dir)):
+            if name.lower().endswith((".jpg", ".jpeg")):
+                with open(os.path.join(args.source_dir, name), "rb") as f:
+                    parts = jpeg_parts(f.read())
+                if parts:
+                    sources[parts[1]] = parts[0]
+        matched = 0
+        for ts, meta, scan in dep.frames:
+            if scan not in sources:
+                dep.error("frame ts %u: entropy data matches no source file" % ts)
+            elif sources[scan] != meta[5]:
+                dep.error("frame ts %u: qtables differ from source" % ts)
+            else:
+                matched += 1
+        report["source_matched"] = matched
+
+    if dep.errors:
+        raise CheckError("; ".join(dep.errors))
+    return report
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("url", help="rtsp://host:port/")
+    parser.add_argument("--transport", choices=("tcp", "udp"), default="tcp")
+    parser.add_argument("--frames", type=int, default=20, help="số frame nhận trước và sau PAUSE")
+    parser.add_argument("--timeout", type=float, default=15.0)
+    parser.add_argument("--out", help="thư mục ghi frame JFIF đã ráp")
+    parser.add_argument("--source-dir", help="thư mục JPEG nguồn để so từng byte")
+    args = parser.parse_args()
+
+    try:
+        report = run(args)
+    except (CheckError, OSError) as e:
+        print("FAIL: %s" % e, file=sys.stderr)
+        return 1
+    for key, value in report.items():
+        print("%s: %s" % (key, value))
+    print("OK")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
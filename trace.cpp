@@ -0,0 +1,104 @@
+#include "trace.h"
+#include <stdarg.h>
+
+// Chỉ số ghi được lấy bằng một atomic add nên hai core và ISR không cần khóa.
+// Dùng esp_timer thay cho CCOUNT: CCOUNT mỗi core chạy riêng và tràn sau
+// ~18s ở 240MHz, còn span như Blynk.connect hay gửi SMS dài hơn thế.
+
+static const char* const spanNames[TRACE_SPAN_COUNT] = {
+    "frame_cb",
+    "stream_write",
+    "http_handle_client",
+    "handle_security_system",
+    "mqtt_loop",
+    "blynk_run",
+    "audio_loop",
+    "sms_send",
+};
+
+static trace_event_t* ring = nullptr;
+static uint32_t ringHead = 0;
+static volatile bool traceEnabled = false;
+
+typedef struct {
+    void (*emit)(const char* chunk);
+    char buf[1536];
+    size_t len;
+} json_out_t;
+
+// Mỗi mục JSON ngắn hơn 160 byte: đẩy buffer ra trước khi có thể tràn
+static void appendJson(json_out_t* out, const char* fmt, ...) {
+    if (out->len > sizeof(out->buf) - 160) {
+        out->emit(out->buf);
+        out->len = 0;
+    }
+    va_list args;
+    va_start(args, fmt);
+    out->len += vsnprintf(out->buf + out->len, sizeof(out->buf) - out->len, fmt, args);
+    va_end(args);
+}
+
+bool initializeTrace() {
+    ring = (trace_event_t*)heap_caps_malloc(TRACE_RING_EVENTS * sizeof(trace_event_t), MALLOC_CAP_SPIRAM);
+    if (!ring) return false;
+    memset(ring, 0, TRACE_RING_EVENTS * sizeof(trace_event_t));
+    traceEnabled = true;
+    return true;
+}
+
+void traceRecord(trace_span_t span, uint32_t start) {
+    if (!traceEnabled) return;
+
+    uint32_t end = (uint32_t)esp_timer_get_time();
+    uint32_t n = __atomic_fetch_add(&ringHead, 1, __ATOMIC_RELAXED);
+    trace_event_t& ev = ring[n & (TRACE_RING_EVENTS - 1)];
+    ev.start = start;
+    ev.dur = end - start;
+    ev.span = span;
+    ev.core = xPortGetCoreID();
+}
+
+void renderTraceJson(void (*emit)(const char* chunk)) {
+    if (!ring) {
+        emit("{\"traceEvents\":[]}");
+        return;
+    }
+
+    traceEnabled = false;
+    // span đang ghi dở khi vừa tắt sẽ xong trong vài us
+    vTaskDelay(pdMS_TO_TICKS(1));
+
+    uint32_t head = __atomic_load_n(&ringHead, __ATOMIC_RELAXED);
+    uint32_t count = head < TRACE_RING_EVENTS ? head : TRACE_RING_EVENTS;
+    uint32_t first = head - count;
+
+    // ts tương đối so với sự kiện cũ nhất để không bị ảnh hưởng khi esp_timer 32 bit tràn
+    uint32_t base = count ? ring[first & (TRACE_RING_EVENTS - 1)].start : 0;
+    for (uint32_t n = first; n != head; n++) {
+        uint32_t start = ring[n & (TRACE_RING_EVENTS - 1)].start;
+        if ((int32_t)(start - base) < 0) base = start;
+    }
+
+    // mỗi core là một process, mỗi loại span một thread để span lồng nhau
+    // giữa các task trên cùng core không chồng lên nhau
+    json_out_t out = {emit, {0}, 0};
+    appendJson(&out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        appendJson(&out, "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"core %d\"}}",
+                   core ? "," : "", core, core);
+        for (int s = 0; s < TRACE_SPAN_COUNT; s++) {
+            appendJson(&out, ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                       core, s, spanNames[s]);
+        }
+    }
+
+    for (uint32_t n = first; n != head; n++) {
+        const trace_event_t& ev = ring[n & (TRACE_RING_EVENTS - 1)];
+        appendJson(&out, ",{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%u,\"dur\":%u,\"pid\":%u,\"tid\":%u}",
+                   spanNames[ev.span], ev.start - base, ev.dur, ev.core, ev.span);
+    }
+    appendJson(&out, "]}");
+    out.emit(out.buf);
+
+    traceEnabled = true;
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "config.h"
+#include "esp_timer.h"
+
+// Ring trace cố định trong PSRAM: mỗi span ghi một sự kiện (bắt đầu, độ dài,
+// core) khi kết thúc. Ring ghi đè sự kiện cũ nhất nên luôn có thể bật.
+
+typedef enum {
+    TRACE_FRAME_CB,
+    TRACE_STREAM_WRITE,
+    TRACE_HTTP,
+    TRACE_SECURITY,
+    TRACE_MQTT,
+    TRACE_BLYNK,
+    TRACE_AUDIO,
+    TRACE_SMS,
+    TRACE_SPAN_COUNT
+} trace_span_t;
+
+typedef struct {
+    uint32_t start;     // us theo esp_timer, chung cho cả hai core
+    uint32_t dur;       // us
+    uint8_t span;
+    uint8_t core;
+} trace_event_t;
+
+bool initializeTrace();
+void traceRecord(trace_span_t span, uint32_t start);
+
+// Xuất ring dạng Chrome trace-event JSON (mở bằng Perfetto / chrome://tracing),
+// emit nhận từng đoạn text. Ghi trace tạm dừng trong lúc xuất.
+void renderTraceJson(void (*emit)(const char* chunk));
+
+// Ghi span từ lúc khởi tạo tới khi ra khỏi scope
+class TraceSpan {
+public:
+    explicit TraceSpan(trace_span_t span) : _span(span), _start((uint32_t)esp_timer_get_time()) {}
+    ~TraceSpan() { traceRecord(_span, _start); }
+
+private:
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    trace_span_t _span;
+    uint32_t _start;
+};
+
+#endif
\ No newline at end of file
@@ -2,80 +2,398 @@
 #include "web_server.h"
 #include "config.h"
 #include "camera_handler.h"
+#include "audio_handler.h"
+#include "substream.h"
+#include "rtsp_server.h"
+#include "ws_stream.h"
+#include "metrics.h"
+#include "trace.h"
+#include <uri/UriBraces.h>
+#include <lwip/sockets.h>
 
 WebServer server(80);
 bool serverRunning = false;
 bool apAdminLoggedIn = false;
 
 QueueHandle_t clientQueue = NULL;
-TaskHandle_t streamTaskHandle[MAX_CLIENTS] = {NULL, NULL, NULL};
+TaskHandle_t streamTaskHandle = NULL;
 
+static volatile bool streamTaskRunning = false;
+
+static const char partTrailer[] = "\r\n";
+
+static stream_stats_t streamStats[MAX_CLIENTS];
+static portMUX_TYPE statsMux = portMUX_INITIALIZER_UNLOCKED;
+
+static void updateStreamStats(int index, const stream_client_t* sc) {
+    uint16_t p50 = 0, p95 = 0, p99 = 0;
+    uint32_t bytesPerSec = 0;
+    if (sc) {
+        p50 = streamLatencyPercentile(&sc->latency, 50);
+        p95 = streamLatencyPercentile(&sc->latency, 95);
+        p99 = streamLatencyPercentile(&sc->latency, 99);
+        unsigned long elapsed = millis() - sc->connectedAt;
+        bytesPerSec = elapsed ? (uint32_t)(sc->bytesSent * 1000 / elapsed) : 0;
+    }
+
+    portENTER_CRITICAL(&statsMux);
+    stream_stats_t& st = streamStats[index];
+    st.active = (sc != nullptr);
+    if (sc) {
+        st.ip = sc->remoteIp;
+        st.sub = (sc->pool == &subFramePool);
+        st.websocket = sc->websocket;
+        st.profile = sc->profile;
+        st.frameInterval = sc->frameInterval;
+        st.abrInterval = sc->abrInterval;
+        st.rateBps = sc->rateBps;
+        st.avgFrameBytes = sc->avgFrameBytes;
+        st.framesSent = sc->framesSent;
+        st.framesSkipped = sc->framesSkipped;
+        st.bytesSent = sc->bytesSent;
+        st.bytesPerSec = bytesPerSec;
+        st.avgFrameGap = sc->latency.avgFrameGap;
+        st.stalls = sc->latency.stalls;
+        st.ageP50 = p50;
+        st.ageP95 = p95;
+        st.ageP99 = p99;
+    }
+    portEXIT_CRITICAL(&statsMux);
+}
+
+// Ước lượng throughput của client từ part vừa gửi xong và chọn khoảng cách
+// frame sao cho socket không bị dồn: frame mới luôn thay frame cũ thay vì xếp hàng
+static void updateClientRate(stream_client_t* sc, size_t partBytes) {
+    unsigned long elapsed = millis() - sc->partStart;
+    if (elapsed == 0) elapsed = 1;
+
+    uint32_t rate = (uint32_t)((uint64_t)partBytes * 1000 / elapsed);
+    sc->rateBps = sc->rateBps ? (sc->rateBps * 3 + rate) / 4 : rate;
+    sc->avgFrameBytes = sc->avgFrameBytes ? (sc->avgFrameBytes * 3 + partBytes) / 4 : partBytes;
+
+    uint64_t usable = (uint64_t)sc->rateBps * STREAM_ABR_HEADROOM_PCT / 100;
+    unsigned long interval = usable ? (unsigned long)((uint64_t)sc->avgFrameBytes * 1000 / usable) : STREAM_ABR_MAX_INTERVAL;
+    sc->abrInterval = min(interval, (unsigned long)STREAM_ABR_MAX_INTERVAL);
+}
+
+// Chuẩn bị part mới cho client: giữ ref frame mới nhất và format header vào
+// buffer của client, sau đó part được gửi dần khi socket writable.
+// frameDue = false (chưa tới lượt theo FPS) thì client WebSocket chỉ gửi sự kiện.
+static bool beginFramePart(stream_client_t* sc, bool frameDue) {
+    bool haveFrame = frameDue && (!sc->websocket || (!sc->wsClosing && wsCanSend(sc))) &&
+                     sc->pool->acquireLatest(sc->frame, sc->lastSeq);
+    bool haveEvents = sc->websocket && sc->wsEventsLen > 0;
+    if (!haveFrame && !haveEvents) return false;
+
+    if (haveFrame) {
+        if (sc->lastSeq != 0) sc->framesSkipped += sc->frame.seq - sc->lastSeq - 1;
+        sc->lastSeq = sc->frame.seq;
+    }
+
+    if (sc->websocket) {
+        // sự kiện đi trước frame, cùng một writev
+        memcpy(sc->header, sc->wsEvents, sc->wsEventsLen);
+        sc->headerLen = sc->wsEventsLen;
+        sc->wsEventsLen = 0;
+
+        if (haveFrame) {
+            uint8_t* h = (uint8_t*)sc->header + sc->headerLen;
+            size_t n = wsFrameHeader(h, WS_OP_BINARY, WS_APP_HEADER_SIZE + sc->frame.len);
+            n += wsAppHeader(h + n, sc->frame);
+            sc->headerLen += n;
+        }
+    } else {
+        sc->headerLen = snprintf(sc->header, sizeof(sc->header),
+                                 "--frame\r\nContent-Type: image/jpeg\r\nContent-Length: %u\r\n\r\n",
+                                 (unsigned)sc->frame.len);
+    }
+
+    sc->partActive = true;
+    sc->offset = 0;
+    sc->partStart = millis();
+    sc->lastProgress = sc->partStart;
+    return true;
+}
+
+// Ghi phần còn lại của part (header + JPEG + CRLF) bằng một writev non-blocking.
+// Trả về false nếu socket lỗi.
+static bool continueFramePart(stream_client_t* sc) {
+    size_t trailerLen = sc->websocket ? 0 : sizeof(partTrailer) - 1;
+    size_t lens[3] = { sc->headerLen, sc->frame.len, trailerLen };
+    const uint8_t* bases[3] = { (const uint8_t*)sc->header, sc->frame.data, (const uint8_t*)partTrailer };
+
+    struct iovec iov[3];
+    int cnt = 0;
+    size_t skip = sc->offset;
+    for (int i = 0; i < 3; i++) {
+        if (skip >= lens[i]) {
+            skip -= lens[i];
+            continue;
+        }
+        iov[cnt].iov_base = (void*)(bases[i] + skip);
+        iov[cnt].iov_len = lens[i] - skip;
+        skip = 0;
+        cnt++;
+    }
+
+    ssize_t n;
+    {
+        TraceSpan span(TRACE_STREAM_WRITE);
+        n = lwip_writev(sc->client.fd(), iov, cnt);
+    }
+    if (n < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+
+    sc->offset += n;
+    sc->bytesSent += n;
+    sc->lastProgress = millis();
+
+    if (sc->offset == lens[0] + lens[1] + lens[2]) {
+        sc->partActive = false;
+        if (!sc->frame.slot) return true;
+
+        unsigned long done = millis();
+        streamLatencyRecordAge(&sc->latency, done - sc->frame.timestamp);
+        metricObserveUs(MET_HIST_STREAM_SEND, (done - sc->partStart) * 1000);
+        if (sc->framesSent > 0) {
+            streamLatencyRecordGap(&sc->latency, done - sc->lastFrameTime);
+        }
+
+        if (sc->websocket) wsFrameSent(sc, sc->frame.seq);
+        sc->pool->release(sc->frame);
+        updateClientRate(sc, sc->offset);
+        sc->framesSent++;
+        sc->lastFrameTime = done;
+        metricInc(MET_FRAMES_SENT);
+    }
+    return true;
+}
+
+static void closeStreamClient(stream_client_t* sc) {
+    Serial.printf("[STREAM] Client %s disconnected (sent=%u skipped=%u bytes=%llu)\n",
+                  sc->client.remoteIP().toString().c_str(), sc->framesSent,
+                  sc->framesSkipped, (unsigned long long)sc->bytesSent);
+    sc->pool->release(sc->frame);
+    sc->client.stop();
+    releaseStreamClient(sc);
+}
+
+// Trả camera/profile/substream mà client giữ và giải phóng client
+void releaseStreamClient(stream_client_t* sc) {
+    if (sc->pool == &subFramePool) {
+        substreamRelease();
+    } else {
+        cameraReleaseProfile(sc->profile);
+        cameraRelease();
+    }
+    delete sc;
+}
+
+// Một task duy nhất phục vụ mọi client /stream: socket non-blocking + select(),
+// mỗi client gửi tiếp phần còn dở của part khi socket writable
 void stream_task(void *pvParameters) {
-    stream_client_t* streamClient = (stream_client_t*)pvParameters;
-    
-    // ✅ DÙNG REFERENCE THAY VÌ COPY
-    WiFiClient& client = streamClient->client;  // ← Thêm dấu "&"
-    
-    Serial.printf("[TASK] Streaming client %s\n", client.remoteIP().toString().c_str());
-
-    unsigned long lastFrameTime = 0;
-    const unsigned long frameInterval = 66;
-
-    while (streamClient->active && client.connected()) {
-        if (millis() - lastFrameTime >= frameInterval) {
-            uint8_t* frameBuffer = nullptr;
-            size_t frameLen = 0;
-
-            portENTER_CRITICAL(&frameMux);
-            if (frame_ready_a && use_buf_a) {
-                frameBuffer = mjpeg_buf_a;
-                frameLen = frame_len_a;
-                frame_ready_a = false;
-                use_buf_a = false;
-            } else if (frame_ready_b && !use_buf_a) {
-                frameBuffer = mjpeg_buf_b;
-                frameLen = frame_len_b;
-                frame_ready_b = false;
-                use_buf_a = true;
+    stream_client_t* clients[MAX_CLIENTS] = {};
+
+    while (streamTaskRunning) {
+        stream_client_t* incoming;
+        while (clientQueue != NULL && xQueueReceive(clientQueue, &incoming, 0) == pdTRUE) {
+            int slot = -1;
+            for (int i = 0; i < MAX_CLIENTS; i++) {
+                if (clients[i] == nullptr) {
+                    slot = i;
+                    break;
+                }
+            }
+
+            if (slot == -1) {
+                Serial.println("[STREAM] Max clients reached, rejecting");
+                metricInc(MET_STREAM_CLIENTS_REJECTED);
+                incoming->client.stop();
+                releaseStreamClient(incoming);
+                continue;
+            }
+
+            int fd = incoming->client.fd();
+            lwip_fcntl(fd, F_SETFL, lwip_fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+            clients[slot] = incoming;
+            updateStreamStats(slot, incoming);
+            Serial.printf("[STREAM] Client %s added (slot %d)\n",
+                          incoming->client.remoteIP().toString().c_str(), slot);
+        }
+
+        wsDispatchEvents(clients, MAX_CLIENTS);
+
+        fd_set writeSet;
+        FD_ZERO(&writeSet);
+        int maxFd = -1;
+        unsigned long now = millis();
+        unsigned long waitMs = 100;
+
+        for (int i = 0; i < MAX_CLIENTS; i++) {
+            stream_client_t* sc = clients[i];
+            if (!sc) continue;
+
+            if (sc->websocket && !wsPollClient(sc)) {
+                closeStreamClient(sc);
+                clients[i] = nullptr;
+                updateStreamStats(i, nullptr);
+                continue;
             }
-            portEXIT_CRITICAL(&frameMux);
-
-            if (frameBuffer && frameLen > 0) {
-                String boundary = "--frame\r\n";
-                boundary += "Content-Type: image/jpeg\r\n";
-                boundary += "Content-Length: " + String(frameLen) + "\r\n\r\n";
-                client.print(boundary);
-                client.write(frameBuffer, frameLen);
-                client.print("\r\n");
-                lastFrameTime = millis();
+
+            if (!sc->partActive) {
+                // close đáp lại đã gửi hết (hoặc client đã ngắt): đóng TCP
+                if (!sc->client.connected() || (sc->wsClosing && sc->wsEventsLen == 0)) {
+                    closeStreamClient(sc);
+                    clients[i] = nullptr;
+                    updateStreamStats(i, nullptr);
+                    continue;
+                }
+
+                // giới hạn FPS riêng cho từng client: ?fps= hoặc mức link của client theo kịp
+                unsigned long interval = max(sc->frameInterval, sc->abrInterval);
+                unsigned long elapsed = now - sc->lastFrameTime;
+                bool frameDue = (interval == 0 || elapsed >= interval);
+                if (!frameDue) waitMs = min(waitMs, interval - elapsed);
+
+                // luôn nhảy tới frame mới nhất, frame publish trong lúc đang gửi bị bỏ qua
+                if (!beginFramePart(sc, frameDue)) {
+                    // frame sub được publish sau frame chính, wake-up của framePool đến sớm hơn
+                    if (frameDue && sc->pool != &framePool) waitMs = min(waitMs, (unsigned long)10);
+                    continue;
+                }
+            }
+
+            // client không nhận thêm byte nào quá lâu thì ngắt, không ảnh hưởng client khác
+            if (millis() - sc->lastProgress > STREAM_SEND_TIMEOUT_MS) {
+                Serial.printf("[STREAM] Client %s send timeout\n", sc->client.remoteIP().toString().c_str());
+                closeStreamClient(sc);
+                clients[i] = nullptr;
+                updateStreamStats(i, nullptr);
+                continue;
             }
+
+            int fd = sc->client.fd();
+            FD_SET(fd, &writeSet);
+            if (fd > maxFd) maxFd = fd;
+        }
+
+        if (maxFd < 0) {
+            // không client nào đang gửi dở: chờ frame_cb publish frame mới
+            uint32_t newest = framePool.latestSeq();
+            framePool.waitForFrame(newest, pdMS_TO_TICKS(waitMs));
+            continue;
         }
 
-        if (!client.connected()) break;
-        vTaskDelay(pdMS_TO_TICKS(100));
+        // vẫn kiểm tra lại định kỳ để client rảnh nhận được frame mới sớm
+        struct timeval tv;
+        tv.tv_sec = 0;
+        tv.tv_usec = min(waitMs, (unsigned long)10) * 1000;
+        if (lwip_select(maxFd + 1, NULL, &writeSet, NULL, &tv) <= 0) continue;
+
+        for (int i = 0; i < MAX_CLIENTS; i++) {
+            stream_client_t* sc = clients[i];
+            if (!sc || !sc->partActive || !FD_ISSET(sc->client.fd(), &writeSet)) continue;
+
+            if (!continueFramePart(sc)) {
+                closeStreamClient(sc);
+                clients[i] = nullptr;
+                updateStreamStats(i, nullptr);
+            } else if (!sc->partActive) {
+                updateStreamStats(i, sc);
+            }
+        }
     }
 
-    // ✅ CLEANUP AN TOÀN HƠN
-    Serial.printf("[TASK] Client %s disconnected, cleaning up\n", client.remoteIP().toString().c_str());
-    client.stop();
-    
-    // ✅ DÙNG CRITICAL SECTION KHI CẬP NHẬT ARRAY
-    portENTER_CRITICAL(&frameMux);
-    TaskHandle_t current = xTaskGetCurrentTaskHandle();
     for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (streamTaskHandle[i] == current) {
-            streamTaskHandle[i] = NULL;
-            break;
-        }
+        if (clients[i]) closeStreamClient(clients[i]);
+        updateStreamStats(i, nullptr);
     }
-    portEXIT_CRITICAL(&frameMux);
-    
-    delete streamClient;
+
+    streamTaskHandle = NULL;
     vTaskDelete(NULL);
 }
 
-void handle_stream() {
-    Serial.println("[STREAM] Client requesting stream");
+bool startStreamTask() {
+    if (streamTaskHandle != NULL) return true;
+
+    streamTaskRunning = true;
+    if (xTaskCreatePinnedToCore(stream_task, "StreamTask", 6144, NULL, 2, &streamTaskHandle, APP_CPU) != pdPASS) {
+        streamTaskRunning = false;
+        streamTaskHandle = NULL;
+        return false;
+    }
+    return true;
+}
+
+void stopStreamTask() {
+    if (streamTaskHandle == NULL) return;
+
+    // để task tự đóng client và trả frame về pool rồi mới thoát
+    streamTaskRunning = false;
+    for (int i = 0; i < 50 && streamTaskHandle != NULL; i++) {
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+}
+
+static stream_client_t* newStreamClient(WiFiClient& client, FramePool* pool, int profile) {
+    stream_client_t* streamClient = new stream_client_t;
+    streamClient->client = client;
+    streamClient->remoteIp = client.remoteIP();
+    streamClient->frameInterval = 0;
+    streamClient->profile = profile;
+    streamClient->pool = pool;
+    streamClient->websocket = false;
+    streamClient->partActive = false;
+    streamClient->lastSeq = 0;
+    streamClient->lastFrameTime = 0;
+    streamClient->lastProgress = millis();
+    streamClient->headerLen = 0;
+    streamClient->offset = 0;
+    streamClient->framesSent = 0;
+    streamClient->framesSkipped = 0;
+    streamClient->bytesSent = 0;
+    streamClient->partStart = 0;
+    streamClient->rateBps = 0;
+    streamClient->avgFrameBytes = 0;
+    streamClient->abrInterval = 0;
+    streamClient->connectedAt = millis();
+    streamLatencyInit(&streamClient->latency, STREAM_STALL_MS);
+    memset(streamClient->wsSent, 0, sizeof(streamClient->wsSent));
+    streamClient->wsSentHead = 0;
+    streamClient->wsAckSeq = 0;
+    streamClient->wsLastAck = millis();
+    streamClient->wsRxLen = 0;
+    streamClient->wsEventsLen = 0;
+    streamClient->wsClosing = false;
+
+    int fps = server.arg("fps").toInt();
+    if (fps > 0) {
+        if (fps > STREAM_MAX_FPS) fps = STREAM_MAX_FPS;
+        streamClient->frameInterval = 1000 / fps;
+    }
+    return streamClient;
+}
+
+// Giữ camera (và profile yêu cầu) rồi giao client cho stream_task
+static void queueStreamClient(stream_client_t* streamClient) {
+    if (streamClient->pool == &subFramePool) {
+        substreamAcquire();
+    } else {
+        cameraRequestProfile(streamClient->profile);
+        cameraAcquire();
+    }
+
+    if (clientQueue == NULL || xQueueSend(clientQueue, &streamClient, 0) != pdTRUE) {
+        Serial.println("[STREAM] Client queue full, rejecting");
+        metricInc(MET_STREAM_QUEUE_REJECTED);
+        streamClient->client.stop();
+        releaseStreamClient(streamClient);
+    }
+}
+
+// Gửi header multipart và giao client cho stream_task
+static void acceptStreamClient(FramePool* pool, int profile) {
     start_stream_if_needed();
 
     WiFiClient client = server.client();
@@ -92,18 +410,410 @@ void handle_stream() {
     client.println("Expires: 0");
     client.println("Connection: keep-alive");
     client.println();
+    // part được gửi trọn bằng writev, không cần Nagle gom gói
+    client.setNoDelay(true);
 
-    stream_client_t* streamClient = new stream_client_t;
-    streamClient->client = client;
-    streamClient->active = true;
+    queueStreamClient(newStreamClient(client, pool, profile));
+}
+
+void handle_stream() {
+    Serial.println("[STREAM] Client requesting stream");
 
-    if (clientQueue != NULL) {
-        if (xQueueSend(clientQueue, &streamClient, 0) != pdTRUE) {
-            Serial.println("[STREAM] Max clients reached, rejecting");
-            client.stop();
-            delete streamClient;
+    int profile = -1;
+    if (server.hasArg("profile")) {
+        profile = findCameraProfile(server.arg("profile").c_str());
+        if (profile < 0) {
+            server.send(400, "text/plain", "Unknown profile");
+            return;
         }
     }
+
+    acceptStreamClient(&framePool, profile);
+}
+
+// Substream nhỏ cho lưới nhiều camera, dùng chung stream_task với /stream
+void handle_stream_sub() {
+    Serial.println("[STREAM] Client requesting substream");
+    acceptStreamClient(&subFramePool, -1);
+}
+
+// Dashboard: frame JPEG dạng message binary + sự kiện cảm biến trên cùng socket
+void handle_ws_stream() {
+    // chỉ hỗ trợ RFC 6455: version khác thì báo version server nhận (§4.4)
+    if (!server.header("Upgrade").equalsIgnoreCase("websocket") || !server.hasHeader("Sec-WebSocket-Key") ||
+        server.header("Sec-WebSocket-Version") != "13") {
+        server.sendHeader("Sec-WebSocket-Version", "13");
+        server.send(426, "text/plain", "WebSocket version 13 upgrade required");
+        return;
+    }
+
+    Serial.println("[STREAM] WebSocket client connecting");
+    start_stream_if_needed();
+
+    WiFiClient client = server.client();
+    if (!client.connected() || !wsHandshake(client, server.header("Sec-WebSocket-Key"))) {
+        client.stop();
+        return;
+    }
+    client.setNoDelay(true);
+
+    stream_client_t* streamClient = newStreamClient(client, &framePool, -1);
+    streamClient->websocket = true;
+    wsQueueStatus(streamClient);
+    queueStreamClient(streamClient);
+}
+
+// Chi phí decode + encode lại của substream
+void handle_substream_stats() {
+    substream_stats_t s;
+    substreamStats(&s);
+
+    char json[256];
+    snprintf(json, sizeof(json),
+             "{\"width\":%u,\"height\":%u,\"frames\":%u,\"dropped\":%u,\"decode_us\":%u,"
+             "\"encode_us\":%u,\"max_us\":%u,\"frame_bytes\":%u,\"max_fps\":%u}",
+             s.width, s.height, s.frames, s.dropped, s.decodeUs, s.encodeUs, s.maxUs,
+             s.avgBytes, (unsigned)SUB_STREAM_MAX_FPS);
+    server.send(200, "application/json", json);
+}
+
+// Trả frame mới nhất trong pool, không chiếm slot stream và không chặn frame_cb.
+// ETag là boot id + seq của frame để client polling nhận 304 khi chưa có frame
+// mới; seq đếm lại từ đầu sau reboot nên một mình nó có thể trùng ETag cũ.
+void handle_snapshot() {
+    static uint32_t bootId = 0;
+    while (bootId == 0) bootId = esp_random();
+
+    // snapshot cũng là consumer: camera còn chạy thêm CAMERA_IDLE_GRACE_MS cho lần poll sau
+    cameraAcquire();
+
+    FrameRef frame;
+    bool fresh = framePool.acquireLatest(frame) && millis() - frame.timestamp < SNAPSHOT_MAX_AGE_MS;
+
+    if (!fresh) {
+        framePool.release(frame);
+
+        // chưa có frame gần đây: chỉ chờ ngắn vì đang chặn loop(); UVC vừa bật
+        // thì trả 503 + Retry-After, camera vẫn chạy trong CAMERA_IDLE_GRACE_MS
+        uint32_t seq = framePool.latestSeq();
+        if (framePool.waitForFrame(seq, pdMS_TO_TICKS(SNAPSHOT_WAIT_MS))) {
+            framePool.acquireLatest(frame, seq);
+        }
+    }
+
+    if (!frame.slot) {
+        cameraRelease();
+        server.sendHeader("Retry-After", String(SNAPSHOT_RETRY_AFTER_S));
+        server.send(503, "text/plain", "Camera starting, retry");
+        return;
+    }
+
+    char etag[24];
+    snprintf(etag, sizeof(etag), "\"%08x-%u\"", bootId, frame.seq);
+
+    server.sendHeader("ETag", etag);
+    server.sendHeader("Cache-Control", "no-cache");
+    server.sendHeader("Access-Control-Allow-Origin", "*");
+
+    if (server.header("If-None-Match") == etag) {
+        framePool.release(frame);
+        cameraRelease();
+        server.send(304);
+        return;
+    }
+
+    server.setContentLength(frame.len);
+    server.send(200, "image/jpeg", "");
+    server.sendContent((const char*)frame.data, frame.len);
+    framePool.release(frame);
+    cameraRelease();
+}
+
+// Danh sách clip trên thẻ SD, gửi từng entry thay vì ghép cả JSON vào String
+void handle_event_list() {
+    if (!sdCardMounted) {
+        server.send(503, "application/json", "[]");
+        return;
+    }
+
+    File dir = SD.open("/events");
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "application/json", "");
+    server.sendContent("[");
+
+    bool first = true;
+    if (dir && dir.isDirectory()) {
+        File entry = dir.openNextFile();
+        while (entry) {
+            if (!entry.isDirectory()) {
+                char item[96];
+                snprintf(item, sizeof(item), "%s{\"name\":\"%s\",\"size\":%u}",
+                         first ? "" : ",", entry.name(), (unsigned)entry.size());
+                server.sendContent(item);
+                first = false;
+            }
+            entry.close();
+            entry = dir.openNextFile();
+        }
+    }
+    dir.close();
+
+    server.sendContent("]");
+    server.sendContent("");
+}
+
+// Throughput và quyết định FPS của từng client /stream
+void handle_stream_stats() {
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "application/json", "");
+    server.sendContent("[");
+
+    bool first = true;
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        portENTER_CRITICAL(&statsMux);
+        stream_stats_t st = streamStats[i];
+        portEXIT_CRITICAL(&statsMux);
+        if (!st.active) continue;
+
+        unsigned long interval = max(st.frameInterval, st.abrInterval);
+        char item[448];
+        snprintf(item, sizeof(item),
+                 "%s{\"slot\":%d,\"ip\":\"%s\",\"stream\":\"%s\",\"profile\":\"%s\",\"rate_kbps\":%u,\"frame_bytes\":%u,"
+                 "\"fps_limit\":%u,\"abr_fps\":%u,\"abr_limited\":%s,\"sent\":%u,\"skipped\":%u,\"bytes\":%llu,"
+                 "\"fps\":%.1f,\"bytes_per_sec\":%u,\"age_p50_ms\":%u,\"age_p95_ms\":%u,\"age_p99_ms\":%u,\"stalls\":%u}",
+                 first ? "" : ",", i, IPAddress(st.ip).toString().c_str(), st.websocket ? "ws" : (st.sub ? "sub" : "main"),
+                 st.profile >= 0 ? cameraProfiles[st.profile].name : "auto",
+                 st.rateBps * 8 / 1000, st.avgFrameBytes,
+                 st.frameInterval ? (unsigned)(1000 / st.frameInterval) : 0,
+                 interval ? (unsigned)(1000 / interval) : 0,
+                 st.abrInterval > st.frameInterval ? "true" : "false",
+                 st.framesSent, st.framesSkipped, (unsigned long long)st.bytesSent,
+                 st.avgFrameGap ? 1000.0f / st.avgFrameGap : 0.0f, st.bytesPerSec,
+                 st.ageP50, st.ageP95, st.ageP99, st.stalls);
+        server.sendContent(item);
+        first = false;
+    }
+
+    server.sendContent("]");
+    server.sendContent("");
+}
+
+// Bộ đếm pipeline dạng Prometheus text để scrape
+void handle_metrics() {
+    String out;
+    out.reserve(4096);
+    renderMetrics(out);
+    server.send(200, "text/plain; version=0.0.4", out);
+}
+
+static void sendTraceChunk(const char* chunk) {
+    server.sendContent(chunk);
+}
+
+// Ring trace span dạng Chrome trace-event JSON, mở bằng ui.perfetto.dev
+void handle_trace() {
+    server.sendHeader("Content-Disposition", "attachment; filename=\"trace.json\"");
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "application/json", "");
+    renderTraceJson(sendTraceChunk);
+    server.sendContent("");
+}
+
+// GET: danh sách profile + profile đang chạy. ?name= (GET/POST) đổi profile
+// mặc định; profile thật sự áp dụng ở handleCameraLoop.
+void handle_camera_profile() {
+    if (server.hasArg("name")) {
+        if (!setCameraProfile(findCameraProfile(server.arg("name").c_str()))) {
+            server.send(400, "text/plain", "Unknown profile");
+            return;
+        }
+    }
+
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "application/json", "");
+
+    char item[160];
+    snprintf(item, sizeof(item), "{\"active\":\"%s\",\"configured\":\"%s\",\"buffer\":%u,\"profiles\":[",
+             cameraProfiles[activeCameraProfile()].name,
+             cameraProfiles[configuredCameraProfile()].name, (unsigned)MJPEG_BUF_SIZE);
+    server.sendContent(item);
+
+    for (int i = 0; i < cameraProfileCount; i++) {
+        const camera_profile_t& p = cameraProfiles[i];
+        snprintf(item, sizeof(item), "%s{\"name\":\"%s\",\"width\":%u,\"height\":%u,\"fps\":%u,\"peak_bytes\":%u}",
+                 i ? "," : "", p.name, p.width, p.height,
+                 (unsigned)(10000000 / p.interval), cameraProfilePeakBytes(i));
+        server.sendContent(item);
+    }
+
+    server.sendContent("]}");
+    server.sendContent("");
+}
+
+typedef struct {
+    WiFiClient client;
+    File file;
+    size_t remaining;
+} event_download_t;
+
+static int activeDownloads = 0;
+static portMUX_TYPE downloadMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Đọc SD theo chunk cố định và ghi thẳng vào socket, chạy ngoài loop()
+static void eventDownloadTask(void* pvParameters) {
+    event_download_t* dl = (event_download_t*)pvParameters;
+    uint8_t* chunk = (uint8_t*)malloc(EVENT_DOWNLOAD_CHUNK);
+
+    while (chunk && dl->remaining > 0 && dl->client.connected()) {
+        size_t n = dl->file.read(chunk, min(dl->remaining, (size_t)EVENT_DOWNLOAD_CHUNK));
+        if (n == 0) break;
+        if (dl->client.write(chunk, n) != n) break;
+        dl->remaining -= n;
+    }
+
+    free(chunk);
+    dl->file.close();
+    dl->client.stop();
+    delete dl;
+
+    portENTER_CRITICAL(&downloadMux);
+    activeDownloads--;
+    portEXIT_CRITICAL(&downloadMux);
+    vTaskDelete(NULL);
+}
+
+static bool validEventName(const String& name) {
+    if (name.length() == 0 || name.length() > 32 || !name.endsWith(".avi")) return false;
+    for (unsigned i = 0; i < name.length(); i++) {
+        char c = name[i];
+        if (!isalnum((unsigned char)c) && c != '_' && c != '-' && c != '.') return false;
+    }
+    return name.indexOf("..") < 0;
+}
+
+// Số thập phân không dấu chiếm trọn chuỗi, false nếu rỗng hoặc có ký tự lạ
+static bool parseRangeNumber(const String& s, size_t* out) {
+    if (s.length() == 0) return false;
+    char* endp;
+    unsigned long v = strtoul(s.c_str(), &endp, 10);
+    if (*endp != '\0' || s[0] < '0' || s[0] > '9') return false;
+    *out = v;
+    return true;
+}
+
+// Tải clip với hỗ trợ Range (bytes=a-b, a-, -n) để trình phát tua được.
+// Nhiều khoảng (bytes=0-1,5-9) cần multipart/byteranges: bỏ qua Range và
+// trả 200 cả file, như RFC 7233 cho phép.
+void handle_event_file() {
+    String name = server.pathArg(0);
+    if (!sdCardMounted || !validEventName(name)) {
+        server.send(404, "text/plain", "Not Found");
+        return;
+    }
+
+    File file = SD.open("/events/" + name, FILE_READ);
+    if (!file || file.isDirectory()) {
+        server.send(404, "text/plain", "Not Found");
+        return;
+    }
+
+    size_t size = file.size();
+    size_t start = 0;
+    size_t end = size - 1;
+    bool partial = false;
+
+    String range = server.header("Range");
+
+    // clip rỗng (recorder chết trước khi ghi header): không có byte nào để
+    // chọn nên Range nào cũng 416, không Range thì 200 với body rỗng
+    if (size == 0) {
+        file.close();
+        server.sendHeader("Accept-Ranges", "bytes");
+        if (range.length() > 0) {
+            server.sendHeader("Content-Range", "bytes */0");
+            server.send(416, "text/plain", "Range Not Satisfiable");
+        } else {
+            server.setContentLength(0);
+            server.send(200, "video/x-msvideo", "");
+        }
+        return;
+    }
+
+    if (range.startsWith("bytes=") && range.indexOf(',') < 0) {
+        String spec = range.substring(6);
+        spec.trim();
+        int dash = spec.indexOf('-');
+        String from = dash < 0 ? spec : spec.substring(0, dash);
+        String to = dash < 0 ? String() : spec.substring(dash + 1);
+        size_t first = 0, last = 0;
+        bool valid = dash >= 0;
+
+        if (valid && from.length() == 0) {
+            // -n: n byte cuối
+            valid = parseRangeNumber(to, &last) && last > 0;
+            if (valid) start = last < size ? size - last : 0;
+        } else if (valid) {
+            valid = parseRangeNumber(from, &first);
+            if (valid && to.length() > 0) {
+                valid = parseRangeNumber(to, &last) && last >= first;
+                if (valid) end = min(last, end);
+            }
+            start = first;
+        }
+
+        if (!valid || start > end || start >= size) {
+            file.close();
+            server.sendHeader("Content-Range", "bytes */" + String(size));
+            server.send(416, "text/plain", "Range Not Satisfiable");
+            return;
+        }
+        partial = true;
+    }
+
+    portENTER_CRITICAL(&downloadMux);
+    bool slotFree = activeDownloads < EVENT_DOWNLOAD_MAX;
+    if (slotFree) activeDownloads++;
+    portEXIT_CRITICAL(&downloadMux);
+
+    if (!slotFree) {
+        file.close();
+        server.sendHeader("Retry-After", "5");
+        server.send(503, "text/plain", "Too many downloads");
+        return;
+    }
+
+    size_t length = end - start + 1;
+    file.seek(start);
+
+    char header[256];
+    int headerLen;
+    if (partial) {
+        headerLen = snprintf(header, sizeof(header),
+                             "HTTP/1.1 206 Partial Content\r\nContent-Type: video/x-msvideo\r\n"
+                             "Accept-Ranges: bytes\r\nContent-Range: bytes %u-%u/%u\r\n"
+                             "Content-Length: %u\r\nConnection: close\r\n\r\n",
+                             (unsigned)start, (unsigned)end, (unsigned)size, (unsigned)length);
+    } else {
+        headerLen = snprintf(header, sizeof(header),
+                             "HTTP/1.1 200 OK\r\nContent-Type: video/x-msvideo\r\n"
+                             "Accept-Ranges: bytes\r\nContent-Length: %u\r\nConnection: close\r\n\r\n",
+                             (unsigned)length);
+    }
+
+    event_download_t* dl = new event_download_t;
+    dl->client = server.client();
+    dl->file = file;
+    dl->remaining = length;
+    dl->client.write((const uint8_t*)header, headerLen);
+
+    if (xTaskCreatePinnedToCore(eventDownloadTask, "EventDownload", 3072, dl, 1, NULL, PRO_CPU) != pdPASS) {
+        dl->file.close();
+        dl->client.stop();
+        delete dl;
+        portENTER_CRITICAL(&downloadMux);
+        activeDownloads--;
+        portEXIT_CRITICAL(&downloadMux);
+    }
 }
 
 void startMJPEGStreamingServer() {
@@ -112,23 +822,43 @@ void startMJPEGStreamingServer() {
         return;
     }
     
-    clientQueue = xQueueCreate(MAX_CLIENTS, sizeof(stream_client_t*));
+    if (clientQueue == NULL) {
+        clientQueue = xQueueCreate(MAX_CLIENTS, sizeof(stream_client_t*));
+    }
     if (clientQueue == NULL) {
         Serial.println("[SERVER] Failed to create client queue");
         return;
     }
     
+    const char* headerKeys[] = { "If-None-Match", "Range", "Upgrade", "Sec-WebSocket-Key", "Sec-WebSocket-Version" };
+    server.collectHeaders(headerKeys, 5);
+    initializeWsEvents();
+
     server.on("/stream", HTTP_GET, handle_stream);
+    server.on("/snapshot.jpg", HTTP_GET, handle_snapshot);
+    server.on("/events", HTTP_GET, handle_event_list);
+    server.on(UriBraces("/events/{}"), HTTP_GET, handle_event_file);
+    server.on("/stream/sub", HTTP_GET, handle_stream_sub);
+    server.on("/ws/stream", HTTP_GET, handle_ws_stream);
+    server.on("/stream/sub/stats", HTTP_GET, handle_substream_stats);
+    server.on("/stream/stats", HTTP_GET, handle_stream_stats);
+    server.on("/metrics", HTTP_GET, handle_metrics);
+    server.on("/trace", HTTP_GET, handle_trace);
+    server.on("/camera/profile", HTTP_GET, handle_camera_profile);
+    server.on("/camera/profile", HTTP_POST, handle_camera_profile);
     server.onNotFound([]() {
         server.send(404, "text/plain", "Not Found");
     });
     
     server.begin();
     serverRunning = true;
+    startRtspServer();
     
     Serial.println("[SERVER] MJPEG Streaming Server started");
     Serial.printf("[SERVER] Access: http://%s/\n", WiFi.localIP().toString().c_str());
     Serial.printf("[SERVER] Stream: http://%s/stream\n", WiFi.localIP().toString().c_str());
+    Serial.printf("[SERVER] Substream: http://%s/stream/sub\n", WiFi.localIP().toString().c_str());
+    Serial.printf("[SERVER] Snapshot: http://%s/snapshot.jpg\n", WiFi.localIP().toString().c_str());
 }
 
 void stopMJPEGStreamingServer() {
@@ -138,6 +868,8 @@ void stopMJPEGStreamingServer() {
     }
     serverRunning = false;
 
+    stopRtspServer();
+    stopStreamTask();
     if (clientQueue != nullptr) {
         vQueueDelete(clientQueue);
         clientQueue = nullptr;
@@ -969,6 +1701,7 @@ String getErrorPage(String message) {
 
 void handleWebServerLoop() {
     if (serverRunning) {
+        TraceSpan span(TRACE_HTTP);
         server.handleClient();
     }
 }
@@ -2,25 +2,101 @@
 #define WEB_SERVER_H
 
 #include "config.h"
+#include "frame_pool.h"
+#include "stream_latency.h"
 
 extern WebServer server;
 extern bool serverRunning;
 
 typedef struct {
     WiFiClient client;
-    bool active;
+    uint32_t remoteIp;
+    unsigned long frameInterval;   // ms giữa 2 frame, 0 = theo tốc độ camera
+    int profile;                   // profile yêu cầu qua ?profile=, -1 = không yêu cầu
+    FramePool* pool;               // framePool hoặc subFramePool (/stream/sub)
+    bool websocket;                // /ws/stream
+
+    // part đang gửi dở (header + JPEG + CRLF), part WebSocket có thể chỉ gồm sự kiện
+    bool partActive;
+    FrameRef frame;
+    char header[WS_EVENT_BUF + 32];
+    size_t headerLen;
+    size_t offset;
+    uint32_t lastSeq;
+    unsigned long lastFrameTime;
+    unsigned long lastProgress;
+
+    uint32_t framesSent;
+    uint32_t framesSkipped;
+    uint64_t bytesSent;
+
+    // adaptive bitrate: throughput đo từ lúc bắt đầu tới lúc gửi xong mỗi part
+    unsigned long partStart;
+    uint32_t rateBps;              // EWMA byte/giây
+    uint32_t avgFrameBytes;        // EWMA kích thước part
+    unsigned long abrInterval;     // ms giữa 2 frame mà link của client theo kịp
+
+    // đo độ trễ: tuổi frame khi gửi xong, FPS thực nhận, số lần đứng hình
+    unsigned long connectedAt;
+    stream_latency_t latency;
+
+    // WebSocket: ack từ browser và sự kiện chờ gửi
+    uint32_t wsSent[WS_MAX_INFLIGHT];
+    uint8_t wsSentHead;
+    uint32_t wsAckSeq;
+    unsigned long wsLastAck;
+    uint8_t wsRx[136];
+    size_t wsRxLen;
+    char wsEvents[WS_EVENT_BUF];
+    size_t wsEventsLen;
+    bool wsClosing;                // client đã gửi CLOSE, close đáp lại nằm trong wsEvents
 } stream_client_t;
 
+// Bản sao số liệu của từng client cho /stream/stats, stream_task cập nhật
+typedef struct {
+    bool active;
+    bool sub;
+    bool websocket;
+    uint32_t ip;
+    int profile;
+    unsigned long frameInterval;
+    unsigned long abrInterval;
+    uint32_t rateBps;
+    uint32_t avgFrameBytes;
+    uint32_t framesSent;
+    uint32_t framesSkipped;
+    uint64_t bytesSent;
+    uint32_t bytesPerSec;
+    uint32_t avgFrameGap;
+    uint32_t stalls;
+    uint16_t ageP50;
+    uint16_t ageP95;
+    uint16_t ageP99;
+} stream_stats_t;
+
 extern QueueHandle_t clientQueue;
-extern TaskHandle_t streamTaskHandle[MAX_CLIENTS];
+extern TaskHandle_t streamTaskHandle;
 
 extern void stream_task(void *pvParameters);
+bool startStreamTask();
+void stopStreamTask();
+void releaseStreamClient(stream_client_t* sc);
 
 void startMJPEGStreamingServer();
 void stopMJPEGStreamingServer();
 void handleWebServerLoop();
 
 void handle_stream();
+void handle_stream_sub();
+void handle_ws_stream();
+void handle_substream_stats();
+void handle_snapshot();
+void handle_event_list();
+void handle_event_file();
+void handle_camera_profile();
+void handle_stream_stats();
+void handle_metrics();
+void handle_trace();
 
 void startAPWebServer();
 
@@ -145,15 +145,8 @@ void handleSuccessfulConnection()
     startMJPEGStreamingServer();
     start_stream_if_needed();
     
-    extern bool servoInitialized;
-    if (!servoInitialized) 
-    {
-        initializeBlynk();
-    } 
-    else 
-    {
-        reconnectBlynk();
-    }
+    // NetTask khởi tạo Blynk (lần đầu) hoặc tự kết nối lại trong handleBlynkLoop
+    requestBlynkInit();
 
     extern bool wifiConnectionStarted;
     extern bool wifiResultProcessed;
@@ -0,0 +1,208 @@
+#include "ws_stream.h"
+#include "sensors_handler.h"
+#include "event_recorder.h"
+#include "security_system.h"
+#include <lwip/sockets.h>
+#include <mbedtls/sha1.h>
+#include <mbedtls/base64.h>
+
+#define WS_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+typedef struct {
+    char json[WS_EVENT_MAX];
+} ws_event_t;
+
+static QueueHandle_t wsEventQueue = NULL;
+static volatile int wsClientCount = 0;
+
+bool initializeWsEvents() {
+    if (wsEventQueue == NULL) {
+        wsEventQueue = xQueueCreate(WS_EVENT_QUEUE, sizeof(ws_event_t));
+    }
+    return wsEventQueue != NULL;
+}
+
+// Sec-WebSocket-Accept = base64(sha1(key + GUID)), RFC 6455
+bool wsHandshake(WiFiClient& client, const String& key) {
+    String source = key + WS_GUID;
+    unsigned char digest[20];
+    mbedtls_sha1((const unsigned char*)source.c_str(), source.length(), digest);
+
+    unsigned char accept[32];
+    size_t acceptLen = 0;
+    if (mbedtls_base64_encode(accept, sizeof(accept), &acceptLen, digest, sizeof(digest)) != 0) return false;
+    accept[acceptLen] = '\0';
+
+    client.printf("HTTP/1.1 101 Switching Protocols\r\n"
+                  "Upgrade: websocket\r\n"
+                  "Connection: Upgrade\r\n"
+                  "Sec-WebSocket-Accept: %s\r\n\r\n", accept);
+    return true;
+}
+
+size_t wsFrameHeader(uint8_t* out, uint8_t opcode, size_t len) {
+    out[0] = WS_FIN | opcode;   // server không mask
+    if (len < WS_LEN_16) {
+        out[1] = len;
+        return 2;
+    }
+    if (len < 65536) {
+        out[1] = WS_LEN_16;
+        out[2] = len >> 8;
+        out[3] = len & 0xFF;
+        return 4;
+    }
+    out[1] = WS_LEN_64;
+    for (int i = 0; i < 8; i++) {
+        out[2 + i] = (i < 4) ? 0 : (len >> ((7 - i) * 8)) & 0xFF;
+    }
+    return 10;
+}
+
+size_t wsAppHeader(uint8_t* out, const FrameRef& frame) {
+    uint32_t seq = frame.seq;
+    uint32_t ts = frame.timestamp;
+    for (int i = 0; i < 4; i++) {
+        out[i] = (seq >> (24 - i * 8)) & 0xFF;
+        out[4 + i] = (ts >> (24 - i * 8)) & 0xFF;
+    }
+    out[8] = (motionInProgress ? WS_FLAG_MOTION : 0) | (isEventRecording() ? WS_FLAG_RECORDING : 0);
+    return WS_APP_HEADER_SIZE;
+}
+
+static int unackedFrames(const stream_client_t* sc) {
+    int count = 0;
+    for (int i = 0; i < WS_MAX_INFLIGHT; i++) {
+        if (sc->wsSent[i] > sc->wsAckSeq) count++;
+    }
+    return count;
+}
+
+static void queueFrame(stream_client_t* sc, uint8_t opcode, const void* data, size_t len) {
+    // sau close không được gửi thêm frame nào
+    if (sc->wsClosing) return;
+    // buffer đầy (client chậm): bỏ frame, trạng thái mới sẽ đến sau
+    if (sc->wsEventsLen + 2 + len > sizeof(sc->wsEvents)) return;
+
+    sc->wsEventsLen += wsFrameHeader((uint8_t*)sc->wsEvents + sc->wsEventsLen, opcode, len);
+    memcpy(sc->wsEvents + sc->wsEventsLen, data, len);
+    sc->wsEventsLen += len;
+}
+
+// Message nhỏ từ browser (ack seq), frame luôn được mask
+static bool handleClientMessage(stream_client_t* sc, uint8_t opcode, const uint8_t* payload, size_t len) {
+    // RFC 6455 §5.5.1: đáp close với status code của client, bỏ sự kiện chưa
+    // gửi; stream_task đóng TCP khi close đã ra khỏi buffer
+    if (opcode == WS_OP_CLOSE) {
+        if (sc->wsClosing) return true;
+        sc->wsEventsLen = 0;
+        queueFrame(sc, WS_OP_CLOSE, payload, len >= 2 ? 2 : 0);
+        sc->wsClosing = true;
+        return true;
+    }
+
+    // control frame tối đa 125 byte, pong trả lại nguyên payload
+    if (opcode == WS_OP_PING) {
+        queueFrame(sc, WS_OP_PONG, payload, len);
+        return true;
+    }
+
+    if (opcode == WS_OP_TEXT || opcode == WS_OP_BINARY) {
+        char text[16];
+        size_t n = min(len, sizeof(text) - 1);
+        memcpy(text, payload, n);
+        text[n] = '\0';
+
+        uint32_t seq = strtoul(text, nullptr, 10);
+        if (seq > sc->wsAckSeq) sc->wsAckSeq = seq;
+        sc->wsLastAck = millis();
+    }
+    return true;
+}
+
+// Đọc non-blocking các message client gửi lên. Trả false khi client đóng.
+bool wsPollClient(stream_client_t* sc) {
+    ssize_t n = lwip_recv(sc->client.fd(), sc->wsRx + sc->wsRxLen, sizeof(sc->wsRx) - sc->wsRxLen, MSG_DONTWAIT);
+    if (n == 0) return false;
+    if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    sc->wsRxLen += n;
+
+    while (sc->wsRxLen >= 2) {
+        uint8_t opcode = sc->wsRx[0] & WS_OPCODE_MASK;
+        bool masked = sc->wsRx[1] & WS_MASKED;
+        size_t len = sc->wsRx[1] & WS_LEN_MASK;
+
+        // dashboard chỉ gửi ack ngắn, message lớn coi như lỗi giao thức
+        if (len >= WS_LEN_16 || !masked) return false;
+
+        size_t total = 2 + 4 + len;
+        if (sc->wsRxLen < total) break;
+
+        uint8_t* mask = sc->wsRx + 2;
+        uint8_t* payload = sc->wsRx + 6;
+        for (size_t i = 0; i < len; i++) payload[i] ^= mask[i & 3];
+
+        if (!handleClientMessage(sc, opcode, payload, len)) return false;
+
+        memmove(sc->wsRx, sc->wsRx + total, sc->wsRxLen - total);
+        sc->wsRxLen -= total;
+    }
+    return true;
+}
+
+// Browser chưa hiển thị xong thì không đẩy thêm frame. Ack mất (tab ẩn,
+// dashboard cũ không ack) thì sau WS_ACK_TIMEOUT_MS gửi tiếp.
+bool wsCanSend(stream_client_t* sc) {
+    if (unackedFrames(sc) < WS_MAX_INFLIGHT) return true;
+    if (millis() - sc->wsLastAck < WS_ACK_TIMEOUT_MS) return false;
+
+    sc->wsAckSeq = sc->lastSeq;
+    sc->wsLastAck = millis();
+    return true;
+}
+
+void wsFrameSent(stream_client_t* sc, uint32_t seq) {
+    if (unackedFrames(sc) == 0) sc->wsLastAck = millis();
+    sc->wsSent[sc->wsSentHead] = seq;
+    sc->wsSentHead = (sc->wsSentHead + 1) % WS_MAX_INFLIGHT;
+}
+
+static void queueEvent(stream_client_t* sc, const char* json, size_t len) {
+    queueFrame(sc, WS_OP_TEXT, json, len);
+}
+
+// Trạng thái hiện tại cho client vừa kết nối, trước khi có sự kiện mới
+void wsQueueStatus(stream_client_t* sc) {
+    char json[WS_EVENT_MAX];
+    int len = snprintf(json, sizeof(json), "{\"type\":\"status\",\"security\":%d,\"motion\":%s,\"dark\":%s}",
+                       (int)currentSecurityState, motionInProgress ? "true" : "false", isDark ? "true" : "false");
+    queueEvent(sc, json, len);
+}
+
+// Chép sự kiện trong queue vào buffer của từng client WebSocket, gửi kèm part kế tiếp
+void wsDispatchEvents(stream_client_t** clients, int count) {
+    int wsClients = 0;
+    for (int i = 0; i < count; i++) {
+        if (clients[i] && clients[i]->websocket) wsClients++;
+    }
+    wsClientCount = wsClients;
+
+    ws_event_t event;
+    while (wsEventQueue != NULL && xQueueReceive(wsEventQueue, &event, 0) == pdTRUE) {
+        size_t len = strlen(event.json);
+
+        for (int i = 0; i < count; i++) {
+            stream_client_t* sc = clients[i];
+            if (sc && sc->websocket) queueEvent(sc, event.json, len);
+        }
+    }
+}
+
+void wsPublishEvent(const char* json) {
+    if (wsEventQueue == NULL || wsClientCount == 0) return;
+
+    ws_event_t event;
+    strncpy(event.json, json, sizeof(event.json) - 1);
+    event.json[sizeof(event.json) - 1] = '\0';
+    xQueueSend(wsEventQueue, &event, 0);
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef WS_STREAM_H
+#define WS_STREAM_H
+
+#include "config.h"
+#include "web_server.h"
+
+// /ws/stream: mỗi frame là một message binary gồm header 9 byte
+// (seq u32, timestamp ms u32, flags u8 - big endian) + JPEG. Browser gửi lại
+// seq đã hiển thị (text thập phân) để server chỉ giữ WS_MAX_INFLIGHT frame
+// chưa ack. Sự kiện PIR/LDR/security đi trên cùng socket dưới dạng JSON text.
+
+#define WS_FRAME_HEADER_MAX 10
+#define WS_APP_HEADER_SIZE 9
+
+#define WS_FLAG_MOTION    0x01
+#define WS_FLAG_RECORDING 0x02
+
+// Header frame RFC 6455
+#define WS_FIN          0x80
+#define WS_OPCODE_MASK  0x0F
+#define WS_MASKED       0x80
+#define WS_LEN_MASK     0x7F
+#define WS_LEN_16       126
+#define WS_LEN_64       127
+
+#define WS_OP_TEXT   0x1
+#define WS_OP_BINARY 0x2
+#define WS_OP_CLOSE  0x8
+#define WS_OP_PING   0x9
+#define WS_OP_PONG   0xA
+
+bool wsHandshake(WiFiClient& client, const String& key);
+size_t wsFrameHeader(uint8_t* out, uint8_t opcode, size_t len);
+size_t wsAppHeader(uint8_t* out, const FrameRef& frame);
+
+// stream_task
+bool wsPollClient(stream_client_t* sc);
+bool wsCanSend(stream_client_t* sc);
+void wsFrameSent(stream_client_t* sc, uint32_t seq);
+void wsDispatchEvents(stream_client_t** clients, int count);
+void wsQueueStatus(stream_client_t* sc);
+
+// Gọi từ task bất kỳ, JSON tối đa WS_EVENT_MAX byte
+void wsPublishEvent(const char* json);
+bool initializeWsEvents();
+
+#endif
\ No newline at end of file